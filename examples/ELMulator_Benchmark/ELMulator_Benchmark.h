@@ -0,0 +1,94 @@
+#pragma once
+#include <Arduino.h>
+#include <ELMulator.h>
+#include <definitions.h>
+#if HAS_FS
+#include <LittleFS.h>
+#endif
+
+/**
+ * In memory Stream that plays a recorded client session (requests separated
+ * by '\r') and throws the responses away, counting their bytes.
+ */
+class ReplayStream : public Stream
+{
+public:
+    void load(const char *session)
+    {
+        this->session = session;
+        position = 0;
+        length = strlen(session);
+    }
+
+    void rewind() { position = 0; }
+
+    int available() override { return length - position; }
+    int read() override { return position < length ? session[position++] : -1; }
+    int peek() override { return position < length ? session[position] : -1; }
+    void flush() override {}
+
+    size_t write(uint8_t c) override
+    {
+        writes++;
+        bytesWritten++;
+        return 1;
+    }
+
+    size_t write(const uint8_t *buffer, size_t size) override
+    {
+        writes++;
+        bytesWritten += size;
+        return size;
+    }
+
+    // each write is a packet on a Bluetooth or TCP transport
+    uint32_t writes = 0;
+    uint32_t bytesWritten = 0;
+
+private:
+    const char *session = "";
+    size_t position = 0;
+    size_t length = 0;
+};
+
+// Log output that only counts the lines
+class NullPrint : public Print
+{
+public:
+    uint32_t lines = 0;
+
+    size_t write(uint8_t c) override
+    {
+        lines += (c == '\n');
+        return 1;
+    }
+};
+
+/**
+ * Counts the reads TraceReplay does, to check it stays at a few per request
+ * whatever the length of the trace
+ */
+class CountingTraceReader : public TraceReader
+{
+public:
+    TraceReader *reader = nullptr;
+    uint32_t reads = 0;
+
+    bool read(uint32_t offset, uint8_t *buffer, uint16_t length) override
+    {
+        reads++;
+        return reader->read(offset, buffer, length);
+    }
+};
+
+struct BenchmarkSession
+{
+    const char *name;
+    const char *requests;
+};
+
+void runBenchmark(const BenchmarkSession &session);
+void writeBenchmarkTrace(Print &out);
+void benchmarkLog();
+uint32_t readRpm(uint16_t pid);
+uint32_t freeHeap();
@@ -0,0 +1,309 @@
+#include "ELMulator_Benchmark.h"
+
+/**
+ * Measures the whole request/response path (parsing, AT commands, PID
+ * formatting, transport writes) by replaying recorded client sessions
+ * through an in memory Stream, without any radio in the way.
+ *
+ * Log messages up to ELM_LOG_LEVEL (definitions.h, or a build flag) are
+ * compiled in; build once per level to compare their cost. They go to a
+ * sink that only counts them, from a background task on ESP32, so the
+ * numbers show the cost left in the request path.
+ *
+ * Runs on any board with the library (OBDStreamComm only needs a Stream).
+ * Allocations are counted with a global operator new; Arduino String buffers
+ * are malloc'ed and only show up in the free heap difference (ESP32 only).
+ *
+ * On ESP32 a 10 minute drive is also written to LittleFS and replayed from
+ * the file at 1000x, reads/req shows how much of it each request reads, and
+ * a session is run again with every request and response recorded to LittleFS
+ * (see SessionRecorder). Requests come much faster here than from a real
+ * client, so the recorder may drop records, it reports how many.
+ */
+
+const uint16_t REPETITIONS = 200; // each session is replayed this many times
+
+// Recorded sessions, one request per '\r' as sent by the client
+const BenchmarkSession sessions[] = {
+    // Torque Pro connecting to the adapter
+    {"Torque init", "ATZ\rATE0\rATM0\rATL0\rATS0\rATH0\rATAT1\rATSP0\rATDPN\r0100\r0120\r0140\r0160\rATDESC\rATRV\r"},
+    // Torque Pro polling a dashboard, with the expected response count
+    {"Torque polling", "010C1\r010D1\r01051\r010F1\r01111\r01041\r010B1\r010C1\r010D1\r"},
+    // Requests of the ESP32_Test_Long_Response example, multi frame responses
+    {"Long response", "017A\r0100204060\r010C0D11050F04\r0101\r"},
+    // Car Scanner batching pids with spaces and line feeds on
+    {"Car Scanner", "ATL1\rATS1\r01 0C 0D 11 05\r01 04 0F 0B\r01 0C 0D 11 05\r01 04 0F 0B\r"},
+    // Mode 22 and unsupported modes, answered with NO DATA
+    {"Other modes", "2218E4\r0902\r221234\r0600\r"},
+};
+
+// PIDs polled by the sessions above
+constexpr SupportedPids BENCHMARK_PIDS = makeSupportedPids(ENGINE_LOAD, ENGINE_COOLANT_TEMP, ENGINE_RPM, VEHICLE_SPEED,
+                                                           INTAKE_MANIFOLD_ABS_PRESSURE, INTAKE_AIR_TEMP, THROTTLE_POSITION,
+                                                           MONITOR_STATUS_SINCE_DTC_CLEARED, 0x7A);
+
+// Requests answered from the recorded drive, PIDs without a handler
+const BenchmarkSession traceSession = {"Trace replay", "0104\r0105\r010B\r010D\r010F\r0111\r010D0B11\r"};
+
+// PIDs of the recorded drive, sorted
+const uint8_t TRACE_PIDS[] = {ENGINE_LOAD, ENGINE_COOLANT_TEMP, INTAKE_MANIFOLD_ABS_PRESSURE,
+                              VEHICLE_SPEED, INTAKE_AIR_TEMP, THROTTLE_POSITION};
+const uint16_t TRACE_SECONDS = 600;
+const uint16_t TRACE_PERIOD_MS = 200; // each PID recorded at 5 Hz
+const uint16_t TRACE_INDEX_INTERVAL_MS = 1000;
+const float TRACE_SPEED = 1000;
+
+// Car Scanner session again, recorded
+const BenchmarkSession recordedSession = {"Car Scanner rec", "ATL1\rATS1\r01 0C 0D 11 05\r01 04 0F 0B\r01 0C 0D 11 05\r01 04 0F 0B\r"};
+const uint32_t RECORDED_RECORDS = 4096;
+
+ReplayStream replay;
+OBDStreamComm transport(replay);
+ELMulator myELMulator(&transport);
+
+CountingTraceReader traceReader;
+TraceReplay traceReplay;
+SessionRecorder recorder;
+#if HAS_FS
+File traceFile;
+File sessionFile;
+FileTraceReader traceFileReader(traceFile);
+#endif
+
+NullPrint logSink;
+
+volatile uint32_t nAllocations = 0;
+
+void *operator new(size_t size)
+{
+    nAllocations++;
+    return malloc(size);
+}
+
+void *operator new[](size_t size)
+{
+    nAllocations++;
+    return malloc(size);
+}
+
+uint32_t freeHeap()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    return ESP.getFreeHeap();
+#else
+    return 0;
+#endif
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    ELMLog::begin(&logSink);
+    myELMulator.init("benchmark");
+    myELMulator.registerPids(SERVICE_01, BENCHMARK_PIDS);
+    myELMulator.registerMode01Pid(ENGINE_RPM, readRpm);
+
+    char header[60];
+    snprintf(header, sizeof(header), "log level %d, stats %s", ELM_LOG_LEVEL, ELM_STATS ? "on" : "off");
+    Serial.println(header);
+    Serial.println("session           requests  req/s     ns/req    bytes/req  writes/req  new/req  heap diff  reads/req");
+    for (const BenchmarkSession &session : sessions)
+    {
+        runBenchmark(session);
+    }
+
+#if HAS_FS
+    // write the drive once, then serve it straight from the file
+    LittleFS.begin(true);
+    File file = LittleFS.open("/benchmark.elmt", FILE_WRITE);
+    writeBenchmarkTrace(file);
+    file.close();
+    traceFile = LittleFS.open("/benchmark.elmt", FILE_READ);
+    traceReader.reader = &traceFileReader;
+    if (traceReplay.begin(&traceReader))
+    {
+        traceReplay.setSpeed(TRACE_SPEED);
+        myELMulator.setTraceReplay(&traceReplay);
+        runBenchmark(traceSession);
+    }
+
+    sessionFile = LittleFS.open("/session.elmr", FILE_WRITE);
+    recorder.begin(sessionFile, RECORDED_RECORDS);
+    myELMulator.setSessionRecorder(&recorder);
+    runBenchmark(recordedSession);
+    myELMulator.setSessionRecorder(nullptr);
+    delay(2 * RECORDER_DRAIN_PERIOD_MS); // let the last records reach the file
+    recorder.update();
+    sessionFile.close();
+
+    char line[80];
+    snprintf(line, sizeof(line), "recorder dropped %lu records", (unsigned long)recorder.getDropped());
+    Serial.println(line);
+#endif
+
+    delay(2 * LOG_DRAIN_PERIOD_MS);
+    ELMLog::update();
+    char logLine[80];
+    snprintf(logLine, sizeof(logLine), "%lu log lines, %lu dropped", (unsigned long)logSink.lines, (unsigned long)ELMLog::getDropped());
+    Serial.println(logLine);
+
+#if ELM_LOG_LEVEL > ELM_LOG_LEVEL_NONE
+    benchmarkLog();
+#endif
+
+#if ELM_STATS
+    // every session above, ELMulator side of each request
+    ELMStats::print(Serial);
+#endif
+}
+
+void loop() {}
+
+void runBenchmark(const BenchmarkSession &session)
+{
+    uint32_t requestsPerReplay = 0;
+    for (const char *c = session.requests; *c; c++)
+    {
+        requestsPerReplay += (*c == SERIAL_END_CHAR);
+    }
+    uint32_t nRequests = requestsPerReplay * REPETITIONS;
+
+    replay.load(session.requests);
+    replay.bytesWritten = 0;
+    replay.writes = 0;
+    traceReader.reads = 0;
+    uint32_t allocationsBefore = nAllocations;
+    uint32_t heapBefore = freeHeap();
+    uint32_t start = micros();
+
+    // poll() handles AT commands itself and sends PID requests through sendELMResponse()
+    for (uint16_t i = 0; i < REPETITIONS; i++)
+    {
+        replay.rewind();
+        while (replay.available())
+        {
+            myELMulator.poll();
+        }
+    }
+
+    uint32_t elapsed = micros() - start;
+    int32_t heapDiff = (int32_t)heapBefore - (int32_t)freeHeap();
+    uint32_t allocations = nAllocations - allocationsBefore;
+
+    char line[140];
+    snprintf(line, sizeof(line), "%-16s  %8lu  %8lu  %8lu  %9lu  %10.2f  %7.2f  %9ld  %9.2f",
+             session.name,
+             (unsigned long)nRequests,
+             (unsigned long)(elapsed ? (uint64_t)nRequests * 1000000 / elapsed : 0),
+             (unsigned long)((uint64_t)elapsed * 1000 / nRequests),
+             (unsigned long)(replay.bytesWritten / nRequests),
+             (float)replay.writes / nRequests,
+             (float)allocations / nRequests,
+             (long)heapDiff,
+             (float)traceReader.reads / nRequests);
+    Serial.println(line);
+}
+
+// registered with a handler so the polling sessions also go through the handler table
+uint32_t readRpm(uint16_t pid)
+{
+    return 0x1AF8;
+}
+
+static void writeU16(Print &out, uint16_t value)
+{
+    out.write((uint8_t)value);
+    out.write((uint8_t)(value >> 8));
+}
+
+static void writeU32(Print &out, uint32_t value)
+{
+    writeU16(out, value);
+    writeU16(out, value >> 16);
+}
+
+/**
+ * Writes the drive of the default VehicleSimulator seed as a trace (format
+ * in TraceReplay.h): each PID is recorded every TRACE_PERIOD_MS, so the
+ * index entries are known without buffering anything.
+ */
+void writeBenchmarkTrace(Print &out)
+{
+    const uint8_t nPids = sizeof(TRACE_PIDS);
+    const uint32_t nRecords = (uint32_t)TRACE_SECONDS * 1000 / TRACE_PERIOD_MS + 1;
+    const uint32_t durationMs = (nRecords - 1) * TRACE_PERIOD_MS;
+    const uint32_t nSlots = durationMs / TRACE_INDEX_INTERVAL_MS + 1;
+
+    out.write((const uint8_t *)"ELMT", 4);
+    writeU16(out, 1);
+    writeU16(out, nPids);
+    writeU32(out, durationMs);
+    writeU32(out, TRACE_INDEX_INTERVAL_MS);
+
+    uint32_t offset = 16 + 16 * nPids;
+    for (uint8_t pid : TRACE_PIDS)
+    {
+        out.write(SERVICE_01);
+        out.write(pid);
+        out.write(responseBytes[pid]);
+        out.write((uint8_t)0);
+        writeU32(out, nRecords);
+        writeU32(out, offset + nSlots * 4);
+        writeU32(out, offset);
+        offset += nSlots * 4 + nRecords * 8;
+    }
+
+    for (uint8_t pid : TRACE_PIDS)
+    {
+        for (uint32_t slot = 0; slot < nSlots; slot++)
+        {
+            writeU32(out, slot * TRACE_INDEX_INTERVAL_MS / TRACE_PERIOD_MS + 1);
+        }
+        VehicleSimulator simulator; // same drive for every PID
+        for (uint32_t record = 0; record < nRecords; record++)
+        {
+            uint32_t value = 0;
+            simulator.getRawValue(pid, value);
+            writeU32(out, record * TRACE_PERIOD_MS);
+            writeU32(out, value);
+            for (uint16_t i = 0; i < TRACE_PERIOD_MS / SIMULATION_STEP_MS; i++)
+            {
+                simulator.step();
+            }
+        }
+    }
+}
+
+#if ELM_LOG_LEVEL > ELM_LOG_LEVEL_NONE
+/**
+ * Cost of an enabled message in the request path (copy into the ring) and
+ * of printing it later (formatting, off the request path; only measured
+ * without the background task, otherwise it prints them itself)
+ */
+void benchmarkLog()
+{
+    const uint16_t BATCHES = 1000;
+    const uint8_t BATCH_SIZE = LOG_RING_SIZE / 2;
+    uint32_t logUs = 0;
+    uint32_t printUs = 0;
+    for (uint16_t i = 0; i < BATCHES; i++)
+    {
+        uint32_t start = micros();
+        for (uint8_t j = 0; j < BATCH_SIZE; j++)
+        {
+            ELM_LOG_ERROR("AT command %s, pid %02X", "ATSP0", j);
+        }
+        logUs += micros() - start;
+
+        start = micros();
+        ELMLog::update();
+        printUs += micros() - start;
+    }
+
+    char line[80];
+    snprintf(line, sizeof(line), "log message: %lu ns to queue, %lu ns to print",
+             (unsigned long)((uint64_t)logUs * 1000 / (BATCHES * BATCH_SIZE)),
+             (unsigned long)((uint64_t)printUs * 1000 / (BATCHES * BATCH_SIZE)));
+    Serial.println(line);
+}
+#endif
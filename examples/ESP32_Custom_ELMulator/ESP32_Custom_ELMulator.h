@@ -3,4 +3,9 @@
 #include <ELMulator.h>
 #include <definitions.h>
 
-void handlePIDRequest(const String& pidRequest);
\ No newline at end of file
+void handlePIDRequest(const String& pidRequest);
+uint32_t readCoolantTemp(uint16_t pid);
+float readRpm(uint16_t pid);
+uint32_t readOdometer(uint16_t pid);
+uint32_t readEthanolPercent(uint16_t pid);
+uint32_t readDpfClogging(uint16_t pid);
\ No newline at end of file
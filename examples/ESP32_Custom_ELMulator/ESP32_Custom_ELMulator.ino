@@ -6,8 +6,8 @@ const String deviceName = "ELMULATOR"; // Bluetooth device name to use (no pin)
 const String milResponse = "4101830000";                       // MIL response code indicating 3 current DTC
 const String dtcResponse = "43010341\r\n43010123\r\n43010420"; // DTC response returning 3 DTC codes (multiline response)
 const uint32_t odoResponse = 1234567;                          // Hardcode an odometer reading of 1234567
-const String ethPercentResponse = "620052C6";
-const String dpfCloggingResponse = "6218E4C6";
+const uint8_t ethPercent = 0xC6;                               // Mode 22 ethanol percent value
+const uint8_t dpfClogging = 0xC6;                              // Mode 22 DPF clogging value (A-R Giulia)
 
 ELMulator myELMulator;
 
@@ -20,15 +20,20 @@ void setup()
     // Register the specific PIDs we are going to handle.
     // myELMulator will respond to SUPPORTED_PIDS request ("0101") with the appropriate value
     // indicating which PIDs it can respond to.
-    myELMulator.registerMode01Pid(ODOMETER);
-    myELMulator.registerMode01Pid(ENGINE_COOLANT_TEMP);
-    myELMulator.registerMode01Pid(ENGINE_RPM);
+    // PIDs registered with a handler are answered by myELMulator, calling the handler for the value.
+    myELMulator.registerMode01Pid(ODOMETER, readOdometer);
+    myELMulator.registerMode01Pid(ENGINE_COOLANT_TEMP, readCoolantTemp);
+    myELMulator.registerMode01Pid(ENGINE_RPM, readRpm);
     myELMulator.registerMode01Pid(MONITOR_STATUS_SINCE_DTC_CLEARED);
     myELMulator.registerMode01Pid(INTAKE_MANIFOLD_ABS_PRESSURE);
     myELMulator.registerMode01Pid(ENGINE_LOAD);
     myELMulator.registerMode01Pid(VEHICLE_SPEED);
     myELMulator.registerMode01Pid(INTAKE_AIR_TEMP);
     myELMulator.registerMode01Pid(THROTTLE_POSITION);
+
+    // Mode 0x22 (extended info) service - Mfg-dependent and not defined in OBDII spec
+    myELMulator.registerMode22Pid(0x52, 1, readEthanolPercent);
+    myELMulator.registerMode22Pid(0x18E4, 1, readDpfClogging);
 }
 
 void loop()
@@ -46,8 +51,49 @@ void loop()
 }
 
 /**
- * After receiving a supported PID(sensor) request, we prepare the response here.
- * Response can come from a hardcoded value, a real hardware sensor, or a mock value.
+ * PID handlers, called by myELMulator each time their PID is requested.
+ * The value can come from a hardcoded value, a real hardware sensor, or a mock value;
+ * myELMulator formats the response with the number of bytes of the PID (see responseBytes).
+ */
+
+// Engine Coolant Temp (0x05) - returning a mock data value
+uint32_t readCoolantTemp(uint16_t pid)
+{
+    return myELMulator.getMockSensorValue();
+}
+
+// Engine RPM (0x0C) - returns a modified mock sensor value in rpm,
+// a float handler: myELMulator encodes it with the PID formula ((256A + B) / 4)
+float readRpm(uint16_t pid)
+{
+    return myELMulator.getMockSensorValue() * 25.0f; // Here we multiply the mock value provided, for a more realistic RPM number
+}
+
+// Odometer (0xA6) - returns our hardcoded odometer value
+uint32_t readOdometer(uint16_t pid)
+{
+    return odoResponse;
+}
+
+// // Vehicle speed (0x0D) - returns a value from external GPS
+// // register it with myELMulator.registerMode01Pid(VEHICLE_SPEED, readGpsSpeed);
+// uint32_t readGpsSpeed(uint16_t pid)
+// {
+//     return myGPS.speed();
+// }
+
+uint32_t readEthanolPercent(uint16_t pid)
+{
+    return ethPercent;
+}
+
+uint32_t readDpfClogging(uint16_t pid)
+{
+    return dpfClogging;
+}
+
+/**
+ * Requests for registered PIDs without a handler, and special cases like MIL and DTC checks, come here.
  * Default response is a mock value if no other handling is provided.
  */
 void handlePIDRequest(const String &request)
@@ -62,7 +108,7 @@ void handlePIDRequest(const String &request)
         }
         else
         {
-            DEBUG("DTC response is empty.");
+            ELM_LOG_WARN("DTC response is empty.");
             myELMulator.writePidNotSupported();
             return;
         }
@@ -77,96 +123,13 @@ void handlePIDRequest(const String &request)
         }
         else
         {
-            DEBUG("MIL response is empty.");
+            ELM_LOG_WARN("MIL response is empty.");
             myELMulator.writePidNotSupported();
             return;
         }
     }
 
-    else if (myELMulator.isMode22(request)) // Mode 0x22 (extended info) service - Mfg-dependent and not defined in OBDII spec
-    {
-        
-        Serial.print("Mode 22 PID: "); Serial.println(request.substring(2));
-
-        if (request.substring(2).compareTo("52") == 0) // Ethanol percent
-        {
-            if (ethPercentResponse.length())
-            {
-                myELMulator.writeResponse(ethPercentResponse);
-                return;
-            }
-            else
-            {
-                DEBUG("ETH % response is empty.");
-                myELMulator.writePidNotSupported();
-                return;
-            }
-        }
-
-        if (request.substring(2).compareTo("18E4") == 0) // DPF Clogging A-R Giulia
-        {
-            if (dpfCloggingResponse.length())
-            {
-                myELMulator.writeResponse(dpfCloggingResponse);
-                return;
-            }
-            else
-            {
-                DEBUG("DPF Clogging response is empty.");
-                myELMulator.writePidNotSupported();
-                return;
-            }
-        }
-        myELMulator.writePidNotSupported();
-        return;
-    }
-    else // Handle any other supported PID request
-    {
-        uint8_t pidCode = myELMulator.getPidCode(request); // Extract the specific PID code from the request
-
-        // Example response for 0x05 (Engine Coolant Temp) - returning a mock data value
-        if (pidCode == ENGINE_COOLANT_TEMP)
-        {
-            uint32_t sensorValue = myELMulator.getMockSensorValue();
-
-            /**
-             * Response parameters:
-             * request - specifies the original PID request being responded to.
-             * numberOfBytes - the number of bytes this PID value returns (per OBDII spec), using lookup table responseBytes.
-             * sensorValue - the value to return in our response; a mock value in this example.
-             */
-            myELMulator.writePidResponse(request, responseBytes[pidCode], sensorValue);
-            return;
-        }
-
-        // Example response for PID 0x0C (Engine RPM) - returns a modified mock sensor value
-        else if (pidCode == ENGINE_RPM)
-        {
-            uint16_t rpmValue = myELMulator.getMockSensorValue() * 100; // Here we multiply the mock value provided, for a more realistic RPM number
-            myELMulator.writePidResponse(request, responseBytes[pidCode], rpmValue);
-            return;
-        }
-
-        // Example response for PID 0xA6 (Odometer) - returns our hardcoded odometer response string
-        else if (pidCode == ODOMETER)
-        {
-            myELMulator.writePidResponse(request, responseBytes[pidCode], odoResponse);
-            return;
-        }
-
-        // // Example response for PID 0xOD (Vehicle speed) - returns a value from external GPS
-        // else if (pidCode == VEHICLE_SPEED)
-        // {
-        //     uint32_t gpsSpeed = myGPS.speed();
-        //     myELMulator.writePidResponse(request, responseBytes[pidCode], gpsSpeed);
-        //     return;
-        // }
-
-        // Default response for any other supported PID request - returns an unmodified mock sensor value
-        else
-        {
-            myELMulator.writePidResponse(request, responseBytes[pidCode], myELMulator.getMockSensorValue());
-            return;
-        }
-    }
+    // Default response for any other supported PID request - returns a mock sensor value
+    // (and NO DATA for other modes, ex: unregistered mode 22 PIDs)
+    myELMulator.sendELMResponse();
 }
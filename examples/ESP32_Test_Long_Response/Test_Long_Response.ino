@@ -3,11 +3,11 @@ const String deviceName = "OBDII"; // Bluetooth device name to use (no pin)
 
 // Set up hardcoded responses to non-standard PID requests for MIL, DTC, ODO data
 const String milResponse = "4101830000";                       // MIL response code indicating 3 current DTC
-const String dtcResponse = "43010341\r\n43010123\r\n43010420"; // DTC response returning 3 DTC codes (multiline response)
+const uint8_t dtcResponse[] = {0x43, 0x03, 0x03, 0x41, 0x01, 0x23, 0x04, 0x20}; // 3 DTC codes: P0341, P0123, P0420 (multi frame response)
 const uint32_t odoResponse = 1234567;                          // Hardcode an odometer reading of 1234567
 const String ethPercentResponse = "620052C6";
 const String dpfCloggingResponse = "6218E4C6";
-const String test_017A_Response = "009\r0:417A00013C00\r1:00000000000000";
+const uint8_t test_017A_Response[] = {0x41, 0x7A, 0x00, 0x01, 0x3C, 0x00, 0x00, 0x00, 0x00}; // 9 bytes, sent as 2 CAN frames
 
 ELMulator myELMulator;
 
@@ -29,6 +29,7 @@ void setup()
     myELMulator.registerMode01Pid(VEHICLE_SPEED);
     myELMulator.registerMode01Pid(INTAKE_AIR_TEMP);
     myELMulator.registerMode01Pid(THROTTLE_POSITION);
+    myELMulator.registerMode01Pid(0x7A); // answered with test_017A_Response
 }
 
 void loop()
@@ -55,17 +56,8 @@ void handlePIDRequest(const String &request)
     // Handle special case requests like MIL and DTC checks
     if (myELMulator.isMode03(request)) // Mode 03 request == Returns (hardcoded) list current DTC codes
     {
-        if (dtcResponse.length())
-        {
-            myELMulator.writeResponse(dtcResponse);
-            return;
-        }
-        else
-        {
-            DEBUG("DTC response is empty.");
-            myELMulator.writePidNotSupported();
-            return;
-        }
+        myELMulator.writeResponse(dtcResponse, sizeof(dtcResponse));
+        return;
     }
 
     else if (myELMulator.isMode01MIL(request)) // Mode 0101 MIL request == Returns (hardcoded) number of current DTC codes
@@ -77,7 +69,7 @@ void handlePIDRequest(const String &request)
         }
         else
         {
-            DEBUG("MIL response is empty.");
+            ELM_LOG_WARN("MIL response is empty.");
             myELMulator.writePidNotSupported();
             return;
         }
@@ -97,7 +89,7 @@ void handlePIDRequest(const String &request)
             }
             else
             {
-                DEBUG("ETH % response is empty.");
+                ELM_LOG_WARN("ETH %% response is empty.");
                 myELMulator.writePidNotSupported();
                 return;
             }
@@ -112,7 +104,7 @@ void handlePIDRequest(const String &request)
             }
             else
             {
-                DEBUG("DPF Clogging response is empty.");
+                ELM_LOG_WARN("DPF Clogging response is empty.");
                 myELMulator.writePidNotSupported();
                 return;
             }
@@ -125,17 +117,8 @@ void handlePIDRequest(const String &request)
     {
         if (request.substring(2).compareTo("7A") == 0) 
         {
-            if (test_017A_Response.length())
-            {
-                myELMulator.writeResponse(test_017A_Response);
-                return;
-            }
-            else
-            {
-                DEBUG("response is empty.");
-                myELMulator.writePidNotSupported();
-                return;
-            }
+            myELMulator.writeResponse(test_017A_Response, sizeof(test_017A_Response));
+            return;
         }
         
         uint8_t pidCode = myELMulator.getPidCode(request); // Extract the specific PID code from the request
@@ -62,7 +62,7 @@ void handlePIDRequest(const String &request)
         }
         else
         {
-            DEBUG("DTC response is empty.");
+            ELM_LOG_WARN("DTC response is empty.");
             myELMulator.writePidNotSupported();
             return;
         }
@@ -77,7 +77,7 @@ void handlePIDRequest(const String &request)
         }
         else
         {
-            DEBUG("MIL response is empty.");
+            ELM_LOG_WARN("MIL response is empty.");
             myELMulator.writePidNotSupported();
             return;
         }
@@ -97,7 +97,7 @@ void handlePIDRequest(const String &request)
             }
             else
             {
-                DEBUG("ETH % response is empty.");
+                ELM_LOG_WARN("ETH %% response is empty.");
                 myELMulator.writePidNotSupported();
                 return;
             }
@@ -112,7 +112,7 @@ void handlePIDRequest(const String &request)
             }
             else
             {
-                DEBUG("DPF Clogging response is empty.");
+                ELM_LOG_WARN("DPF Clogging response is empty.");
                 myELMulator.writePidNotSupported();
                 return;
             }
@@ -0,0 +1,156 @@
+#include <ATCommands.h>
+#include <chrono>
+#include "HeapCounter.h"
+
+/**
+ * AT command dispatch, the sorted table (ATCommands::findCommand) against
+ * the startsWith chain it replaced, on the init sequences of Torque, Car
+ * Scanner and ELMduino (as parsed, upper case without spaces).
+ *
+ * Only finding the handler is timed: the old chain is copied from
+ * processCommand before the table, with its substring of the command, and
+ * calls handlers which only record they were chosen. Its allocations are
+ * the substring and the String made of each literal it is compared to: the
+ * ESP32 core keeps strings this short in the String object itself, the
+ * shim (like AVR cores) does not.
+ */
+
+const uint32_t REPETITIONS = 100000;
+const uint8_t MAX_SEQUENCE_SIZE = 16;
+
+struct InitSequence
+{
+    const char *name;
+    const char *commands[MAX_SEQUENCE_SIZE];
+};
+
+static const InitSequence SEQUENCES[] = {
+    {"Torque", {"ATZ", "ATE0", "ATM0", "ATL0", "ATS0", "ATH0", "ATAT1", "ATSP0", "ATDPN", "ATDESC", "ATRV"}},
+    {"Car Scanner", {"ATZ", "ATD", "ATE0", "ATL0", "ATS0", "ATH1", "ATAT1", "ATSP0", "ATDPN", "ATH0", "ATCAF1",
+                     "ATCRA7E8", "ATSH7DF", "ATL1", "ATS1"}},
+    {"ELMduino", {"ATD", "ATZ", "ATE0", "ATS0", "ATAL", "ATST00", "ATTPA0"}},
+};
+static const uint8_t N_SEQUENCES = sizeof(SEQUENCES) / sizeof(SEQUENCES[0]);
+
+static volatile uint8_t chosen;
+
+static void choose(uint8_t handler)
+{
+    chosen = handler;
+}
+
+// processCommand before the command table, handlers replaced by their index
+static void dispatchWithStartsWith(const String &command)
+{
+    // if space is enabled (ex: AT H[charPosition])
+    uint8_t offset = 2;
+    if (command.charAt(2) == 0x20) {
+        offset = 3;
+    }
+
+    // refer to ELM327 specs
+    String specificCommand = command.substring(offset, command.length());
+    if (specificCommand.startsWith("D",offset)) {
+        choose(0);
+    } else if (specificCommand.startsWith("Z")) {
+        choose(1);
+    } else if (specificCommand.startsWith("I")) {
+        choose(2);
+    } else if (specificCommand.startsWith("E")) {
+        choose(3);
+    } else if (specificCommand.startsWith("L")) {
+        choose(4);
+    } else if (specificCommand.startsWith("M")) {
+        choose(5);
+    } else if (specificCommand.startsWith("SH")) {
+        choose(6);
+    } else if (specificCommand.startsWith("SP")) {
+        choose(7);
+    } else if (specificCommand.startsWith("S")) {
+        choose(8);
+    } else if (specificCommand.startsWith("H")) {
+        choose(9);
+    } else if (specificCommand.startsWith("AT")) {
+        choose(10);
+    } else if (specificCommand.startsWith("DPN")) {
+        choose(11);
+    }  else if (specificCommand.startsWith("DESC") || specificCommand.startsWith("@1")) {
+        choose(12);
+    } else if (specificCommand.startsWith("PC")) {
+        choose(13);
+    } else if (specificCommand.startsWith("RV")){
+        choose(14);
+    } else {
+
+        // lets assume we process any at command
+        choose(15);
+    }
+}
+
+static void dispatchWithTable(const char *command)
+{
+    const ATCommands::Command *cmd = ATCommands::findCommand(command + 2);
+    choose(cmd != nullptr ? cmd - ATCommands::COMMANDS : 0xFF);
+}
+
+static uint64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void runSequence(const InitSequence &sequence)
+{
+    // the old dispatch got the request as a String, made before
+    String commands[MAX_SEQUENCE_SIZE];
+    uint8_t nCommands = 0;
+    while (nCommands < MAX_SEQUENCE_SIZE && sequence.commands[nCommands] != nullptr)
+    {
+        commands[nCommands] = sequence.commands[nCommands];
+        nCommands++;
+    }
+    uint32_t nDispatches = nCommands * REPETITIONS;
+
+    uint32_t allocations = HeapCounter::getAllocations();
+    uint64_t start = nowNs();
+    for (uint32_t i = 0; i < REPETITIONS; i++)
+    {
+        for (uint8_t j = 0; j < nCommands; j++)
+        {
+            dispatchWithStartsWith(commands[j]);
+        }
+    }
+    uint64_t startsWithNs = nowNs() - start;
+    uint32_t startsWithAllocations = HeapCounter::getAllocations() - allocations;
+
+    allocations = HeapCounter::getAllocations();
+    start = nowNs();
+    for (uint32_t i = 0; i < REPETITIONS; i++)
+    {
+        for (uint8_t j = 0; j < nCommands; j++)
+        {
+            dispatchWithTable(sequence.commands[j]);
+        }
+    }
+    uint64_t tableNs = nowNs() - start;
+    uint32_t tableAllocations = HeapCounter::getAllocations() - allocations;
+
+    printf("%-12s  %8u  %17.1f  %17.2f  %12.1f  %12.2f  %6.1fx\n",
+           sequence.name,
+           nCommands,
+           (double)startsWithNs / nDispatches,
+           (double)startsWithAllocations / nDispatches,
+           (double)tableNs / nDispatches,
+           (double)tableAllocations / nDispatches,
+           tableNs > 0 ? (double)startsWithNs / tableNs : 0);
+}
+
+int main()
+{
+    printf("%lu repetitions of each init sequence\n", (unsigned long)REPETITIONS);
+    printf("sequence      commands  startsWith ns/cmd  startsWith allocs  table ns/cmd  table allocs  speedup\n");
+    for (uint8_t i = 0; i < N_SEQUENCES; i++)
+    {
+        runSequence(SEQUENCES[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,357 @@
+#include <ELMulator.h>
+#include <algorithm>
+#include <chrono>
+#include "HeapCounter.h"
+#include "ReplayStream.h"
+#include "Sessions.h"
+
+/**
+ * Host benchmark of the whole request/response path (parsing, AT commands,
+ * PID formatting, transport writes): recorded client sessions are replayed
+ * through OBDStreamComm over an in memory Stream, see extras/host/README.md.
+ *
+ * Each session is replayed once to warm up (caches, first registrations),
+ * then REPETITIONS times measured. Heap calls are counted by wrapping
+ * malloc/realloc/free, so String buffers are counted as well as objects,
+ * and reported for each code path the requests take.
+ *
+ * Last, the sessions are replayed over links (see ReplayStream::setLink)
+ * with each flush policy: packets and flushes per response, time spent in
+ * poll() and the round trip from the end of a request to its prompt. The
+ * "before" rows send the same responses with the writes OBDComm made before
+ * it sent each response with a single write (see PieceWriteStream).
+ */
+
+const uint16_t REPETITIONS = 2000;
+
+struct Link
+{
+    const char *name;
+    uint32_t packetUs;
+    float byteUs;
+    uint16_t repetitions;
+};
+
+// in memory only times the requests, then a serial line and a packet transport (Bluetooth or TCP)
+static const Link LINKS[] = {{"in memory", 0, 0, 1000}, {"115200 baud", 0, 86.8f, 10}, {"2 ms packets", 2000, 0, 10}};
+static const uint8_t N_LINKS = sizeof(LINKS) / sizeof(LINKS[0]);
+
+static const OBDComm::FLUSH_POLICY FLUSH_POLICIES[] = {OBDComm::FLUSH_EACH_RESPONSE, OBDComm::FLUSH_NEVER};
+static const char *const FLUSH_POLICY_NAMES[] = {"each response", "never"};
+
+enum PATH
+{
+    PATH_AT = 0,
+    PATH_MODE_01 = 1,
+    PATH_MODE_01_MULTI = 2, // several pids in one request
+    PATH_OTHER_MODES = 3,
+    PATH_INVALID = 4,
+    N_PATHS = 5
+};
+
+static const char *const PATH_NAMES[N_PATHS] = {"AT", "01", "01 multi pid", "other modes", "invalid"};
+
+struct PathCounters
+{
+    uint32_t requests;
+    uint32_t allocations;
+    uint32_t frees;
+};
+
+/**
+ * Between OBDStreamComm and the ReplayStream, sends each response with the
+ * transport writes of OBDComm before single write responses: a write for
+ * each writeTo (the echo, each line, each "\r", "\n" and ">") and a flush
+ * once the prompt is written. Mode 01 and 22 responses of a single pid came
+ * from the response cache, already rendered, and were one write. The echo
+ * had no line end then, it is kept in the echo write.
+ */
+class PieceWriteStream : public Stream
+{
+public:
+    PieceWriteStream(ReplayStream &stream) : stream(stream), requestLength(0), lineLength(0), responseLength(0) {}
+
+    int available() override
+    {
+        return stream.available();
+    }
+
+    int read() override
+    {
+        int c = stream.read();
+        if (c == SERIAL_END_CHAR)
+        {
+            requestLength = lineLength;
+            lineLength = 0;
+        }
+        else if (c >= 0 && lineLength < sizeof(request))
+        {
+            request[lineLength++] = c;
+        }
+        return c;
+    }
+
+    int peek() override
+    {
+        return stream.peek();
+    }
+
+    size_t write(uint8_t c) override
+    {
+        return write(&c, 1);
+    }
+
+    // the response is complete once its prompt is written
+    size_t write(const uint8_t *buffer, size_t size) override
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            if (responseLength < sizeof(response))
+            {
+                response[responseLength++] = buffer[i];
+            }
+            if (buffer[i] == '>')
+            {
+                writePieces();
+                responseLength = 0;
+            }
+        }
+        return size;
+    }
+
+    // flushed once per response, as before the flush policies
+    void flush() override
+    {
+    }
+
+    using Print::write;
+
+private:
+    ReplayStream &stream;
+    char request[MAX_REQUEST_SIZE];
+    uint8_t requestLength;
+    uint8_t lineLength;
+    char response[ReplayStream::OUTPUT_SIZE];
+    uint16_t responseLength;
+
+    void writePieces()
+    {
+        uint16_t pos = 0;
+        if (requestLength > 0 && responseLength > requestLength && memcmp(response, request, requestLength) == 0)
+        {
+            uint16_t end = requestLength;
+            while (end < responseLength && (response[end] == '\r' || response[end] == '\n'))
+            {
+                end++;
+            }
+            stream.write((const uint8_t *)response, end);
+            pos = end;
+        }
+
+        if (isSinglePid(pos))
+        {
+            stream.write((const uint8_t *)response + pos, responseLength - pos);
+        }
+        else
+        {
+            while (pos < responseLength)
+            {
+                uint16_t end = pos + 1;
+                if (response[pos] != '\r' && response[pos] != '\n' && response[pos] != '>')
+                {
+                    while (end < responseLength && response[end] != '\r' && response[end] != '\n' && response[end] != '>')
+                    {
+                        end++;
+                    }
+                }
+                stream.write((const uint8_t *)response + pos, end - pos);
+                pos = end;
+            }
+        }
+        stream.flush();
+    }
+
+    // response at pos to a mode 01 or 22 request of one pid (ex: 010C, 010C1, 22F40D)
+    bool isSinglePid(uint16_t pos)
+    {
+        uint8_t pidChars = requestLength - 2;
+        if (requestLength > 2 && request[0] == '0' && request[1] == '1')
+        {
+            return response[pos] == '4' && (pidChars == 2 || pidChars == 3);
+        }
+        if (requestLength > 2 && request[0] == '2' && request[1] == '2')
+        {
+            return response[pos] == '6' && (pidChars == 4 || pidChars == 5);
+        }
+        return false;
+    }
+};
+
+static ReplayStream replay;
+static OBDStreamComm transport(replay);
+static ELMulator elm(&transport);
+static PieceWriteStream pieceWrites(replay);
+static OBDStreamComm pieceTransport(pieceWrites);
+static ELMulator pieceElm(&pieceTransport);
+static PathCounters paths[N_PATHS];
+static uint32_t sortedLatencies[ReplayStream::MAX_LATENCIES];
+
+static uint64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static PATH getPath(const ELMRequest &request)
+{
+    if (request.type == ELMRequest::AT)
+    {
+        return PATH_AT;
+    }
+    if (request.type != ELMRequest::PID)
+    {
+        return PATH_INVALID;
+    }
+    if (request.isMode(SERVICE_01))
+    {
+        return request.pidCount > 1 ? PATH_MODE_01_MULTI : PATH_MODE_01;
+    }
+    return PATH_OTHER_MODES;
+}
+
+/**
+ * poll() is readELMRequest() + sendELMResponse() without waiting: with the
+ * whole session available, each call handles one request
+ */
+static void replaySession(bool countPaths)
+{
+    replay.rewind();
+    while (!replay.finished())
+    {
+        uint32_t allocations = HeapCounter::getAllocations();
+        uint32_t frees = HeapCounter::getFrees();
+        elm.poll();
+        if (countPaths)
+        {
+            PathCounters &path = paths[getPath(elm.getRequest())];
+            path.requests++;
+            path.allocations += HeapCounter::getAllocations() - allocations;
+            path.frees += HeapCounter::getFrees() - frees;
+        }
+    }
+    replay.clearOutput();
+}
+
+static void runSession(const RecordedSession &session)
+{
+    replay.load(session.requests);
+    uint32_t warmUpAllocations = HeapCounter::getAllocations();
+    replaySession(false);
+    warmUpAllocations = HeapCounter::getAllocations() - warmUpAllocations;
+
+    uint32_t nRequests = (uint32_t)countRequests(session.requests) * REPETITIONS;
+    replay.writes = 0;
+    replay.bytesWritten = 0;
+    uint32_t allocations = HeapCounter::getAllocations();
+    uint64_t start = nowNs();
+    for (uint16_t i = 0; i < REPETITIONS; i++)
+    {
+        replaySession(true);
+    }
+    uint64_t elapsed = nowNs() - start;
+    allocations = HeapCounter::getAllocations() - allocations;
+
+    printf("%-16s  %8lu  %8lu  %6lu  %9lu  %10.2f  %10.2f  %7lu\n",
+           session.name,
+           (unsigned long)nRequests,
+           (unsigned long)(elapsed > 0 ? (uint64_t)nRequests * 1000000000 / elapsed : 0),
+           (unsigned long)(elapsed / nRequests),
+           (unsigned long)(replay.bytesWritten / nRequests),
+           (double)replay.writes / nRequests,
+           (double)allocations / nRequests,
+           (unsigned long)warmUpAllocations);
+}
+
+// Latency at percentile of the sorted latencies, in us
+static double getPercentile(uint32_t n, uint8_t percentile)
+{
+    return n > 0 ? sortedLatencies[(uint64_t)(n - 1) * percentile / 100] / 1000.0 : 0;
+}
+
+// before: the writes of OBDComm before single write responses, flushed after each response
+static void runLink(const Link &link, bool before, uint8_t policy)
+{
+    ELMulator &target = before ? pieceElm : elm;
+    target.setFlushPolicy(FLUSH_POLICIES[policy]);
+    replay.setLink(link.packetUs, link.byteUs);
+    replay.clearLatencies();
+    replay.writes = 0;
+    replay.flushes = 0;
+    uint64_t busyNs = 0;
+    for (uint16_t i = 0; i < link.repetitions; i++)
+    {
+        for (uint8_t j = 0; j < N_SESSIONS; j++)
+        {
+            replay.load(SESSIONS[j]->requests);
+            while (!replay.finished())
+            {
+                uint64_t start = nowNs();
+                if (target.poll())
+                {
+                    busyNs += nowNs() - start;
+                }
+            }
+            replay.clearOutput();
+        }
+    }
+
+    uint32_t n = replay.getLatencyCount();
+    std::copy(replay.getLatencies(), replay.getLatencies() + n, sortedLatencies);
+    std::sort(sortedLatencies, sortedLatencies + n);
+    printf("%-12s  %-6s  %-13s  %8lu  %12.2f  %12.2f  %11lu  %10.1f  %10.1f\n",
+           link.name,
+           before ? "before" : "after",
+           FLUSH_POLICY_NAMES[policy],
+           (unsigned long)n,
+           n > 0 ? (double)replay.writes / n : 0,
+           n > 0 ? (double)replay.flushes / n : 0,
+           (unsigned long)(n > 0 ? busyNs / n : 0),
+           getPercentile(n, 50),
+           getPercentile(n, 99));
+}
+
+int main()
+{
+    elm.init("host");
+    setUpSessionPids(elm);
+    pieceElm.init("host");
+    setUpSessionPids(pieceElm);
+
+    printf("log level %d, stats %s, %u replays of each session\n", ELM_LOG_LEVEL, ELM_STATS ? "on" : "off", REPETITIONS);
+    printf("session           requests     req/s  ns/req  bytes/req  writes/req  allocs/req  warm-up allocs\n");
+    for (uint8_t i = 0; i < N_SESSIONS; i++)
+    {
+        runSession(*SESSIONS[i]);
+    }
+
+    printf("\npath              requests  allocs/req   frees/req\n");
+    for (uint8_t i = 0; i < N_PATHS; i++)
+    {
+        const PathCounters &path = paths[i];
+        if (path.requests > 0)
+        {
+            printf("%-16s  %8lu  %10.2f  %10.2f\n", PATH_NAMES[i], (unsigned long)path.requests,
+                   (double)path.allocations / path.requests, (double)path.frees / path.requests);
+        }
+    }
+
+    printf("\nlink          writes  flush          requests  packets/resp  flushes/resp  poll ns/req  p50 rtt us  p99 rtt us\n");
+    for (uint8_t i = 0; i < N_LINKS; i++)
+    {
+        runLink(LINKS[i], true, 0);
+        for (uint8_t policy = 0; policy < 2; policy++)
+        {
+            runLink(LINKS[i], false, policy);
+        }
+    }
+    return 0;
+}
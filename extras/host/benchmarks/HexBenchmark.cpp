@@ -0,0 +1,162 @@
+#include <HexCodec.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * HexCodec against the code it replaced, copied below as it was: the
+ * strspn isValidHex of ELMulator, strtoul on the request in PidProcessor,
+ * the sprintf("%s%0<n>lX") of getFormattedResponse and the
+ * addSpacesToResponse loop of OBDSerialComm. In ns per call, fastest of
+ * RUNS, on typical mode 01 requests and responses.
+ */
+
+const uint32_t ITERATIONS = 1000000;
+const uint8_t RUNS = 5;
+
+static const char *const REQUESTS[] = {"0100", "010C", "010D1", "0902"};
+static const uint8_t N_REQUESTS = sizeof(REQUESTS) / sizeof(REQUESTS[0]);
+
+struct Response
+{
+    const char *pid;       // as sent back, ex: "410C"
+    uint8_t pidBytes[2];   // the same, as HexCodec gets it
+    uint32_t value;
+    uint8_t nValueChars;
+    const char *mask;      // as getFormattedResponse built it
+};
+
+static const Response RESPONSES[] = {{"410D", {0x41, 0x0D}, 0x40, 2, "%s%02lX"},
+                                      {"410C", {0x41, 0x0C}, 0x1AF8, 4, "%s%04lX"},
+                                      {"4100", {0x41, 0x00}, 0xBE3EB811, 8, "%s%08lX"}};
+static const uint8_t N_RESPONSES = sizeof(RESPONSES) / sizeof(RESPONSES[0]);
+
+static volatile uint32_t sink; // keeps the compiler from dropping the loops
+static const char *volatile requests[N_REQUESTS]; // read again on every call
+
+static bool isValidHex(const char *pid)
+{
+    return (pid[strspn(pid, "0123456789abcdefABCDEF")] == 0);
+}
+
+static void addSpacesToResponse(const char *response, char spacedRes[])
+{
+    uint8_t len = strlen(response);
+    int j = 0;
+    for (int i = 0; i < len;) {
+        *(spacedRes + j++) = *(response + i++);
+        *(spacedRes + j++) = *(response + i++);
+        if (i < len) {
+            *(spacedRes + j++) = 0x20;
+        }
+    }
+    *(spacedRes + j) = '\0';
+}
+
+static void validateWithStrspn()
+{
+    for (uint8_t i = 0; i < N_REQUESTS; i++)
+    {
+        sink = isValidHex(requests[i]);
+    }
+}
+
+static void validateWithCodec()
+{
+    for (uint8_t i = 0; i < N_REQUESTS; i++)
+    {
+        const char *request = requests[i];
+        sink = HexCodec::isHex(request, strlen(request));
+    }
+}
+
+static void decodeWithStrtoul()
+{
+    for (uint8_t i = 0; i < N_REQUESTS; i++)
+    {
+        sink = strtoul(requests[i], NULL, 16);
+    }
+}
+
+static void decodeWithCodec()
+{
+    uint8_t bytes[4];
+    for (uint8_t i = 0; i < N_REQUESTS; i++)
+    {
+        const char *request = requests[i];
+        sink = HexCodec::decode(request, strlen(request), bytes);
+    }
+}
+
+static void encodeWithSprintf()
+{
+    char response[24];
+    char spaced[36];
+    for (uint8_t i = 0; i < N_RESPONSES; i++)
+    {
+        sprintf(response, RESPONSES[i].mask, RESPONSES[i].pid, (unsigned long)RESPONSES[i].value);
+        addSpacesToResponse(response, spaced);
+        sink = spaced[0];
+    }
+}
+
+static void encodeWithCodec()
+{
+    char spaced[36];
+    for (uint8_t i = 0; i < N_RESPONSES; i++)
+    {
+        const Response &response = RESPONSES[i];
+        uint8_t bytes[6] = {response.pidBytes[0], response.pidBytes[1]};
+        uint8_t nBytes = response.nValueChars / 2;
+        for (uint8_t j = 0; j < nBytes; j++)
+        {
+            bytes[2 + j] = response.value >> (8 * (nBytes - 1 - j));
+        }
+        spaced[HexCodec::encode(bytes, 2 + nBytes, spaced, true)] = '\0';
+        sink = spaced[0];
+    }
+}
+
+static uint64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ns per call of body, which makes nCalls calls
+static double timeCalls(void (*body)(), uint8_t nCalls)
+{
+    uint64_t fastest = UINT64_MAX;
+    for (uint8_t run = 0; run < RUNS; run++)
+    {
+        uint64_t start = nowNs();
+        for (uint32_t i = 0; i < ITERATIONS; i++)
+        {
+            body();
+        }
+        uint64_t elapsed = nowNs() - start;
+        fastest = elapsed < fastest ? elapsed : fastest;
+    }
+    return (double)fastest / ((double)ITERATIONS * nCalls);
+}
+
+static void compare(const char *name, const char *oldName, void (*oldBody)(), void (*codecBody)(), uint8_t nCalls)
+{
+    double oldNs = timeCalls(oldBody, nCalls);
+    double codecNs = timeCalls(codecBody, nCalls);
+    printf("%-9s  %-22s  %7.1f  %8.1f  %6.1fx\n", name, oldName, oldNs, codecNs, codecNs > 0 ? oldNs / codecNs : 0);
+}
+
+int main()
+{
+    for (uint8_t i = 0; i < N_REQUESTS; i++)
+    {
+        requests[i] = REQUESTS[i];
+    }
+    printf("ns per call, fastest of %u runs\n", RUNS);
+    printf("hex        replaced                 before  HexCodec  speedup\n");
+    compare("validate", "strspn", validateWithStrspn, validateWithCodec, N_REQUESTS);
+    compare("decode", "strtoul", decodeWithStrtoul, decodeWithCodec, N_REQUESTS);
+    compare("encode", "sprintf + addSpaces", encodeWithSprintf, encodeWithCodec, N_RESPONSES);
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include <ELMulator.h>
+#include <chrono>
+#include "ReplayStream.h"
+#include "Sessions.h"
+
+/**
+ * Cost of the log level compiled into the library: built once for each
+ * ELM_LOG_LEVEL (elmulator_log_benchmark_0 to _5, all run by the
+ * log_benchmarks target), each printing one row, after the column names
+ * with --header.
+ *
+ * The sessions are replayed as by elmulator_benchmark, the waiting messages
+ * being printed after each request (as poll() does when idle) into a Print
+ * that only counts them. Then messages are queued in batches of half the
+ * ring and printed, to get the cost of each side of a message.
+ */
+
+const uint16_t REPETITIONS = 2000;
+const uint16_t BATCHES = 1000;
+
+// Counts the printed chars and lines
+class CountingPrint : public Print
+{
+public:
+    size_t write(uint8_t c) override
+    {
+        chars++;
+        lines += (c == '\n');
+        return 1;
+    }
+
+    uint32_t chars = 0;
+    uint32_t lines = 0;
+};
+
+static ReplayStream replay;
+static OBDStreamComm transport(replay);
+static ELMulator elm(&transport);
+static CountingPrint logOutput;
+
+static uint64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char **argv)
+{
+    ELMLog::begin(&logOutput);
+    elm.init("host");
+    setUpSessionPids(elm);
+    for (uint8_t i = 0; i < N_SESSIONS; i++)
+    {
+        replay.load(SESSIONS[i]->requests);
+        while (!replay.finished())
+        {
+            elm.poll();
+        }
+    }
+    ELMLog::update();
+    logOutput.lines = 0;
+
+    uint32_t nRequests = 0;
+    uint64_t requestNs = 0;
+    uint64_t printNs = 0;
+    for (uint16_t i = 0; i < REPETITIONS; i++)
+    {
+        for (uint8_t j = 0; j < N_SESSIONS; j++)
+        {
+            replay.load(SESSIONS[j]->requests);
+            while (!replay.finished())
+            {
+                uint64_t start = nowNs();
+                elm.poll();
+                uint64_t end = nowNs();
+                ELMLog::update();
+                requestNs += end - start;
+                printNs += nowNs() - end;
+                nRequests++;
+            }
+            replay.clearOutput();
+        }
+    }
+    uint32_t requestMessages = logOutput.lines;
+
+    // both sides of a message, only when the level has messages at all
+    uint64_t queueNs = 0;
+    uint64_t batchPrintNs = 0;
+    uint32_t nMessages = 0;
+#if ELM_LOG_LEVEL > ELM_LOG_LEVEL_NONE
+    const uint8_t BATCH_SIZE = LOG_RING_SIZE / 2;
+    for (uint16_t i = 0; i < BATCHES; i++)
+    {
+        uint64_t start = nowNs();
+        for (uint8_t j = 0; j < BATCH_SIZE; j++)
+        {
+            ELM_LOG_ERROR("AT command %s, pid %02X", "ATSP0", j);
+        }
+        uint64_t end = nowNs();
+        ELMLog::update();
+        queueNs += end - start;
+        batchPrintNs += nowNs() - end;
+    }
+    nMessages = BATCHES * BATCH_SIZE;
+#endif
+
+    if (argc > 1 && strcmp(argv[1], "--header") == 0)
+    {
+        printf("level  request ns  print ns/req  messages/req  queue ns/msg  print ns/msg  dropped\n");
+    }
+    printf("%5d  %10lu  %12lu  %12.2f  %12lu  %12lu  %7lu\n",
+           ELM_LOG_LEVEL,
+           (unsigned long)(requestNs / nRequests),
+           (unsigned long)(printNs / nRequests),
+           (double)requestMessages / nRequests,
+           (unsigned long)(nMessages > 0 ? queueNs / nMessages : 0),
+           (unsigned long)(nMessages > 0 ? batchPrintNs / nMessages : 0),
+           (unsigned long)ELMLog::getDropped());
+    return 0;
+}
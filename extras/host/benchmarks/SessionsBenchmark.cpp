@@ -0,0 +1,119 @@
+#include <ELMulator.h>
+#include <chrono>
+#include "ReplayTransport.h"
+#include "Sessions.h"
+
+/**
+ * Aggregate throughput of one ELMulator serving 1 to 8 clients at once, as
+ * OBDWiFiComm does: each client of a ReplayTransport replays the Torque
+ * polling session REPETITIONS times, sending a request once it got the
+ * prompt of the previous one.
+ *
+ * For each number of clients: requests/s of all the clients together, ns
+ * per request and polls per request (polls finding no complete request are
+ * the cost of going round the sessions) of the fastest of RUNS runs. Then,
+ * in an untimed replay, the most polls a client waited between two of its
+ * responses: one per other client when the round robin is fair, more if a
+ * session is served several times in a row while others wait.
+ */
+
+const uint16_t REPETITIONS = 2000;
+const uint8_t RUNS = 5; // the fastest is kept
+
+static uint64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void runClients(uint8_t nClients)
+{
+    ReplayTransport transport(nClients);
+    ELMulator elm(&transport);
+    elm.init("host");
+    setUpSessionPids(elm);
+    for (uint8_t i = 0; i < nClients; i++)
+    {
+        transport.reconnect(i, TORQUE_POLLING.requests);
+    }
+    while (!transport.finished())
+    {
+        elm.poll();
+    }
+
+    uint32_t nPolls = UINT32_MAX;
+    uint64_t elapsed = UINT64_MAX;
+    for (uint8_t run = 0; run < RUNS; run++)
+    {
+        uint32_t runPolls = 0;
+        uint64_t start = nowNs();
+        for (uint16_t i = 0; i < REPETITIONS; i++)
+        {
+            for (uint8_t j = 0; j < nClients; j++)
+            {
+                transport.getStream(j).load(TORQUE_POLLING.requests);
+                transport.getStream(j).clearOutput();
+            }
+            while (!transport.finished())
+            {
+                runPolls++;
+                elm.poll();
+            }
+        }
+        uint64_t runNs = nowNs() - start;
+        if (runNs < elapsed)
+        {
+            elapsed = runNs;
+            nPolls = runPolls;
+        }
+    }
+    uint32_t nRequests = (uint32_t)countRequests(TORQUE_POLLING.requests) * REPETITIONS * nClients;
+
+    // one write per response, a client waits from its last response until the next
+    uint32_t writes[ReplayTransport::MAX_SESSIONS];
+    uint32_t waiting[ReplayTransport::MAX_SESSIONS];
+    for (uint8_t j = 0; j < nClients; j++)
+    {
+        transport.getStream(j).load(TORQUE_POLLING.requests);
+        transport.getStream(j).clearOutput();
+        writes[j] = transport.getStream(j).writes;
+        waiting[j] = 0;
+    }
+    uint32_t maxWait = 0;
+    while (!transport.finished())
+    {
+        elm.poll();
+        for (uint8_t j = 0; j < nClients; j++)
+        {
+            ReplayStream &stream = transport.getStream(j);
+            if (stream.writes != writes[j])
+            {
+                writes[j] = stream.writes;
+                waiting[j] = 0;
+            }
+            else if (!stream.finished())
+            {
+                waiting[j]++;
+                maxWait = waiting[j] > maxWait ? waiting[j] : maxWait;
+            }
+        }
+    }
+
+    printf("%7u  %8lu  %9lu  %6lu  %9.2f  %8lu\n",
+           nClients,
+           (unsigned long)nRequests,
+           (unsigned long)(elapsed > 0 ? (uint64_t)nRequests * 1000000000 / elapsed : 0),
+           (unsigned long)(elapsed / nRequests),
+           (double)nPolls / nRequests,
+           (unsigned long)maxWait);
+}
+
+int main()
+{
+    printf("%u replays of Torque polling by each client, fastest of %u runs\n", REPETITIONS, RUNS);
+    printf("clients  requests      req/s  ns/req  polls/req  max wait\n");
+    for (uint8_t i = 1; i <= ReplayTransport::MAX_SESSIONS; i++)
+    {
+        runClients(i);
+    }
+    return 0;
+}
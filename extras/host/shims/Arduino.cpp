@@ -0,0 +1,55 @@
+#include "Arduino.h"
+
+#include <time.h>
+
+HardwareSerial Serial;
+
+static uint64_t nowUs()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static const uint64_t START_US = nowUs();
+
+unsigned long millis()
+{
+    return (nowUs() - START_US) / 1000;
+}
+
+unsigned long micros()
+{
+    return nowUs() - START_US;
+}
+
+void delay(unsigned long ms)
+{
+    timespec duration = {(time_t)(ms / 1000), (long)(ms % 1000) * 1000000};
+    nanosleep(&duration, nullptr);
+}
+
+void yield()
+{
+}
+
+char *itoa(int value, char *text, int base)
+{
+    sprintf(text, base == 16 ? "%x" : "%d", value);
+    return text;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush()
+{
+    fflush(stdout);
+}
@@ -0,0 +1,69 @@
+#ifndef ELMulator_host_Arduino_h
+#define ELMulator_host_Arduino_h
+
+/**
+ * Just enough of the Arduino core to build ELMulator on Linux, see
+ * extras/host/CMakeLists.txt. ARDUINO_ARCH_ESP32 is not defined, so the
+ * library builds as it does for other boards: no Bluetooth/WiFi transports,
+ * FreeRTOS tasks or file system.
+ */
+
+#include <ctype.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+
+using std::max;
+using std::min;
+
+// Time since the program started, from the monotonic clock
+unsigned long millis();
+unsigned long micros();
+
+void delay(unsigned long ms);
+
+void yield();
+
+char *itoa(int value, char *text, int base);
+
+inline int toUpperCase(int c) { return toupper(c); }
+
+// Serial console: writes go to stdout, nothing is ever received
+class HardwareSerial : public Stream
+{
+public:
+    void begin(unsigned long baud) {}
+
+    size_t write(uint8_t c) override;
+
+    size_t write(const uint8_t *buffer, size_t size) override;
+
+    using Print::write;
+
+    int available() override { return 0; }
+
+    int read() override { return -1; }
+
+    int peek() override { return -1; }
+
+    void flush() override;
+
+    operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif
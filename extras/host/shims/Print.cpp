@@ -0,0 +1,47 @@
+#include "Print.h"
+
+#include <stdio.h>
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size-- > 0)
+    {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::print(long value, int base)
+{
+    if (base == DEC)
+    {
+        char text[24];
+        return write(text, snprintf(text, sizeof(text), "%ld", value));
+    }
+    return print((unsigned long)value, base);
+}
+
+// base 2 to 16, upper case digits as on Arduino
+size_t Print::print(unsigned long value, int base)
+{
+    static const char DIGITS[] = "0123456789ABCDEF";
+    if (base < 2 || base > 16)
+    {
+        base = DEC;
+    }
+    char text[8 * sizeof(unsigned long) + 1];
+    char *digit = text + sizeof(text);
+    do
+    {
+        *--digit = DIGITS[value % base];
+        value /= base;
+    } while (value > 0);
+    return write(digit, text + sizeof(text) - digit);
+}
+
+size_t Print::print(double value, int decimals)
+{
+    char text[40];
+    return write(text, snprintf(text, sizeof(text), "%.*f", decimals, value));
+}
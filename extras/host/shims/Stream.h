@@ -0,0 +1,32 @@
+#ifndef ELMulator_host_Stream_h
+#define ELMulator_host_Stream_h
+
+#include "Print.h"
+
+// Arduino Stream for host builds, without the blocking parsing helpers
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+
+    virtual int read() = 0;
+
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeout) {}
+
+    size_t readBytes(uint8_t *buffer, size_t length)
+    {
+        size_t n = 0;
+        int c;
+        while (n < length && (c = read()) >= 0)
+        {
+            buffer[n++] = c;
+        }
+        return n;
+    }
+
+    size_t readBytes(char *buffer, size_t length) { return readBytes((uint8_t *)buffer, length); }
+};
+
+#endif
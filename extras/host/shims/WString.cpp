@@ -0,0 +1,286 @@
+#include "WString.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+String::String(const char *text) : buffer(nullptr), capacity(0), len(0)
+{
+    if (text != nullptr)
+    {
+        copy(text, strlen(text));
+    }
+}
+
+String::String(const String &other) : buffer(nullptr), capacity(0), len(0)
+{
+    copy(other.c_str(), other.len);
+}
+
+String::String(char c) : buffer(nullptr), capacity(0), len(0)
+{
+    copy(&c, 1);
+}
+
+static const char *numberFormat(unsigned char base, const char *decimal, const char *hex)
+{
+    return base == 16 ? hex : decimal;
+}
+
+String::String(int value, unsigned char base) : buffer(nullptr), capacity(0), len(0)
+{
+    char text[24];
+    copy(text, snprintf(text, sizeof(text), numberFormat(base, "%d", "%x"), value));
+}
+
+String::String(unsigned int value, unsigned char base) : buffer(nullptr), capacity(0), len(0)
+{
+    char text[24];
+    copy(text, snprintf(text, sizeof(text), numberFormat(base, "%u", "%x"), value));
+}
+
+String::String(long value, unsigned char base) : buffer(nullptr), capacity(0), len(0)
+{
+    char text[24];
+    copy(text, snprintf(text, sizeof(text), numberFormat(base, "%ld", "%lx"), value));
+}
+
+String::String(unsigned long value, unsigned char base) : buffer(nullptr), capacity(0), len(0)
+{
+    char text[24];
+    copy(text, snprintf(text, sizeof(text), numberFormat(base, "%lu", "%lx"), value));
+}
+
+String::String(double value, unsigned char decimals) : buffer(nullptr), capacity(0), len(0)
+{
+    char text[40];
+    copy(text, snprintf(text, sizeof(text), "%.*f", decimals, value));
+}
+
+String::~String()
+{
+    free(buffer);
+}
+
+String &String::operator=(const String &other)
+{
+    if (this != &other)
+    {
+        copy(other.c_str(), other.len);
+    }
+    return *this;
+}
+
+String &String::operator=(const char *text)
+{
+    copy(text != nullptr ? text : "", text != nullptr ? strlen(text) : 0);
+    return *this;
+}
+
+bool String::reserve(unsigned int size)
+{
+    if (buffer != nullptr && capacity >= size)
+    {
+        return true;
+    }
+    char *grown = (char *)realloc(buffer, size + 1);
+    if (grown == nullptr)
+    {
+        return false;
+    }
+    if (buffer == nullptr)
+    {
+        grown[0] = '\0';
+    }
+    buffer = grown;
+    capacity = size;
+    return true;
+}
+
+void String::copy(const char *text, unsigned int length)
+{
+    if (length == 0 && buffer == nullptr)
+    {
+        len = 0;
+        return;
+    }
+    if (!reserve(length))
+    {
+        return;
+    }
+    memmove(buffer, text, length);
+    buffer[length] = '\0';
+    len = length;
+}
+
+bool String::append(const char *text, unsigned int length)
+{
+    if (length == 0)
+    {
+        return true;
+    }
+    if (!reserve(len + length))
+    {
+        return false;
+    }
+    memmove(buffer + len, text, length);
+    len += length;
+    buffer[len] = '\0';
+    return true;
+}
+
+bool String::concat(const String &other)
+{
+    return append(other.c_str(), other.len);
+}
+
+bool String::concat(const char *text)
+{
+    return text != nullptr && append(text, strlen(text));
+}
+
+bool String::concat(char c)
+{
+    return append(&c, 1);
+}
+
+bool String::equals(const String &other) const
+{
+    return len == other.len && strcmp(c_str(), other.c_str()) == 0;
+}
+
+bool String::equals(const char *text) const
+{
+    return strcmp(c_str(), text != nullptr ? text : "") == 0;
+}
+
+bool String::startsWith(const String &prefix) const
+{
+    return startsWith(prefix, 0);
+}
+
+bool String::startsWith(const String &prefix, unsigned int offset) const
+{
+    return offset + prefix.len <= len && strncmp(c_str() + offset, prefix.c_str(), prefix.len) == 0;
+}
+
+bool String::endsWith(const String &suffix) const
+{
+    return suffix.len <= len && strcmp(c_str() + len - suffix.len, suffix.c_str()) == 0;
+}
+
+char String::charAt(unsigned int index) const
+{
+    return index < len ? buffer[index] : '\0';
+}
+
+int String::indexOf(char c, unsigned int from) const
+{
+    if (from >= len)
+    {
+        return -1;
+    }
+    const char *found = strchr(buffer + from, c);
+    return found != nullptr ? found - buffer : -1;
+}
+
+int String::indexOf(const String &text, unsigned int from) const
+{
+    if (from >= len)
+    {
+        return -1;
+    }
+    const char *found = strstr(buffer + from, text.c_str());
+    return found != nullptr ? found - buffer : -1;
+}
+
+String String::substring(unsigned int from) const
+{
+    return substring(from, len);
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+    if (from > to)
+    {
+        unsigned int swap = from;
+        from = to;
+        to = swap;
+    }
+    String result;
+    if (from < len)
+    {
+        result.copy(buffer + from, (to < len ? to : len) - from);
+    }
+    return result;
+}
+
+void String::toUpperCase()
+{
+    for (unsigned int i = 0; i < len; i++)
+    {
+        buffer[i] = toupper((unsigned char)buffer[i]);
+    }
+}
+
+void String::toLowerCase()
+{
+    for (unsigned int i = 0; i < len; i++)
+    {
+        buffer[i] = tolower((unsigned char)buffer[i]);
+    }
+}
+
+void String::trim()
+{
+    unsigned int start = 0;
+    while (start < len && isspace((unsigned char)buffer[start]))
+    {
+        start++;
+    }
+    unsigned int end = len;
+    while (end > start && isspace((unsigned char)buffer[end - 1]))
+    {
+        end--;
+    }
+    if (start > 0 || end < len)
+    {
+        memmove(buffer, buffer + start, end - start);
+        len = end - start;
+        buffer[len] = '\0';
+    }
+}
+
+long String::toInt() const
+{
+    return atol(c_str());
+}
+
+String operator+(const String &left, const String &right)
+{
+    String result(left);
+    result.concat(right);
+    return result;
+}
+
+String operator+(const String &left, const char *right)
+{
+    String result(left);
+    result.concat(right);
+    return result;
+}
+
+String operator+(const char *left, const String &right)
+{
+    String result(left);
+    result.concat(right);
+    return result;
+}
+
+String operator+(const String &left, char right)
+{
+    String result(left);
+    result.concat(right);
+    return result;
+}
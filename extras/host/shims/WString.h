@@ -0,0 +1,75 @@
+#ifndef ELMulator_host_WString_h
+#define ELMulator_host_WString_h
+
+#include <stddef.h>
+
+/**
+ * Arduino String for host builds. Like the core's, the buffer comes from
+ * malloc/realloc and grows as needed; there is no small string optimisation
+ * (as on AVR), so every non empty String shows up in the heap counters.
+ */
+class String
+{
+public:
+    String(const char *text = "");
+    String(const String &other);
+    explicit String(char c);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(double value, unsigned char decimals = 2);
+    ~String();
+
+    String &operator=(const String &other);
+    String &operator=(const char *text);
+
+    bool reserve(unsigned int size);
+    unsigned int length() const { return len; }
+    const char *c_str() const { return buffer != nullptr ? buffer : ""; }
+
+    bool concat(const String &other);
+    bool concat(const char *text);
+    bool concat(char c);
+    String &operator+=(const String &other) { concat(other); return *this; }
+    String &operator+=(const char *text) { concat(text); return *this; }
+    String &operator+=(char c) { concat(c); return *this; }
+
+    bool equals(const String &other) const;
+    bool equals(const char *text) const;
+    bool operator==(const String &other) const { return equals(other); }
+    bool operator==(const char *text) const { return equals(text); }
+    bool operator!=(const String &other) const { return !equals(other); }
+    bool operator!=(const char *text) const { return !equals(text); }
+
+    bool startsWith(const String &prefix) const;
+    bool startsWith(const String &prefix, unsigned int offset) const;
+    bool endsWith(const String &suffix) const;
+
+    char charAt(unsigned int index) const;
+    char operator[](unsigned int index) const { return charAt(index); }
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String &text, unsigned int from = 0) const;
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+
+    void toUpperCase();
+    void toLowerCase();
+    void trim();
+    long toInt() const;
+
+private:
+    char *buffer;
+    unsigned int capacity;
+    unsigned int len;
+
+    bool append(const char *text, unsigned int length);
+    void copy(const char *text, unsigned int length);
+};
+
+String operator+(const String &left, const String &right);
+String operator+(const String &left, const char *right);
+String operator+(const char *left, const String &right);
+String operator+(const String &left, char right);
+
+#endif
@@ -0,0 +1,89 @@
+#include "HeapCounter.h"
+
+#include <stdlib.h>
+#include <new>
+
+static uint32_t allocations = 0;
+static uint32_t frees = 0;
+
+uint32_t HeapCounter::getAllocations()
+{
+    return allocations;
+}
+
+uint32_t HeapCounter::getFrees()
+{
+    return frees;
+}
+
+extern "C"
+{
+    void *__real_malloc(size_t size);
+    void *__real_calloc(size_t n, size_t size);
+    void *__real_realloc(void *pointer, size_t size);
+    void __real_free(void *pointer);
+
+    void *__wrap_malloc(size_t size)
+    {
+        allocations++;
+        return __real_malloc(size);
+    }
+
+    void *__wrap_calloc(size_t n, size_t size)
+    {
+        allocations++;
+        return __real_calloc(n, size);
+    }
+
+    // growing a buffer may move it, so it counts as an allocation
+    void *__wrap_realloc(void *pointer, size_t size)
+    {
+        allocations++;
+        return __real_realloc(pointer, size);
+    }
+
+    void __wrap_free(void *pointer)
+    {
+        if (pointer != nullptr)
+        {
+            frees++;
+        }
+        __real_free(pointer);
+    }
+}
+
+// compiled with the wraps, so these malloc/free calls are counted too
+void *operator new(size_t size)
+{
+    void *pointer = malloc(size);
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete(void *pointer, size_t size) noexcept
+{
+    free(pointer);
+}
+
+void operator delete[](void *pointer, size_t size) noexcept
+{
+    free(pointer);
+}
@@ -0,0 +1,23 @@
+#ifndef ELMulator_host_HeapCounter_h
+#define ELMulator_host_HeapCounter_h
+
+#include <stdint.h>
+
+/**
+ * Counts the heap calls of the whole program: malloc, calloc, realloc and
+ * free are wrapped at link time (-Wl,--wrap, see CMakeLists.txt) and
+ * operator new/delete go through them, so Arduino String buffers and
+ * objects are both counted. Compare the counts before and after the code
+ * being measured.
+ */
+class HeapCounter
+{
+public:
+    // malloc, calloc and realloc calls (new included)
+    static uint32_t getAllocations();
+
+    // free calls with a non null pointer (delete included)
+    static uint32_t getFrees();
+};
+
+#endif
@@ -0,0 +1,145 @@
+#include "ReplayStream.h"
+#include <definitions.h>
+#include <time.h>
+
+static uint64_t nowNs()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+ReplayStream::ReplayStream()
+{
+    writes = 0;
+    bytesWritten = 0;
+    flushes = 0;
+    timed = false;
+    packetNs = 0;
+    byteNs = 0;
+    load("");
+    clearOutput();
+    clearLatencies();
+}
+
+void ReplayStream::load(const char *session)
+{
+    this->session = session;
+    length = strlen(session);
+    rewind();
+}
+
+void ReplayStream::rewind()
+{
+    position = 0;
+    linkFreeNs = 0;
+    nextRequestNs = 0;
+    waitingForPrompt = false;
+}
+
+void ReplayStream::setLink(uint32_t packetUs, float byteUs)
+{
+    timed = true;
+    packetNs = packetUs * 1000;
+    byteNs = (uint32_t)(byteUs * 1000);
+}
+
+bool ReplayStream::finished()
+{
+    return position >= length && !waitingForPrompt;
+}
+
+int ReplayStream::available()
+{
+    // the client waits for the prompt before sending the next request
+    if (waitingForPrompt || (nextRequestNs > 0 && nowNs() < nextRequestNs))
+    {
+        return 0;
+    }
+    return length - position;
+}
+
+int ReplayStream::read()
+{
+    if (available() <= 0)
+    {
+        return -1;
+    }
+    char c = session[position++];
+    if (c == SERIAL_END_CHAR)
+    {
+        requestEndNs = timed ? nowNs() : 0;
+        waitingForPrompt = true;
+    }
+    return (uint8_t)c;
+}
+
+int ReplayStream::peek()
+{
+    return available() > 0 ? (uint8_t)session[position] : -1;
+}
+
+size_t ReplayStream::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t ReplayStream::write(const uint8_t *buffer, size_t size)
+{
+    writes++;
+    bytesWritten += size;
+    size_t kept = size < (size_t)(OUTPUT_SIZE - outputLength) ? size : OUTPUT_SIZE - outputLength;
+    memcpy(output + outputLength, buffer, kept);
+    outputLength += kept;
+    output[outputLength] = '\0';
+
+    if (timed)
+    {
+        uint64_t now = nowNs();
+        linkFreeNs = (linkFreeNs > now ? linkFreeNs : now) + packetNs + (uint64_t)size * byteNs;
+    }
+    if (waitingForPrompt && memchr(buffer, '>', size) != nullptr)
+    {
+        waitingForPrompt = false;
+        nextRequestNs = linkFreeNs;
+        if (timed && nLatencies < MAX_LATENCIES)
+        {
+            latencies[nLatencies++] = linkFreeNs - requestEndNs;
+        }
+    }
+    return size;
+}
+
+void ReplayStream::flush()
+{
+    flushes++;
+    while (timed && nowNs() < linkFreeNs)
+    {
+    }
+}
+
+const char *ReplayStream::getOutput()
+{
+    return output;
+}
+
+void ReplayStream::clearOutput()
+{
+    outputLength = 0;
+    output[0] = '\0';
+}
+
+const uint32_t *ReplayStream::getLatencies()
+{
+    return latencies;
+}
+
+uint32_t ReplayStream::getLatencyCount()
+{
+    return nLatencies;
+}
+
+void ReplayStream::clearLatencies()
+{
+    nLatencies = 0;
+}
@@ -0,0 +1,86 @@
+#ifndef ELMulator_host_ReplayStream_h
+#define ELMulator_host_ReplayStream_h
+
+#include <Arduino.h>
+
+/**
+ * In memory Stream playing a client session (requests separated by '\r')
+ * into OBDStreamComm. Written bytes are counted and kept in a fixed buffer
+ * (the first OUTPUT_SIZE of them since clearOutput), so reading the
+ * responses allocates nothing.
+ *
+ * With a link (setLink), each write is a packet taking packetUs plus byteUs
+ * per byte to go through, one after the other, flush() waits until they
+ * are all through, and the client sends its next request only once it got
+ * the '>' prompt. The time from the end of a request to the arrival of its
+ * prompt is kept for each request (getLatencies).
+ */
+class ReplayStream : public Stream
+{
+public:
+    static const uint16_t OUTPUT_SIZE = 4096;
+    static const uint32_t MAX_LATENCIES = 65536;
+
+    ReplayStream();
+
+    // Plays session from the start, it must outlive the playback
+    void load(const char *session);
+
+    void rewind();
+
+    // Link the packets go through, 0, 0 to only time the requests (nothing is timed by default)
+    void setLink(uint32_t packetUs, float byteUs);
+
+    // The whole session was read and answered
+    bool finished();
+
+    int available() override;
+
+    int read() override;
+
+    int peek() override;
+
+    size_t write(uint8_t c) override;
+
+    size_t write(const uint8_t *buffer, size_t size) override;
+
+    void flush() override;
+
+    using Print::write;
+
+    // Responses written since the last clearOutput, null terminated
+    const char *getOutput();
+
+    void clearOutput();
+
+    // Request end to prompt arrival in ns, one per request since clearLatencies
+    const uint32_t *getLatencies();
+
+    uint32_t getLatencyCount();
+
+    void clearLatencies();
+
+    // each write is a packet on a Bluetooth or TCP transport
+    uint32_t writes;
+    uint32_t bytesWritten;
+    uint32_t flushes;
+
+private:
+    const char *session;
+    size_t position;
+    size_t length;
+    char output[OUTPUT_SIZE + 1];
+    uint16_t outputLength;
+
+    bool timed;
+    uint32_t packetNs;
+    uint32_t byteNs;
+    uint64_t linkFreeNs;   // when the packets written so far are through
+    uint64_t requestEndNs; // when the '\r' of the pending request was read
+    uint64_t nextRequestNs;
+    bool waitingForPrompt;
+    uint32_t latencies[MAX_LATENCIES];
+    uint32_t nLatencies;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include "ReplayTransport.h"
+
+ReplayTransport::ReplayTransport(uint8_t nSessions)
+{
+    this->nSessions = nSessions < MAX_SESSIONS ? nSessions : MAX_SESSIONS;
+    session = 0;
+    for (uint8_t i = 0; i < MAX_SESSIONS; i++)
+    {
+        clientConnected[i] = true;
+        connectionIds[i] = 1;
+    }
+}
+
+ReplayStream &ReplayTransport::getStream(uint8_t session)
+{
+    return streams[session];
+}
+
+void ReplayTransport::disconnect(uint8_t session)
+{
+    clientConnected[session] = false;
+}
+
+void ReplayTransport::reconnect(uint8_t session, const char *requests)
+{
+    streams[session].load(requests);
+    streams[session].clearOutput();
+    clientConnected[session] = true;
+    connectionIds[session]++;
+}
+
+bool ReplayTransport::finished()
+{
+    for (uint8_t i = 0; i < nSessions; i++)
+    {
+        if (clientConnected[i] && !streams[i].finished())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ReplayTransport::init(const String &deviceName)
+{
+}
+
+bool ReplayTransport::connected()
+{
+    return clientConnected[session];
+}
+
+int ReplayTransport::available()
+{
+    return streams[session].available();
+}
+
+int ReplayTransport::read()
+{
+    return streams[session].read();
+}
+
+size_t ReplayTransport::write(const uint8_t *data, size_t length)
+{
+    return streams[session].write(data, length);
+}
+
+void ReplayTransport::flush()
+{
+    streams[session].flush();
+}
+
+uint8_t ReplayTransport::getMaxSessions()
+{
+    return nSessions;
+}
+
+void ReplayTransport::selectSession(uint8_t session)
+{
+    this->session = session;
+}
+
+uint16_t ReplayTransport::getConnectionId()
+{
+    return connectionIds[session];
+}
@@ -0,0 +1,57 @@
+#ifndef ELMulator_host_ReplayTransport_h
+#define ELMulator_host_ReplayTransport_h
+
+#include <OBDTransport.h>
+#include "ReplayStream.h"
+
+/**
+ * In memory transport with several sessions, as OBDWiFiComm with one client
+ * per session, each client playing a session of its own ReplayStream.
+ * Clients can be disconnected and replaced, as a disconnect followed by an
+ * accept in the same update().
+ */
+class ReplayTransport : public OBDTransport
+{
+public:
+    static const uint8_t MAX_SESSIONS = 8;
+
+    // All nSessions clients connected
+    ReplayTransport(uint8_t nSessions);
+
+    ReplayStream &getStream(uint8_t session);
+
+    void disconnect(uint8_t session);
+
+    // A new client on session, playing requests
+    void reconnect(uint8_t session, const char *requests);
+
+    // Every session was read and answered
+    bool finished();
+
+    void init(const String &deviceName) override;
+
+    bool connected() override;
+
+    int available() override;
+
+    int read() override;
+
+    size_t write(const uint8_t *data, size_t length) override;
+
+    void flush() override;
+
+    uint8_t getMaxSessions() override;
+
+    void selectSession(uint8_t session) override;
+
+    uint16_t getConnectionId() override;
+
+private:
+    ReplayStream streams[MAX_SESSIONS];
+    bool clientConnected[MAX_SESSIONS];
+    uint16_t connectionIds[MAX_SESSIONS];
+    uint8_t nSessions;
+    uint8_t session;
+};
+
+#endif
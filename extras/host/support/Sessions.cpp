@@ -0,0 +1,40 @@
+#include "Sessions.h"
+
+// Torque Pro connecting to the adapter
+const RecordedSession TORQUE_INIT = {"Torque init", "ATZ\rATE0\rATM0\rATL0\rATS0\rATH0\rATAT1\rATSP0\rATDPN\r0100\r0120\r0140\r0160\rATDESC\rATRV\r"};
+
+// Torque Pro polling a dashboard, with the expected response count
+const RecordedSession TORQUE_POLLING = {"Torque polling", "010C1\r010D1\r01051\r010F1\r01111\r01041\r010B1\r010C1\r010D1\r"};
+
+// Requests of the ESP32_Test_Long_Response example, multi frame responses
+const RecordedSession LONG_RESPONSE = {"Long response", "017A\r0100204060\r010C0D11050F04\r0101\r"};
+
+// Car Scanner batching pids with spaces and line feeds on
+const RecordedSession CAR_SCANNER = {"Car Scanner", "ATL1\rATS1\r01 0C 0D 11 05\r01 04 0F 0B\r01 0C 0D 11 05\r01 04 0F 0B\r"};
+
+// Mode 22 and unsupported modes, answered with NO DATA
+const RecordedSession OTHER_MODES = {"Other modes", "2218E4\r0902\r221234\r0600\r"};
+
+const RecordedSession *const SESSIONS[] = {&TORQUE_INIT, &TORQUE_POLLING, &LONG_RESPONSE, &CAR_SCANNER, &OTHER_MODES};
+const uint8_t N_SESSIONS = sizeof(SESSIONS) / sizeof(SESSIONS[0]);
+
+static uint32_t readRpm(uint16_t pid)
+{
+    return 0x1AF8;
+}
+
+void setUpSessionPids(ELMulator &elm)
+{
+    elm.registerPids(SERVICE_01, SESSION_PIDS);
+    elm.registerMode01Pid(ENGINE_RPM, readRpm);
+}
+
+uint16_t countRequests(const char *requests)
+{
+    uint16_t n = 0;
+    for (const char *c = requests; *c != '\0'; c++)
+    {
+        n += (*c == SERIAL_END_CHAR);
+    }
+    return n;
+}
@@ -0,0 +1,34 @@
+#ifndef ELMulator_host_Sessions_h
+#define ELMulator_host_Sessions_h
+
+#include <ELMulator.h>
+
+// Recorded client session, one request per '\r' as sent by the client
+struct RecordedSession
+{
+    const char *name;
+    const char *requests;
+};
+
+// Same sessions as the ELMulator_Benchmark example
+extern const RecordedSession TORQUE_INIT;
+extern const RecordedSession TORQUE_POLLING;
+extern const RecordedSession LONG_RESPONSE;
+extern const RecordedSession CAR_SCANNER;
+extern const RecordedSession OTHER_MODES;
+
+extern const RecordedSession *const SESSIONS[];
+extern const uint8_t N_SESSIONS;
+
+// PIDs polled by the sessions, see setUpSessionPids
+constexpr SupportedPids SESSION_PIDS = makeSupportedPids(ENGINE_LOAD, ENGINE_COOLANT_TEMP, ENGINE_RPM, VEHICLE_SPEED,
+                                                         INTAKE_MANIFOLD_ABS_PRESSURE, INTAKE_AIR_TEMP, THROTTLE_POSITION,
+                                                         MONITOR_STATUS_SINCE_DTC_CLEARED, 0x7A);
+
+// Registers SESSION_PIDS, RPM with a handler so the handler table is used too
+void setUpSessionPids(ELMulator &elm);
+
+// Number of requests in a session
+uint16_t countRequests(const char *requests);
+
+#endif
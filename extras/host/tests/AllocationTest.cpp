@@ -0,0 +1,91 @@
+#include <ELMulator.h>
+#include "HeapCounter.h"
+#include "HostTest.h"
+#include "ReplayStream.h"
+#include "Sessions.h"
+
+/**
+ * Mode 01 and AT requests are answered from fixed buffers: once the first
+ * replay has warmed up, no request of these sessions may touch the heap.
+ */
+
+// AT commands of the Torque, Car Scanner and ELMduino init sequences, and the settings they toggle
+static const char AT_REQUESTS[] = "ATZ\rATWS\rATD\rATE0\rATE1\rATM0\rATL0\rATL1\rATS0\rATS1\rATH0\rATH1\rATAT1\r"
+                                  "ATAT2\rATSP0\rATSP6\rATSPA6\rATTP6\rATDP\rATDPN\rATST32\rATCAF0\rATCAF1\r"
+                                  "ATSH7E0\rATSH7DF\rATCRA7E8\rATAR\rATD0\rATD1\rATI\rATDESC\rAT@1\rATRV\rATPC\r";
+
+static ReplayStream replay;
+static OBDStreamComm transport(replay);
+static ELMulator elm(&transport);
+
+static void setUp()
+{
+    static bool done = false;
+    if (!done)
+    {
+        elm.init("host");
+        setUpSessionPids(elm);
+        done = true;
+    }
+}
+
+// Replays requests twice, the second time checking each request allocates nothing
+static void checkNoAllocation(const char *requests, ELMRequest::TYPE type)
+{
+    setUp();
+    replay.load(requests);
+    for (uint8_t pass = 0; pass < 2; pass++)
+    {
+        replay.rewind();
+        while (!replay.finished())
+        {
+            uint32_t allocations = HeapCounter::getAllocations();
+            uint32_t frees = HeapCounter::getFrees();
+            elm.poll();
+            if (pass == 1)
+            {
+                CHECK_EQUAL(type, elm.getRequest().type);
+                CHECK_EQUAL(0, HeapCounter::getAllocations() - allocations);
+                CHECK_EQUAL(0, HeapCounter::getFrees() - frees);
+            }
+        }
+        replay.clearOutput();
+    }
+}
+
+TEST(atCommandsDoNotAllocate)
+{
+    checkNoAllocation(AT_REQUESTS, ELMRequest::AT);
+}
+
+TEST(mode01DoesNotAllocate)
+{
+    checkNoAllocation(TORQUE_POLLING.requests, ELMRequest::PID);
+    checkNoAllocation(LONG_RESPONSE.requests, ELMRequest::PID);
+    // spaces, line feeds and headers on
+    checkNoAllocation("ATL1\rATS1\rATH1\r", ELMRequest::AT);
+    checkNoAllocation(CAR_SCANNER.requests + 10, ELMRequest::PID);
+    checkNoAllocation("010C\r010C\r\r0100\r", ELMRequest::PID);
+}
+
+TEST(sessionsDoNotAllocate)
+{
+    setUp();
+    for (uint8_t i = 0; i < N_SESSIONS; i++)
+    {
+        replay.load(SESSIONS[i]->requests);
+        replay.rewind();
+        while (!replay.finished())
+        {
+            elm.poll();
+        }
+        replay.rewind();
+        uint32_t allocations = HeapCounter::getAllocations();
+        while (!replay.finished())
+        {
+            elm.poll();
+        }
+        CHECK_EQUAL(0, HeapCounter::getAllocations() - allocations);
+        replay.clearOutput();
+    }
+}
@@ -0,0 +1,89 @@
+#include <DtcStore.h>
+#include <string.h>
+#include "HostTest.h"
+
+TEST(encodesCodes)
+{
+    uint16_t dtc = 0;
+    CHECK(DtcStore::encode("P0301", dtc));
+    CHECK_EQUAL(0x0301, dtc);
+    CHECK(DtcStore::encode("C1234", dtc));
+    CHECK_EQUAL(0x5234, dtc);
+    CHECK(DtcStore::encode("b0001", dtc));
+    CHECK_EQUAL(0x8001, dtc);
+    CHECK(DtcStore::encode("U0100", dtc));
+    CHECK_EQUAL(0xC100, dtc);
+    CHECK(DtcStore::encode("P3FFF", dtc));
+    CHECK_EQUAL(0x3FFF, dtc);
+}
+
+TEST(rejectsInvalidCodes)
+{
+    uint16_t dtc = 0x1234;
+    CHECK(!DtcStore::encode("", dtc));
+    CHECK(!DtcStore::encode("X0301", dtc));
+    CHECK(!DtcStore::encode("P4301", dtc)); // second char is 2 bits
+    CHECK(!DtcStore::encode("P03G1", dtc));
+    CHECK(!DtcStore::encode("P030", dtc));
+    CHECK(!DtcStore::encode("P03011", dtc));
+    CHECK_EQUAL(0x1234, dtc);
+}
+
+TEST(decodeIsTheReverseOfEncode)
+{
+    for (uint32_t dtc = 0; dtc <= 0xFFFF; dtc++)
+    {
+        char code[6];
+        DtcStore::decode(dtc, code);
+        uint16_t encoded = 0;
+        CHECK(DtcStore::encode(code, encoded));
+        CHECK_EQUAL(dtc, encoded);
+    }
+    char code[6];
+    DtcStore::decode(0xC100, code);
+    CHECK_STRING("U0100", code);
+}
+
+TEST(keepsListsAndMil)
+{
+    DtcStore store;
+    CHECK(!store.isMilOn());
+    CHECK(store.add("P0301"));
+    CHECK(store.add("P0420"));
+    CHECK(store.add("P0301")); // already there
+    CHECK(store.add("P0171", DtcStore::PENDING));
+    CHECK_EQUAL(2, store.getCount(DtcStore::STORED));
+    CHECK_EQUAL(1, store.getCount(DtcStore::PENDING));
+    CHECK_EQUAL(0x0420, store.getDtc(DtcStore::STORED, 1));
+    CHECK(store.isMilOn());
+
+    store.setMonitorStatus(0x076504);
+    CHECK_EQUAL(0x82076504, store.getMonitorStatus());
+
+    uint8_t payload[DTC_RESPONSE_SIZE];
+    CHECK_EQUAL(6, store.getResponse(DtcStore::STORED, payload));
+    const uint8_t expected[] = {0x43, 0x02, 0x03, 0x01, 0x04, 0x20};
+    CHECK(memcmp(expected, payload, sizeof(expected)) == 0);
+
+    CHECK(store.remove("P0301"));
+    CHECK(!store.remove("P0301"));
+    CHECK_EQUAL(0x0420, store.getDtc(DtcStore::STORED, 0));
+
+    store.add("P1234", DtcStore::PERMANENT);
+    store.clear();
+    CHECK_EQUAL(0, store.getCount(DtcStore::STORED));
+    CHECK_EQUAL(0, store.getCount(DtcStore::PENDING));
+    CHECK_EQUAL(1, store.getCount(DtcStore::PERMANENT));
+    CHECK(!store.isMilOn());
+}
+
+TEST(listsAreBounded)
+{
+    DtcStore store;
+    for (uint16_t i = 0; i < MAX_DTCS; i++)
+    {
+        CHECK(store.add(0x0100 + i));
+    }
+    CHECK(!store.add(0x0200));
+    CHECK_EQUAL(MAX_DTCS, store.getCount(DtcStore::STORED));
+}
@@ -0,0 +1,129 @@
+#include <ELMRequest.h>
+#include <string.h>
+#include "HostTest.h"
+
+static ELMRequest request;
+
+static ELMRequest::TYPE parse(const char *line)
+{
+    return request.parse(line, strlen(line));
+}
+
+TEST(parsesModeAndPid)
+{
+    CHECK_EQUAL(ELMRequest::PID, parse("010C"));
+    CHECK_EQUAL(0x01, request.mode);
+    CHECK_EQUAL(0x0C, request.pid);
+    CHECK_EQUAL(1, request.pidBytes);
+    CHECK_EQUAL(1, request.pidCount);
+    CHECK_EQUAL(0x0C, request.pids[0]);
+    CHECK_EQUAL(0, request.numResponses);
+    CHECK_STRING("010C", request.command);
+}
+
+TEST(dropsWhitespaceAndUpperCases)
+{
+    CHECK_EQUAL(ELMRequest::PID, parse(" 01 0c\n\t"));
+    CHECK_STRING("010C", request.command);
+    CHECK_EQUAL(4, request.length);
+    CHECK_EQUAL(0x0C, request.pid);
+}
+
+TEST(splitsResponseCount)
+{
+    CHECK_EQUAL(ELMRequest::PID, parse("010D1"));
+    CHECK_EQUAL(0x0D, request.pid);
+    CHECK_EQUAL(1, request.numResponses);
+    CHECK_STRING("010D", request.command);
+}
+
+TEST(parsesSeveralMode01Pids)
+{
+    CHECK_EQUAL(ELMRequest::PID, parse("01 0C 0D 11 05 0F 04"));
+    CHECK_EQUAL(6, request.pidCount);
+    const uint8_t expected[] = {0x0C, 0x0D, 0x11, 0x05, 0x0F, 0x04};
+    CHECK(memcmp(expected, request.pids, sizeof(expected)) == 0);
+    CHECK(request.isMultiPid());
+    CHECK_STRING("010C0D11050F04", request.command);
+
+    // pids over MAX_PIDS_PER_REQUEST are dropped
+    CHECK_EQUAL(ELMRequest::PID, parse("010C0D11050F040B"));
+    CHECK_EQUAL(MAX_PIDS_PER_REQUEST, request.pidCount);
+    CHECK_STRING("010C0D11050F04", request.command);
+
+    // a last odd digit is the response count
+    CHECK_EQUAL(ELMRequest::PID, parse("010C0D2"));
+    CHECK_EQUAL(2, request.pidCount);
+    CHECK_EQUAL(2, request.numResponses);
+}
+
+TEST(parsesMode22SixteenBitPid)
+{
+    CHECK_EQUAL(ELMRequest::PID, parse("2218E4"));
+    CHECK_EQUAL(0x22, request.mode);
+    CHECK_EQUAL(0x18E4, request.pid);
+    CHECK_EQUAL(2, request.pidBytes);
+    CHECK_EQUAL(0, request.pidCount);
+    CHECK(request.isMode(SERVICE_22));
+}
+
+TEST(parsesFreezeFrameNumber)
+{
+    CHECK_EQUAL(ELMRequest::PID, parse("020C01"));
+    CHECK_EQUAL(0x02, request.mode);
+    CHECK_EQUAL(0x0C, request.pid);
+    CHECK_EQUAL(1, request.frame);
+    CHECK_EQUAL(1, request.pidCount);
+}
+
+TEST(parsesModesWithoutPid)
+{
+    CHECK_EQUAL(ELMRequest::PID, parse("03"));
+    CHECK_EQUAL(0x03, request.mode);
+    CHECK_EQUAL(0, request.pidBytes);
+    CHECK_EQUAL(0, request.pidCount);
+
+    CHECK_EQUAL(ELMRequest::PID, parse("041"));
+    CHECK_EQUAL(0x04, request.mode);
+    CHECK_EQUAL(1, request.numResponses);
+}
+
+TEST(recognizesAtCommands)
+{
+    CHECK_EQUAL(ELMRequest::AT, parse("at sp 6"));
+    CHECK_STRING("ATSP6", request.command);
+    CHECK(!request.isMode(0));
+}
+
+TEST(emptyLineRepeats)
+{
+    CHECK_EQUAL(ELMRequest::REPEAT, parse(""));
+    CHECK_EQUAL(ELMRequest::REPEAT, parse(" \t"));
+}
+
+TEST(rejectsInvalidRequests)
+{
+    CHECK_EQUAL(ELMRequest::INVALID, parse("0G"));
+    CHECK_EQUAL(ELMRequest::INVALID, parse("1"));
+    CHECK_EQUAL(ELMRequest::INVALID, parse("01 0C ZZ"));
+    CHECK_EQUAL(ELMRequest::INVALID, parse("HELLO"));
+
+    char tooLong[MAX_REQUEST_SIZE + 2];
+    memset(tooLong, '0', sizeof(tooLong));
+    CHECK_EQUAL(ELMRequest::INVALID, request.parse(tooLong, sizeof(tooLong)));
+    CHECK_EQUAL(ELMRequest::PID, request.parse(tooLong, MAX_REQUEST_SIZE));
+}
+
+TEST(setPidsRebuildsCommand)
+{
+    parse("010C0D11");
+    const uint8_t supported[] = {0x0D, 0x11};
+    request.setPids(supported, 2);
+    CHECK_STRING("010D11", request.command);
+    CHECK_EQUAL(0x0D, request.pid);
+    CHECK_EQUAL(2, request.pidCount);
+
+    request.setPids(request.pids + 1, 1);
+    CHECK_STRING("0111", request.command);
+    CHECK_EQUAL(0x11, request.pid);
+}
@@ -0,0 +1,118 @@
+#include <ELMulator.h>
+#include <string>
+#include "HostTest.h"
+#include "ReplayStream.h"
+
+/**
+ * Requests answered by several ECUs: the engine (7E0/7E8, PidProcessor) and
+ * the transmission (7E1/7E9, EcuTable), checked byte for byte through
+ * OBDStreamComm with headers on.
+ */
+
+static uint32_t readEngineSpeed(uint16_t pid)
+{
+    return 0x40;
+}
+
+static uint32_t readEngineRpm(uint16_t pid)
+{
+    return 0x1AF8;
+}
+
+static uint32_t readGearboxSpeed(uint16_t pid)
+{
+    return 0x41;
+}
+
+static uint32_t readGear(uint16_t pid)
+{
+    return 0x0300;
+}
+
+// An engine with 0C and 0D, and a transmission with 0D and A4 if withTransmission
+struct Vehicle
+{
+    ReplayStream replay;
+    OBDStreamComm transport;
+    ELMulator elm;
+
+    Vehicle(bool withTransmission) : transport(replay), elm(&transport)
+    {
+        elm.init("host");
+        elm.registerMode01Pid(ENGINE_RPM, readEngineRpm);
+        elm.registerMode01Pid(VEHICLE_SPEED, readEngineSpeed);
+        if (withTransmission)
+        {
+            int8_t transmission = elm.getEcuTable().addEcu(0x7E1);
+            elm.getEcuTable().registerPid(transmission, SERVICE_01, VEHICLE_SPEED, 1, readGearboxSpeed);
+            elm.getEcuTable().registerPid(transmission, SERVICE_01, 0xA4, 2, readGear);
+        }
+        run("ATE0\rATH1\r");
+    }
+
+    const char *run(const std::string &requests)
+    {
+        replay.load(requests.c_str());
+        replay.clearOutput();
+        while (!replay.finished())
+        {
+            elm.poll();
+        }
+        return replay.getOutput();
+    }
+};
+
+// every ECU with the pid answers, the engine last
+TEST(functionalRequestFansOut)
+{
+    Vehicle vehicle(true);
+    CHECK_STRING("7E9 03 41 0D 41\r\n7E8 03 41 0D 40\r\n>", vehicle.run("010D\r"));
+    CHECK_STRING("7E8 04 41 0C 1A F8\r\n>", vehicle.run("010C\r"));
+    CHECK_STRING("7E9 04 41 A4 03 00\r\n>", vehicle.run("01A4\r"));
+    CHECK_STRING("7E9 06 41 00 00 08 00 01\r\n7E8 06 41 00 00 18 00 00\r\n>", vehicle.run("0100\r"));
+}
+
+TEST(physicalRequestGoesToOneEcu)
+{
+    Vehicle vehicle(true);
+    CHECK_STRING("OK\r\n>7E9 03 41 0D 41\r\n>", vehicle.run("ATSH7E1\r010D\r"));
+    CHECK_STRING("NO DATA\r\n>", vehicle.run("010C\r"));
+    CHECK_STRING("OK\r\n>7E8 03 41 0D 40\r\n>", vehicle.run("ATSH7E0\r010D\r"));
+}
+
+TEST(receiveFilterHidesOtherEcus)
+{
+    Vehicle vehicle(true);
+    CHECK_STRING("OK\r\n>7E9 03 41 0D 41\r\n>", vehicle.run("ATCRA7E9\r010D\r"));
+    CHECK_STRING("OK\r\n>7E8 03 41 0D 40\r\n>", vehicle.run("ATCRA7E8\r010D\r"));
+    CHECK_STRING("OK\r\n>7E9 03 41 0D 41\r\n7E8 03 41 0D 40\r\n>", vehicle.run("ATCRA\r010D\r"));
+}
+
+// without other ECUs the engine answers any physical request from its id + 8
+TEST(engineOnlyAnswersAnyHeader)
+{
+    Vehicle vehicle(false);
+    CHECK_STRING("7E8 03 41 0D 40\r\n>", vehicle.run("010D\r"));
+    CHECK_STRING("OK\r\n>7E9 03 41 0D 40\r\n>", vehicle.run("ATSH7E1\r010D\r"));
+}
+
+TEST(extendedIdsUnderCan29)
+{
+    Vehicle vehicle(true);
+    CHECK_STRING("OK\r\n>18 DA F1 11 03 41 0D 41\r\n18 DA F1 10 03 41 0D 40\r\n>", vehicle.run("ATSP7\r010D\r"));
+    CHECK_STRING("OK\r\n>18 DA F1 11 03 41 0D 41\r\n>", vehicle.run("ATSHDA11F1\r010D\r"));
+    CHECK_STRING("OK\r\n>18 DA F1 10 03 41 0D 40\r\n>", vehicle.run("ATSH18DA10F1\r010D\r"));
+}
+
+// as an ELM327, a header that is not 3, 6 or 8 hex digits is refused and the previous one kept
+TEST(invalidHeaderIsRefused)
+{
+    Vehicle vehicle(true);
+    CHECK_STRING("OK\r\n>", vehicle.run("ATSH7E1\r"));
+    CHECK_STRING("?\r\n>", vehicle.run("ATSHZZ\r"));
+    CHECK_STRING("?\r\n>", vehicle.run("ATSH\r"));
+    CHECK_STRING("?\r\n>", vehicle.run("ATSH7E\r"));
+    CHECK_STRING("?\r\n>", vehicle.run("ATSH7E1F\r"));
+    CHECK_STRING("?\r\n>", vehicle.run("ATSH18DA1XF1\r"));
+    CHECK_STRING("7E9 03 41 0D 41\r\n>", vehicle.run("010D\r"));
+}
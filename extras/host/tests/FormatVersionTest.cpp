@@ -0,0 +1,69 @@
+#include <ELMulator.h>
+#include <string>
+#include "HostTest.h"
+#include "ReplayStream.h"
+#include "Sessions.h"
+
+/**
+ * Rendered responses are kept per format version (uint16): once the
+ * counter wraps around, a version seen before must not bring back what was
+ * rendered for other settings.
+ */
+
+static ReplayStream replay;
+static OBDStreamComm transport(replay);
+static ELMulator elm(&transport);
+
+static const char *run(const std::string &requests)
+{
+    replay.load(requests.c_str());
+    replay.clearOutput();
+    while (!replay.finished())
+    {
+        elm.poll();
+    }
+    return replay.getOutput();
+}
+
+// count times a setting change that leaves the output as it is (line feeds are on)
+static std::string unchangedFormat(uint32_t count)
+{
+    std::string requests;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        requests += "ATL1\r";
+    }
+    return requests;
+}
+
+static void setUp()
+{
+    static bool done = false;
+    if (!done)
+    {
+        elm.init("host");
+        setUpSessionPids(elm);
+        elm.getVehicleInfo().setVin("1HGCM82633A004352");
+        done = true;
+    }
+}
+
+// 65536 changes later the counter is back at the version the response was cached at
+TEST(cachedResponsesDoNotOutliveTheWrap)
+{
+    setUp();
+    run("ATE0\rATS0\r");
+    CHECK_STRING("410C1AF8\r\n>", run("010C\r"));
+    run("ATS1\r" + unchangedFormat(65535));
+    CHECK_STRING("41 0C 1A F8\r\n>", run("010C\r"));
+}
+
+TEST(vehicleInfoDoesNotOutliveTheWrap)
+{
+    setUp();
+    run("ATE0\rATH0\rATS1\r");
+    CHECK_STRING("014\r\n0: 49 02 01 31 48 47\r\n1: 43 4D 38 32 36 33 33\r\n2: 41 30 30 34 33 35 32\r\n>", run("0902\r"));
+    run("ATH1\r" + unchangedFormat(65535));
+    CHECK_STRING("7E8 10 14 49 02 01 31 48 47\r\n7E8 21 43 4D 38 32 36 33 33\r\n7E8 22 41 30 30 34 33 35 32\r\n>",
+                 run("0902\r"));
+}
@@ -0,0 +1,90 @@
+#include <FrameFormatter.h>
+#include <IsoTpFrames.h>
+#include <string.h>
+#include "HostTest.h"
+
+static const uint8_t RPM[] = {0x41, 0x0C, 0x1A, 0xF8};
+
+// 49 02 01 + "1HGCM82633A004352"
+static const uint8_t VIN[] = {0x49, 0x02, 0x01, 0x31, 0x48, 0x47, 0x43, 0x4D, 0x38, 0x32, 0x36,
+                              0x33, 0x33, 0x41, 0x30, 0x30, 0x34, 0x33, 0x35, 0x32};
+
+// all lines of a response, separated by '|'
+static const char *format(uint8_t flags, uint16_t header, const uint8_t *payload, uint16_t length)
+{
+    static char text[1024];
+    IsoTpFrames frames(payload, length);
+    FrameFormatter formatter(flags, header);
+    uint16_t pos = 0;
+    for (uint16_t i = 0; i < formatter.getLineCount(frames); i++)
+    {
+        if (i > 0)
+        {
+            text[pos++] = '|';
+        }
+        char line[FRAME_LINE_SIZE];
+        uint8_t lineLength = formatter.formatLine(frames, i, line);
+        CHECK(lineLength < FRAME_LINE_SIZE);
+        CHECK_EQUAL(lineLength, strlen(line));
+        memcpy(text + pos, line, lineLength);
+        pos += lineLength;
+    }
+    text[pos] = '\0';
+    return text;
+}
+
+TEST(formatsSingleFrames)
+{
+    const uint8_t AUTO = FrameFormatter::AUTO_FORMAT;
+    const uint8_t SPACES = FrameFormatter::SPACES;
+    const uint8_t HEADERS = FrameFormatter::HEADERS;
+    CHECK_STRING("41 0C 1A F8", format(AUTO | SPACES, 0x7E8, RPM, sizeof(RPM)));
+    CHECK_STRING("410C1AF8", format(AUTO, 0x7E8, RPM, sizeof(RPM)));
+    CHECK_STRING("7E8 04 41 0C 1A F8", format(AUTO | SPACES | HEADERS, 0x7E8, RPM, sizeof(RPM)));
+    CHECK_STRING("7E804410C1AF8", format(AUTO | HEADERS, 0x7E8, RPM, sizeof(RPM)));
+    CHECK_STRING("7E8 04 41 0C 1A F8 00 00 00", format(SPACES | HEADERS, 0x7E8, RPM, sizeof(RPM)));
+    CHECK_STRING("7E9 8 04 41 0C 1A F8", format(AUTO | SPACES | HEADERS | FrameFormatter::DLC, 0x7E9, RPM, sizeof(RPM)));
+    CHECK_STRING("18 DA F1 10 04 41 0C 1A F8",
+                 format(AUTO | SPACES | HEADERS | FrameFormatter::EXTENDED_IDS, 0x7E8, RPM, sizeof(RPM)));
+    // the DLC is only shown with the header
+    CHECK_STRING("41 0C 1A F8", format(AUTO | SPACES | FrameFormatter::DLC, 0x7E8, RPM, sizeof(RPM)));
+}
+
+TEST(formatsMultiFrames)
+{
+    const uint8_t AUTO = FrameFormatter::AUTO_FORMAT;
+    const uint8_t SPACES = FrameFormatter::SPACES;
+    const uint8_t HEADERS = FrameFormatter::HEADERS;
+    CHECK_STRING("014|0: 49 02 01 31 48 47|1: 43 4D 38 32 36 33 33|2: 41 30 30 34 33 35 32",
+                 format(AUTO | SPACES, 0x7E8, VIN, sizeof(VIN)));
+    CHECK_STRING("014|0:490201314847|1:434D3832363333|2:41303034333532", format(AUTO, 0x7E8, VIN, sizeof(VIN)));
+    CHECK_STRING("7E8 10 14 49 02 01 31 48 47|7E8 21 43 4D 38 32 36 33 33|7E8 22 41 30 30 34 33 35 32",
+                 format(AUTO | SPACES | HEADERS, 0x7E8, VIN, sizeof(VIN)));
+    CHECK_STRING("7E8 8 10 14 49 02 01 31 48 47|7E8 8 21 43 4D 38 32 36 33 33|7E8 8 22 41 30 30 34 33 35 32",
+                 format(SPACES | HEADERS | FrameFormatter::DLC, 0x7E8, VIN, sizeof(VIN)));
+}
+
+TEST(longestLineFits)
+{
+    // 29 bit header, DLC, spaces and all 8 bytes
+    const uint8_t flags = FrameFormatter::SPACES | FrameFormatter::HEADERS | FrameFormatter::DLC |
+                          FrameFormatter::EXTENDED_IDS;
+    IsoTpFrames frames(VIN, sizeof(VIN));
+    char line[FRAME_LINE_SIZE];
+    CHECK_EQUAL(FRAME_LINE_SIZE - 1, FrameFormatter(flags, 0x7E8).formatLine(frames, 0, line));
+    CHECK_STRING("18 DA F1 10 8 10 14 49 02 01 31 48 47", line);
+}
+
+TEST(convertsCanIds)
+{
+    CHECK_EQUAL(0x18DB33F1, FrameFormatter::getExtendedId(0x7DF));
+    CHECK_EQUAL(0x18DA10F1, FrameFormatter::getExtendedId(0x7E0));
+    CHECK_EQUAL(0x18DA17F1, FrameFormatter::getExtendedId(0x7E7));
+    CHECK_EQUAL(0x18DAF110, FrameFormatter::getExtendedId(0x7E8));
+    CHECK_EQUAL(0x18DAF111, FrameFormatter::getExtendedId(0x7E9));
+    CHECK_EQUAL(0x7DF, FrameFormatter::getStandardId(0x18DB33F1));
+    for (uint16_t id = 0x7E0; id <= 0x7EF; id++)
+    {
+        CHECK_EQUAL(id, FrameFormatter::getStandardId(FrameFormatter::getExtendedId(id)));
+    }
+}
@@ -0,0 +1,201 @@
+#include <ELMulator.h>
+#include <string>
+#include "HostTest.h"
+#include "ReplayStream.h"
+
+/**
+ * Mode 02 freeze frames: the record layout of FreezeFrames, and frames
+ * captured by ELMulator when the DtcStore stores a code, answered through
+ * OBDStreamComm.
+ */
+
+static uint32_t readCoolant(uint16_t pid)
+{
+    return 0x5A;
+}
+
+// Payload of a mode 02 response of frames, ex: "42 0C 00 1A F8"
+static const char *response(FreezeFrames &frames, uint8_t pid, uint8_t frame)
+{
+    static char text[32];
+    uint8_t payload[7];
+    uint8_t length = frames.getResponse(pid, frame, payload);
+    uint8_t pos = 0;
+    for (uint8_t i = 0; i < length; i++)
+    {
+        pos += sprintf(text + pos, i == 0 ? "%02X" : " %02X", payload[i]);
+    }
+    text[pos] = '\0';
+    return text;
+}
+
+// An engine with 05 from a handler and 0C, 0D answered by the simulator
+struct Vehicle
+{
+    ReplayStream replay;
+    OBDStreamComm transport;
+    ELMulator elm;
+
+    Vehicle() : transport(replay), elm(&transport)
+    {
+        elm.init("host");
+        elm.registerMode01Pid(ENGINE_COOLANT_TEMP, readCoolant);
+        elm.registerMode01Pid(ENGINE_RPM);
+        elm.registerMode01Pid(VEHICLE_SPEED);
+        elm.getFreezeFrames();
+    }
+
+    const char *run(const std::string &requests)
+    {
+        replay.load(requests.c_str());
+        replay.clearOutput();
+        while (!replay.finished())
+        {
+            elm.poll();
+        }
+        return replay.getOutput();
+    }
+};
+
+// one frame of 0C (2 bytes) and 05 (1 byte) for dtc
+static void addFrame(FreezeFrames &frames, uint16_t dtc, uint16_t rpm, uint8_t coolant)
+{
+    uint8_t *values = frames.startFrame(dtc);
+    CHECK(values != nullptr);
+    values[0] = rpm >> 8;
+    values[1] = rpm & 0xFF;
+    values[2] = coolant;
+    frames.endFrame();
+}
+
+TEST(recordsFollowTheLayout)
+{
+    FreezeFrames frames;
+    CHECK(frames.addPid(ENGINE_RPM, 2));
+    CHECK(frames.addPid(ENGINE_COOLANT_TEMP, 1));
+    CHECK(!frames.addPid(ENGINE_RPM, 2));
+    CHECK_EQUAL(2, frames.getPidCount());
+    CHECK_EQUAL(ENGINE_RPM, frames.getPid(0));
+    CHECK_EQUAL(ENGINE_COOLANT_TEMP, frames.getPid(1));
+    CHECK_EQUAL(2, frames.getNumberOfBytes(ENGINE_RPM));
+
+    addFrame(frames, 0x0301, 0x1AF8, 0x5A);
+    addFrame(frames, 0x0420, 0x1B00, 0x5C);
+    CHECK_EQUAL(2, frames.getCount());
+    CHECK(!frames.addPid(VEHICLE_SPEED, 1));
+
+    CHECK_STRING("42 0C 00 1A F8", response(frames, ENGINE_RPM, 0));
+    CHECK_STRING("42 05 00 5A", response(frames, ENGINE_COOLANT_TEMP, 0));
+    CHECK_STRING("42 0C 01 1B 00", response(frames, ENGINE_RPM, 1));
+    CHECK_STRING("42 05 01 5C", response(frames, ENGINE_COOLANT_TEMP, 1));
+    CHECK_STRING("", response(frames, VEHICLE_SPEED, 0));
+    CHECK_STRING("", response(frames, ENGINE_RPM, 2));
+}
+
+TEST(pid02IsTheCodeOfTheFrame)
+{
+    FreezeFrames frames;
+    frames.addPid(ENGINE_RPM, 2);
+    frames.addPid(ENGINE_COOLANT_TEMP, 1);
+    addFrame(frames, 0x0301, 0x1AF8, 0x5A);
+    addFrame(frames, 0xC100, 0x1B00, 0x5C);
+    CHECK_STRING("42 02 00 03 01", response(frames, FREEZE_DTC, 0));
+    CHECK_STRING("42 02 01 C1 00", response(frames, FREEZE_DTC, 1));
+}
+
+// 02 and the layout pids, 21 in the next range
+TEST(supportedPidsAreTheLayout)
+{
+    FreezeFrames frames;
+    frames.addPid(ENGINE_RPM, 2);
+    frames.addPid(ENGINE_COOLANT_TEMP, 1);
+    frames.addPid(VEHICLE_SPEED, 1);
+    frames.addPid(0x21, 2);
+    CHECK_STRING("", response(frames, 0x00, 0));
+    frames.startFrame(0x0301);
+    frames.endFrame();
+    CHECK_STRING("42 00 00 48 18 00 01", response(frames, 0x00, 0));
+    CHECK_STRING("42 20 00 80 00 00 00", response(frames, 0x20, 0));
+    CHECK_STRING("42 40 00 00 00 00 00", response(frames, 0x40, 0));
+}
+
+TEST(capturesStopWhenFull)
+{
+    FreezeFrames frames;
+    frames.addPid(ENGINE_RPM, 2);
+    frames.addPid(ENGINE_COOLANT_TEMP, 1);
+    for (uint8_t i = 0; i < MAX_FREEZE_FRAMES; i++)
+    {
+        addFrame(frames, 0x0300 + i, 0x1AF8, 0x5A);
+    }
+    CHECK(frames.startFrame(0x0420) == nullptr);
+    CHECK_EQUAL(MAX_FREEZE_FRAMES, frames.getCount());
+    CHECK_STRING("42 02 00 03 00", response(frames, FREEZE_DTC, 0));
+}
+
+// records of more than half the arena: a single frame fits
+TEST(capturesStopWhenTheArenaIsFull)
+{
+    FreezeFrames frames;
+    for (uint8_t pid = 1; pid <= (FREEZE_FRAME_ARENA_SIZE / 2 - 2) / 4 + 1; pid++)
+    {
+        CHECK(frames.addPid(pid, 4));
+    }
+    CHECK(frames.startFrame(0x0301) != nullptr);
+    frames.endFrame();
+    CHECK(frames.startFrame(0x0302) == nullptr);
+    CHECK_EQUAL(1, frames.getCount());
+}
+
+// the frame stored with the code holds what a live request gets at that time
+TEST(frameHoldsTheLiveValues)
+{
+    Vehicle vehicle;
+    CHECK(vehicle.elm.getDtcStore().add("P0301"));
+    CHECK_EQUAL(1, vehicle.elm.getFreezeFrames().getCount());
+
+    // the first poll starts the simulator, it has not moved since the capture
+    std::string live = vehicle.run("010C\r");
+    CHECK(live.compare(0, 12, "010C\r\n41 0C ") == 0);
+    std::string frame = "020C00\r\n42 0C 00 " + live.substr(12);
+    CHECK_STRING(frame.c_str(), vehicle.run("020C00\r"));
+    CHECK(frame != "020C00\r\n42 0C 00 00 00\r\n>");
+
+    CHECK_STRING("ATE0\r\nOK\r\n>42 05 00 5A\r\n>", vehicle.run("ATE0\r020500\r"));
+    CHECK_STRING("42 02 00 03 01\r\n>", vehicle.run("020200\r"));
+    CHECK_STRING("42 00 00 48 18 00 00\r\n>", vehicle.run("020000\r"));
+    CHECK_STRING("NO DATA\r\n>", vehicle.run("020C01\r"));
+}
+
+TEST(storedCodesCaptureUntilFull)
+{
+    Vehicle vehicle;
+    DtcStore &dtcs = vehicle.elm.getDtcStore();
+    CHECK(dtcs.add("P0301"));
+    CHECK(dtcs.add("P0301"));
+    CHECK(dtcs.add("P0171", DtcStore::PENDING));
+    CHECK_EQUAL(1, vehicle.elm.getFreezeFrames().getCount());
+    for (uint8_t i = 1; i < MAX_FREEZE_FRAMES; i++)
+    {
+        CHECK(vehicle.elm.captureFreezeFrame());
+    }
+    CHECK(!vehicle.elm.captureFreezeFrame());
+    CHECK(dtcs.add("P0420"));
+    CHECK_EQUAL(MAX_FREEZE_FRAMES, vehicle.elm.getFreezeFrames().getCount());
+    CHECK_STRING("ATE0\r\nOK\r\n>42 02 00 03 01\r\n>42 02 01 00 00\r\n>", vehicle.run("ATE0\r020200\r020201\r"));
+}
+
+// mode 04 drops the frames and the layout, the next capture builds it again
+TEST(clearDropsFramesAndLayout)
+{
+    Vehicle vehicle;
+    vehicle.elm.getDtcStore().add("P0301");
+    CHECK_STRING("ATE0\r\nOK\r\n>44\r\n>NO DATA\r\n>", vehicle.run("ATE0\r04\r020500\r"));
+    CHECK_EQUAL(0, vehicle.elm.getFreezeFrames().getCount());
+    CHECK_EQUAL(0, vehicle.elm.getFreezeFrames().getPidCount());
+
+    vehicle.elm.registerMode01Pid(INTAKE_AIR_TEMP);
+    vehicle.elm.getDtcStore().add("P0420");
+    CHECK_EQUAL(4, vehicle.elm.getFreezeFrames().getPidCount());
+    CHECK_STRING("42 02 00 04 20\r\n>42 00 00 48 1A 00 00\r\n>", vehicle.run("020200\r020000\r"));
+}
@@ -0,0 +1,99 @@
+#include <HexCodec.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "HostTest.h"
+
+static int referenceDigit(int c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    return HexCodec::INVALID;
+}
+
+TEST(decodesEveryChar)
+{
+    for (int c = 0; c < 256; c++)
+    {
+        CHECK_EQUAL(referenceDigit(c), HexCodec::decodeDigit((char)c));
+    }
+}
+
+TEST(encodesEveryByte)
+{
+    for (int byte = 0; byte < 256; byte++)
+    {
+        char expected[3];
+        snprintf(expected, sizeof(expected), "%02X", byte);
+        char actual[3] = {0};
+        CHECK(HexCodec::encodeByte(byte, actual) == actual + 2);
+        CHECK_STRING(expected, actual);
+        CHECK_EQUAL(byte, HexCodec::decodeByte(actual));
+        CHECK_EQUAL(expected[1], HexCodec::encodeDigit(byte));
+    }
+}
+
+// every length, so the word at a time loops and their leftovers are both covered
+TEST(validatesLikeACharLoop)
+{
+    static const char CHARS[] = "0123456789ABCDEFabcdef/:@G`g \x7F\x80\xC6\xFF";
+    srand(1);
+    char text[40];
+    for (int round = 0; round < 20000; round++)
+    {
+        uint16_t length = rand() % sizeof(text);
+        bool expected = true;
+        for (uint16_t i = 0; i < length; i++)
+        {
+            // mostly digits, so long valid strings come up too
+            text[i] = (rand() % 8 != 0) ? CHARS[rand() % 22] : CHARS[rand() % (sizeof(CHARS) - 1)];
+            expected = expected && referenceDigit((uint8_t)text[i]) != HexCodec::INVALID;
+        }
+        CHECK_EQUAL(expected, HexCodec::isHex(text, length));
+    }
+}
+
+TEST(decodesLikeStrtoul)
+{
+    static const char DIGITS[] = "0123456789ABCDEFabcdef";
+    srand(2);
+    char hex[40];
+    for (int round = 0; round < 20000; round++)
+    {
+        uint16_t length = rand() % sizeof(hex);
+        for (uint16_t i = 0; i < length; i++)
+        {
+            hex[i] = DIGITS[rand() % 22];
+        }
+        uint8_t bytes[sizeof(hex) / 2];
+        CHECK_EQUAL(length / 2, HexCodec::decode(hex, length, bytes));
+        for (uint16_t i = 0; i < length / 2; i++)
+        {
+            char pair[3] = {hex[2 * i], hex[2 * i + 1], '\0'};
+            CHECK_EQUAL(strtoul(pair, nullptr, 16), bytes[i]);
+        }
+    }
+}
+
+TEST(encodesLikeSnprintf)
+{
+    const uint8_t bytes[] = {0x41, 0x0C, 0x1A, 0xF8, 0x00, 0xFF};
+    char text[3 * sizeof(bytes)];
+
+    text[HexCodec::encode(bytes, sizeof(bytes), text, false)] = '\0';
+    CHECK_STRING("410C1AF800FF", text);
+
+    text[HexCodec::encode(bytes, sizeof(bytes), text, true)] = '\0';
+    CHECK_STRING("41 0C 1A F8 00 FF", text);
+
+    CHECK_EQUAL(0, HexCodec::encode(bytes, 0, text, true));
+}
@@ -0,0 +1,98 @@
+#include "HostTest.h"
+
+#include <stdio.h>
+#include <string.h>
+
+HostTest *HostTest::first = nullptr;
+HostTest *HostTest::last = nullptr;
+bool HostTest::failed = false;
+
+// registered in definition order, by the static objects of TEST
+HostTest::HostTest(const char *name, Body body) : name(name), body(body), next(nullptr)
+{
+    if (last == nullptr)
+    {
+        first = this;
+    }
+    else
+    {
+        last->next = this;
+    }
+    last = this;
+}
+
+int HostTest::runAll()
+{
+    int nTests = 0;
+    int nFailed = 0;
+    for (HostTest *test = first; test != nullptr; test = test->next)
+    {
+        failed = false;
+        test->body();
+        nTests++;
+        if (failed)
+        {
+            printf("FAILED %s\n", test->name);
+            nFailed++;
+        }
+    }
+    printf("%d tests, %d failed\n", nTests, nFailed);
+    return nFailed;
+}
+
+void HostTest::check(bool passed, const char *expression, const char *file, int line)
+{
+    if (!passed)
+    {
+        printf("%s:%d: CHECK(%s) failed\n", file, line, expression);
+        failed = true;
+    }
+}
+
+void HostTest::checkEqual(long long expected, long long actual, const char *expression, const char *file, int line)
+{
+    if (expected != actual)
+    {
+        printf("%s:%d: %s is %lld (0x%llX), expected %lld (0x%llX)\n", file, line, expression,
+               actual, actual, expected, expected);
+        failed = true;
+    }
+}
+
+// response end chars shown as \r and \n
+static void printEscaped(const char *text)
+{
+    for (; *text != '\0'; text++)
+    {
+        if (*text == '\r')
+        {
+            printf("\\r");
+        }
+        else if (*text == '\n')
+        {
+            printf("\\n");
+        }
+        else
+        {
+            putchar(*text);
+        }
+    }
+}
+
+void HostTest::checkString(const char *expected, const char *actual, const char *expression, const char *file, int line)
+{
+    if (strcmp(expected, actual) != 0)
+    {
+        printf("%s:%d: %s is \"", file, line, expression);
+        printEscaped(actual);
+        printf("\", expected \"");
+        printEscaped(expected);
+        printf("\"\n");
+        failed = true;
+    }
+}
+
+int main()
+{
+    return HostTest::runAll();
+}
@@ -0,0 +1,54 @@
+#ifndef ELMulator_host_HostTest_h
+#define ELMulator_host_HostTest_h
+
+#include <stdint.h>
+
+/**
+ * Minimal test runner, one executable per test file (see CMakeLists.txt):
+ *
+ * TEST(parsesPid)
+ * {
+ *     CHECK_EQUAL(0x0C, request.pid);
+ * }
+ *
+ * Every TEST of the executable is run, failed checks are printed with
+ * their file and line, and the exit code is the number of failed tests.
+ */
+class HostTest
+{
+public:
+    typedef void (*Body)();
+
+    HostTest(const char *name, Body body);
+
+    static int runAll();
+
+    static void check(bool passed, const char *expression, const char *file, int line);
+
+    static void checkEqual(long long expected, long long actual, const char *expression, const char *file, int line);
+
+    static void checkString(const char *expected, const char *actual, const char *expression, const char *file, int line);
+
+private:
+    const char *name;
+    Body body;
+    HostTest *next;
+
+    static HostTest *first;
+    static HostTest *last;
+    static bool failed; // a check of the running test failed
+};
+
+#define TEST(name)                                          \
+    static void test_##name();                              \
+    static HostTest registration_##name(#name, test_##name); \
+    static void test_##name()
+
+#define CHECK(condition) HostTest::check((condition), #condition, __FILE__, __LINE__)
+
+#define CHECK_EQUAL(expected, actual) \
+    HostTest::checkEqual((long long)(expected), (long long)(actual), #actual, __FILE__, __LINE__)
+
+#define CHECK_STRING(expected, actual) HostTest::checkString((expected), (actual), #actual, __FILE__, __LINE__)
+
+#endif
@@ -0,0 +1,81 @@
+#include <IsoTpFrames.h>
+#include <string.h>
+#include "HostTest.h"
+
+static const uint8_t RPM[] = {0x41, 0x0C, 0x1A, 0xF8};
+
+// 49 02 01 + "1HGCM82633A004352"
+static const uint8_t VIN[] = {0x49, 0x02, 0x01, 0x31, 0x48, 0x47, 0x43, 0x4D, 0x38, 0x32, 0x36,
+                              0x33, 0x33, 0x41, 0x30, 0x30, 0x34, 0x33, 0x35, 0x32};
+
+static bool frameIs(const IsoTpFrames &frames, uint16_t index, const uint8_t *expected)
+{
+    uint8_t frame[CAN_FRAME_SIZE];
+    frames.getFrame(index, frame);
+    return memcmp(expected, frame, CAN_FRAME_SIZE) == 0;
+}
+
+TEST(singleFrameIsPadded)
+{
+    IsoTpFrames frames(RPM, sizeof(RPM));
+    CHECK(!frames.isMultiFrame());
+    CHECK_EQUAL(1, frames.getCount());
+    uint8_t frame[CAN_FRAME_SIZE];
+    CHECK_EQUAL(5, frames.getFrame(0, frame));
+    const uint8_t expected[] = {0x04, 0x41, 0x0C, 0x1A, 0xF8, 0x00, 0x00, 0x00};
+    CHECK(frameIs(frames, 0, expected));
+}
+
+TEST(splitsFirstAndConsecutiveFrames)
+{
+    IsoTpFrames frames(VIN, sizeof(VIN));
+    CHECK(frames.isMultiFrame());
+    CHECK_EQUAL(3, frames.getCount());
+    CHECK_EQUAL(2, frames.getPciSize(0));
+    CHECK_EQUAL(1, frames.getPciSize(1));
+    const uint8_t first[] = {0x10, 0x14, 0x49, 0x02, 0x01, 0x31, 0x48, 0x47};
+    const uint8_t second[] = {0x21, 0x43, 0x4D, 0x38, 0x32, 0x36, 0x33, 0x33};
+    const uint8_t third[] = {0x22, 0x41, 0x30, 0x30, 0x34, 0x33, 0x35, 0x32};
+    CHECK(frameIs(frames, 0, first));
+    CHECK(frameIs(frames, 1, second));
+    CHECK(frameIs(frames, 2, third));
+
+    // 8 bytes: first frame and a consecutive frame with 2 bytes and padding
+    IsoTpFrames eight(VIN, 8);
+    CHECK_EQUAL(2, eight.getCount());
+    uint8_t frame[CAN_FRAME_SIZE];
+    CHECK_EQUAL(3, eight.getFrame(1, frame));
+    const uint8_t padded[] = {0x21, 0x43, 0x4D, 0x00, 0x00, 0x00, 0x00, 0x00};
+    CHECK(frameIs(eight, 1, padded));
+}
+
+TEST(sequenceNumberWraps)
+{
+    uint8_t payload[FIRST_FRAME_MAX_BYTES + 17 * CONSECUTIVE_FRAME_MAX_BYTES];
+    for (uint16_t i = 0; i < sizeof(payload); i++)
+    {
+        payload[i] = i;
+    }
+    IsoTpFrames frames(payload, sizeof(payload));
+    CHECK_EQUAL(18, frames.getCount());
+    uint8_t frame[CAN_FRAME_SIZE];
+    frames.getFrame(15, frame);
+    CHECK_EQUAL(0x2F, frame[0]);
+    frames.getFrame(16, frame);
+    CHECK_EQUAL(0x20, frame[0]);
+    CHECK_EQUAL(FIRST_FRAME_MAX_BYTES + 15 * CONSECUTIVE_FRAME_MAX_BYTES, frame[1]);
+    frames.getFrame(17, frame);
+    CHECK_EQUAL(0x21, frame[0]);
+}
+
+TEST(lengthIsLimitedToTwelveBits)
+{
+    static uint8_t payload[ISOTP_MAX_PAYLOAD + 10];
+    IsoTpFrames frames(payload, sizeof(payload));
+    CHECK_EQUAL(ISOTP_MAX_PAYLOAD, frames.getLength());
+    CHECK_EQUAL(586, frames.getCount());
+    uint8_t frame[CAN_FRAME_SIZE];
+    frames.getFrame(0, frame);
+    CHECK_EQUAL(0x1F, frame[0]);
+    CHECK_EQUAL(0xFF, frame[1]);
+}
@@ -0,0 +1,72 @@
+#include <PidDescriptor.h>
+#include <math.h>
+#include "HostTest.h"
+
+static uint32_t encode(uint8_t pid, float value)
+{
+    const PidDescriptor *descriptor = PidDescriptor::find(pid);
+    CHECK(descriptor != nullptr);
+    return descriptor != nullptr ? descriptor->encode(value) : 0;
+}
+
+TEST(findsEveryDescriptor)
+{
+    for (uint8_t i = 0; i < PidDescriptor::N_DESCRIPTORS; i++)
+    {
+        CHECK(PidDescriptor::find(PidDescriptor::TABLE[i].pid) == &PidDescriptor::TABLE[i]);
+    }
+    CHECK(PidDescriptor::find(MONITOR_STATUS_SINCE_DTC_CLEARED) == nullptr); // bit encoded
+    CHECK(PidDescriptor::find(0x00) == nullptr);
+    CHECK(PidDescriptor::find(0xFF) == nullptr);
+}
+
+TEST(encodesJ1979Formulas)
+{
+    CHECK_EQUAL(12000, encode(ENGINE_RPM, 3000));
+    CHECK_EQUAL(4001, encode(ENGINE_RPM, 1000.25f));
+    CHECK_EQUAL(130, encode(ENGINE_COOLANT_TEMP, 90));
+    CHECK_EQUAL(0, encode(ENGINE_COOLANT_TEMP, -40));
+    CHECK_EQUAL(100, encode(VEHICLE_SPEED, 100));
+    CHECK_EQUAL(255, encode(THROTTLE_POSITION, 100));
+    CHECK_EQUAL(128, encode(THROTTLE_POSITION, 50));
+    CHECK_EQUAL(128, encode(SHORT_TERM_FUEL_TRIM_BANK_1, 0));
+    CHECK_EQUAL(12345670, encode(ODOMETER, 1234567));
+}
+
+TEST(clampsToRange)
+{
+    CHECK_EQUAL(0, encode(ENGINE_COOLANT_TEMP, -50));
+    CHECK_EQUAL(255, encode(ENGINE_COOLANT_TEMP, 300));
+    CHECK_EQUAL(255, encode(VEHICLE_SPEED, 256));
+    CHECK_EQUAL(0xFFFF, encode(ENGINE_RPM, 20000));
+    CHECK_EQUAL(0xFFFFFFFF, encode(ODOMETER, 1e9f));
+    CHECK_EQUAL(0, encode(ENGINE_RPM, NAN));
+    CHECK_EQUAL(0, encode(ENGINE_RPM, -INFINITY));
+    CHECK_EQUAL(0xFFFF, encode(ENGINE_RPM, INFINITY));
+}
+
+// fixed point against double math with the same scale, every descriptor over its whole range
+TEST(matchesDoubleMath)
+{
+    for (uint8_t i = 0; i < PidDescriptor::N_DESCRIPTORS; i++)
+    {
+        const PidDescriptor &descriptor = PidDescriptor::TABLE[i];
+        double scale = descriptor.scaleQ16 / 65536.0;
+        double offset = descriptor.offsetQ16 / 65536.0;
+        for (int step = 0; step <= 1000; step++)
+        {
+            float value = descriptor.min + (descriptor.max - descriptor.min) * step / 1000.0f;
+            double expected = floor((floor(value * 65536.0) / 65536.0 + offset) * scale + 0.5);
+            if (expected < 0)
+            {
+                expected = 0;
+            }
+            if (expected > descriptor.getMaxRaw())
+            {
+                expected = descriptor.getMaxRaw();
+            }
+            uint32_t raw = descriptor.encode(value);
+            CHECK(fabs(raw - expected) <= 1);
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#include <ELMulator.h>
+#include <string.h>
+#include "HostTest.h"
+#include "ReplayTransport.h"
+#include "Sessions.h"
+
+/**
+ * Several clients on one ELMulator (as OBDWiFiComm): each keeps its own AT
+ * settings and partial line, and a new client starts from the defaults.
+ */
+
+static void pollAll(ELMulator &elm, ReplayTransport &transport)
+{
+    for (uint16_t i = 0; i < 1000 && !transport.finished(); i++)
+    {
+        elm.poll();
+    }
+    // the last poll sees nothing more to read
+    elm.poll();
+}
+
+// Response of a new client with default settings
+static const char *const DEFAULT_RPM = "010C\r\n41 0C 1A F8\r\n>";
+
+TEST(sessionsKeepTheirSettings)
+{
+    ReplayTransport transport(2);
+    ELMulator elm(&transport);
+    elm.init("host");
+    setUpSessionPids(elm);
+
+    transport.reconnect(0, "ATE0\rATH1\rATS0\r010C\r");
+    transport.reconnect(1, "010C\r");
+    pollAll(elm, transport);
+    CHECK(strstr(transport.getStream(0).getOutput(), "7E804410C1AF8") != nullptr);
+    CHECK_STRING(DEFAULT_RPM, transport.getStream(1).getOutput());
+}
+
+TEST(newClientStartsFromDefaults)
+{
+    ReplayTransport transport(2);
+    ELMulator elm(&transport);
+    elm.init("host");
+    setUpSessionPids(elm);
+
+    transport.reconnect(0, "ATE0\rATH1\rATS0\r010C\r010D");
+    pollAll(elm, transport);
+
+    // seen disconnected by a poll, then replaced
+    transport.disconnect(0);
+    pollAll(elm, transport);
+    transport.reconnect(0, "010C\r");
+    pollAll(elm, transport);
+    CHECK_STRING(DEFAULT_RPM, transport.getStream(0).getOutput());
+}
+
+// the old client leaves and a new one is accepted between two polls
+TEST(replacedClientStartsFromDefaults)
+{
+    ReplayTransport transport(2);
+    ELMulator elm(&transport);
+    elm.init("host");
+    setUpSessionPids(elm);
+
+    transport.reconnect(0, "ATE0\rATH1\rATS0\r010C\r010D");
+    pollAll(elm, transport);
+
+    transport.reconnect(0, "010C\r");
+    pollAll(elm, transport);
+    CHECK_STRING(DEFAULT_RPM, transport.getStream(0).getOutput());
+    CHECK_EQUAL(ENGINE_RPM, elm.getRequest().pid);
+    CHECK_EQUAL(1, elm.getRequest().pidCount);
+}
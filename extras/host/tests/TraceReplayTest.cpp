@@ -0,0 +1,240 @@
+#include <TraceReplay.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+#include "HostTest.h"
+
+const uint32_t INDEX_INTERVAL_MS = 1000;
+
+struct Record
+{
+    uint32_t time;
+    uint32_t value;
+};
+
+struct TracePid
+{
+    uint8_t pid;
+    std::vector<Record> records;
+};
+
+static void putU16(std::vector<uint8_t> &trace, uint16_t value)
+{
+    trace.push_back(value);
+    trace.push_back(value >> 8);
+}
+
+static void putU32(std::vector<uint8_t> &trace, uint32_t value)
+{
+    putU16(trace, value);
+    putU16(trace, value >> 16);
+}
+
+// Trace in the format of TraceReplay.h
+static std::vector<uint8_t> buildTrace(const std::vector<TracePid> &pids, uint32_t durationMs)
+{
+    std::vector<uint8_t> trace = {'E', 'L', 'M', 'T'};
+    putU16(trace, 1);
+    putU16(trace, pids.size());
+    putU32(trace, durationMs);
+    putU32(trace, INDEX_INTERVAL_MS);
+
+    uint32_t nSlots = durationMs / INDEX_INTERVAL_MS + 1;
+    uint32_t offset = 16 + 16 * pids.size();
+    for (const TracePid &tracePid : pids)
+    {
+        trace.push_back(SERVICE_01);
+        trace.push_back(tracePid.pid);
+        trace.push_back(1);
+        trace.push_back(0);
+        putU32(trace, tracePid.records.size());
+        putU32(trace, offset + nSlots * 4);
+        putU32(trace, offset);
+        offset += nSlots * 4 + tracePid.records.size() * 8;
+    }
+    for (const TracePid &tracePid : pids)
+    {
+        for (uint32_t slot = 0; slot < nSlots; slot++)
+        {
+            uint32_t count = 0;
+            while (count < tracePid.records.size() && tracePid.records[count].time <= slot * INDEX_INTERVAL_MS)
+            {
+                count++;
+            }
+            putU32(trace, count);
+        }
+        for (const Record &record : tracePid.records)
+        {
+            putU32(trace, record.time);
+            putU32(trace, record.value);
+        }
+    }
+    return trace;
+}
+
+// Records from firstMs on, at random intervals up to maxGapMs
+static TracePid makePid(uint8_t pid, uint32_t firstMs, uint32_t maxGapMs, uint32_t durationMs)
+{
+    TracePid tracePid = {pid, {}};
+    for (uint32_t time = firstMs; time < durationMs; time += 1 + rand() % maxGapMs)
+    {
+        tracePid.records.push_back({time, (uint32_t)rand()});
+    }
+    return tracePid;
+}
+
+// value of the last record at or before time
+static bool expectedValue(const TracePid &tracePid, uint32_t time, uint32_t &value)
+{
+    auto next = std::upper_bound(tracePid.records.begin(), tracePid.records.end(), time,
+                                 [](uint32_t t, const Record &record) { return t < record.time; });
+    if (next == tracePid.records.begin())
+    {
+        return false;
+    }
+    value = (next - 1)->value;
+    return true;
+}
+
+// Counts the reads, fails them all once broken
+class TestReader : public MemoryTraceReader
+{
+public:
+    TestReader(const std::vector<uint8_t> &trace) : MemoryTraceReader(trace.data(), trace.size()) {}
+
+    bool read(uint32_t offset, uint8_t *buffer, uint16_t length) override
+    {
+        reads++;
+        return !broken && MemoryTraceReader::read(offset, buffer, length);
+    }
+
+    uint32_t reads = 0;
+    bool broken = false;
+};
+
+TEST(rejectsOtherFiles)
+{
+    std::vector<uint8_t> trace = buildTrace({{VEHICLE_SPEED, {{0, 1}}}}, 1000);
+    trace[0] = 'X';
+    TestReader reader(trace);
+    TraceReplay replay;
+    CHECK(!replay.begin(&reader));
+
+    std::vector<uint8_t> empty;
+    TestReader emptyReader(empty);
+    CHECK(!replay.begin(&emptyReader));
+}
+
+TEST(loadsDirectory)
+{
+    std::vector<uint8_t> trace = buildTrace({{VEHICLE_SPEED, {{0, 1}}}, {ENGINE_RPM, {{0, 2}}}}, 5000);
+    TestReader reader(trace);
+    TraceReplay replay;
+    CHECK(replay.begin(&reader));
+    CHECK_EQUAL(5000, replay.getDuration());
+    CHECK(replay.getSupportedPids().isSupported(VEHICLE_SPEED));
+    CHECK(replay.getSupportedPids().isSupported(ENGINE_RPM));
+    CHECK(!replay.getSupportedPids().isSupported(ENGINE_LOAD));
+    uint32_t value = 0;
+    CHECK(!replay.getValue(ENGINE_LOAD, 0, value));
+}
+
+TEST(playsAtSpeedAndLoops)
+{
+    std::vector<uint8_t> trace = buildTrace({{VEHICLE_SPEED, {{0, 10}, {1000, 20}, {2000, 30}}}}, 3000);
+    TestReader reader(trace);
+    TraceReplay replay;
+    replay.begin(&reader);
+    replay.start(500);
+    uint32_t value = 0;
+    CHECK(replay.getValue(VEHICLE_SPEED, 1499, value));
+    CHECK_EQUAL(10, value);
+    CHECK(replay.getValue(VEHICLE_SPEED, 1500, value));
+    CHECK_EQUAL(20, value);
+    CHECK(replay.getValue(VEHICLE_SPEED, 3600, value)); // 3100 % 3000
+    CHECK_EQUAL(10, value);
+
+    replay.setSpeed(10);
+    CHECK_EQUAL(2000, replay.getTraceTime(700));
+    replay.setLoop(false);
+    CHECK_EQUAL(3000, replay.getTraceTime(100000));
+    CHECK(replay.getValue(VEHICLE_SPEED, 100000, value));
+    CHECK_EQUAL(30, value);
+}
+
+TEST(nothingBeforeTheFirstRecord)
+{
+    std::vector<uint8_t> trace = buildTrace({{VEHICLE_SPEED, {{2500, 7}}}}, 4000);
+    TestReader reader(trace);
+    TraceReplay replay;
+    replay.begin(&reader);
+    uint32_t value = 0;
+    CHECK(!replay.getValue(VEHICLE_SPEED, 2499, value));
+    CHECK(replay.getValue(VEHICLE_SPEED, 2500, value));
+    CHECK_EQUAL(7, value);
+    CHECK(!replay.getValue(VEHICLE_SPEED, 4100, value)); // looped, 100
+}
+
+TEST(readErrorsAreRetried)
+{
+    std::vector<uint8_t> trace = buildTrace({{VEHICLE_SPEED, {{0, 10}, {1000, 20}}}}, 2000);
+    TestReader reader(trace);
+    TraceReplay replay;
+    replay.begin(&reader);
+    uint32_t value = 0;
+    reader.broken = true;
+    CHECK(!replay.getValue(VEHICLE_SPEED, 1500, value));
+    reader.broken = false;
+    CHECK(replay.getValue(VEHICLE_SPEED, 1500, value));
+    CHECK_EQUAL(20, value);
+}
+
+// random lookups (small steps, jumps ahead and back, loops) against a search of all records
+TEST(seekMatchesModel)
+{
+    srand(3);
+    const uint32_t durationMs = 600000;
+    std::vector<TracePid> pids = {makePid(VEHICLE_SPEED, 50, 300, durationMs),
+                                  makePid(ENGINE_RPM, 0, 40, durationMs),
+                                  makePid(INTAKE_AIR_TEMP, 1200, 7000, durationMs)}; // several intervals apart
+    std::vector<uint8_t> trace = buildTrace(pids, durationMs);
+    TestReader reader(trace);
+    TraceReplay replay;
+    CHECK(replay.begin(&reader));
+
+    uint32_t now = 0;
+    for (uint32_t i = 0; i < 200000; i++)
+    {
+        switch (rand() % 8)
+        {
+        case 0:
+            now = rand() % (3 * durationMs); // anywhere, looping
+            break;
+        case 1:
+            now -= std::min<uint32_t>(now, rand() % 5000); // back
+            break;
+        case 2:
+            now += rand() % 20000;
+            break;
+        default:
+            now += rand() % 200;
+            break;
+        }
+        const TracePid &tracePid = pids[rand() % pids.size()];
+        uint32_t expected = 0;
+        bool found = expectedValue(tracePid, now % durationMs, expected);
+        uint32_t value = 0;
+        CHECK_EQUAL(found, replay.getValue(tracePid.pid, now, value));
+        if (found)
+        {
+            CHECK_EQUAL(expected, value);
+        }
+    }
+
+    // the current record answers without reading
+    uint32_t value = 0;
+    replay.getValue(VEHICLE_SPEED, now, value);
+    uint32_t reads = reader.reads;
+    CHECK(replay.getValue(VEHICLE_SPEED, now, value));
+    CHECK_EQUAL(reads, reader.reads);
+}
@@ -0,0 +1,109 @@
+#include <ELMulator.h>
+#include <string>
+#include "HostTest.h"
+#include "ReplayStream.h"
+
+/**
+ * Mode 09 vehicle information: the items kept by VehicleInfo and their
+ * responses, through OBDStreamComm, for the ATH, ATS and ATCAF settings.
+ */
+
+static const char *const VIN = "1HGCM82633A004352";
+
+// An engine without pids, echo off
+struct Vehicle
+{
+    ReplayStream replay;
+    OBDStreamComm transport;
+    ELMulator elm;
+
+    Vehicle() : transport(replay), elm(&transport)
+    {
+        elm.init("host");
+        run("ATE0\r");
+    }
+
+    const char *run(const std::string &requests)
+    {
+        replay.load(requests.c_str());
+        replay.clearOutput();
+        while (!replay.finished())
+        {
+            elm.poll();
+        }
+        return replay.getOutput();
+    }
+};
+
+TEST(supportedPidsListTheItems)
+{
+    Vehicle vehicle;
+    VehicleInfo &info = vehicle.elm.getVehicleInfo();
+    CHECK_STRING("49 00 00 00 00 00\r\n>", vehicle.run("0900\r"));
+    CHECK(info.setVin(VIN));
+    CHECK_STRING("49 00 40 00 00 00\r\n>", vehicle.run("0900\r"));
+    CHECK(info.addCalibrationVerificationNumber(0x1234ABCD));
+    CHECK(info.setEcuName("ECM-EngineControl"));
+    CHECK_STRING("49 00 44 40 00 00\r\n>", vehicle.run("0900\r"));
+}
+
+TEST(vinIsMultiFrame)
+{
+    Vehicle vehicle;
+    vehicle.elm.getVehicleInfo().setVin(VIN);
+    CHECK_STRING("014\r\n0: 49 02 01 31 48 47\r\n1: 43 4D 38 32 36 33 33\r\n2: 41 30 30 34 33 35 32\r\n>",
+                 vehicle.run("0902\r"));
+    CHECK_STRING("OK\r\n>014\r\n0:490201314847\r\n1:434D3832363333\r\n2:41303034333532\r\n>",
+                 vehicle.run("ATS0\r0902\r"));
+    CHECK_STRING("OK\r\n>7E81014490201314847\r\n7E821434D3832363333\r\n7E82241303034333532\r\n>",
+                 vehicle.run("ATH1\r0902\r"));
+    CHECK_STRING("OK\r\n>7E8 10 14 49 02 01 31 48 47\r\n7E8 21 43 4D 38 32 36 33 33\r\n7E8 22 41 30 30 34 33 35 32\r\n>",
+                 vehicle.run("ATS1\r0902\r"));
+    CHECK_STRING("OK\r\n>OK\r\n>10 14 49 02 01 31 48 47\r\n21 43 4D 38 32 36 33 33\r\n22 41 30 30 34 33 35 32\r\n>",
+                 vehicle.run("ATCAF0\rATH0\r0902\r"));
+}
+
+// one CVN fits a single frame
+TEST(cvnIsSingleFrame)
+{
+    Vehicle vehicle;
+    vehicle.elm.getVehicleInfo().addCalibrationVerificationNumber(0x1234ABCD);
+    CHECK_STRING("49 06 01 12 34 AB CD\r\n>", vehicle.run("0906\r"));
+    CHECK_STRING("OK\r\n>4906011234ABCD\r\n>", vehicle.run("ATS0\r0906\r"));
+    CHECK_STRING("OK\r\n>7E8074906011234ABCD\r\n>", vehicle.run("ATH1\r0906\r"));
+    CHECK_STRING("OK\r\n>7E8 07 49 06 01 12 34 AB CD\r\n>", vehicle.run("ATS1\r0906\r"));
+    CHECK_STRING("OK\r\n>OK\r\n>07 49 06 01 12 34 AB CD\r\n>", vehicle.run("ATCAF0\rATH0\r0906\r"));
+}
+
+TEST(calibrationIdsAreLimited)
+{
+    Vehicle vehicle;
+    VehicleInfo &info = vehicle.elm.getVehicleInfo();
+    CHECK(!info.addCalibrationId("JMB*47JCB12345678"));
+    for (uint8_t i = 0; i < MAX_CALIBRATION_IDS; i++)
+    {
+        CHECK(info.addCalibrationId("JMB*47JCB12345"));
+        CHECK(info.addCalibrationVerificationNumber(0x1234ABCD));
+    }
+    CHECK(!info.addCalibrationId("JMB*47JCB12345"));
+    CHECK(!info.addCalibrationVerificationNumber(0x1234ABCD));
+
+    VehicleInfo::Entry *calibrationIds = info.find(CALIBRATION_ID);
+    CHECK(calibrationIds != nullptr);
+    CHECK_EQUAL(3 + MAX_CALIBRATION_IDS * CALIBRATION_ID_LENGTH, calibrationIds->length);
+    CHECK_EQUAL(MAX_CALIBRATION_IDS, calibrationIds->payload[2]);
+    CHECK_EQUAL(3 + MAX_CALIBRATION_IDS * 4, info.find(CALIBRATION_VERIFICATION_NUMBER)->length);
+}
+
+TEST(longEcuNameIsRejected)
+{
+    Vehicle vehicle;
+    VehicleInfo &info = vehicle.elm.getVehicleInfo();
+    CHECK(!info.setEcuName("ECM-EngineControlUnit"));
+    CHECK(info.find(ECU_NAME) == nullptr);
+    CHECK_STRING("NO DATA\r\n>", vehicle.run("090A\r"));
+    CHECK(info.setEcuName("ECM-EngineControlUni"));
+    CHECK_STRING("017\r\n0: 49 0A 01 45 43 4D\r\n1: 2D 45 6E 67 69 6E 65\r\n2: 43 6F 6E 74 72 6F 6C\r\n3: 55 6E 69 00 00 00 00\r\n>",
+                 vehicle.run("090A\r"));
+    CHECK(!info.setVin("1HGCM82633A00435"));
+}
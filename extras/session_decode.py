@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+"""
+Decodes a session recorded by SessionRecorder (see src/SessionRecorder.h):
+prints the requests and responses in order with their time and latency,
+and reports the records dropped because the RAM ring buffer was full.
+
+    session_decode.py session.elmr
+    session_decode.py --csv session.elmr > session.csv
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+MAGIC = b"ELMR"
+HEADER = struct.Struct("<4sHHII")
+RECORD_HEADER = struct.Struct("<IIIHBB")
+DIRECTIONS = {0: "RX", 1: "TX"}
+
+
+def read_records(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < HEADER.size:
+        sys.exit(path + " is too short")
+    magic, version, record_size, max_records, _ = HEADER.unpack_from(data)
+    if magic != MAGIC or version != 1:
+        sys.exit(path + " is not an ELMulator session")
+
+    records = []
+    for offset in range(HEADER.size, len(data) - record_size + 1, record_size):
+        sequence, time_us, latency_us, length, direction, session = RECORD_HEADER.unpack_from(data, offset)
+        if sequence == 0:
+            continue  # never written
+        start = offset + RECORD_HEADER.size
+        kept = min(length, record_size - RECORD_HEADER.size)
+        records.append({
+            "sequence": sequence,
+            "time_us": time_us,
+            "latency_us": latency_us,
+            "length": length,
+            "direction": DIRECTIONS.get(direction, str(direction)),
+            "session": session,
+            "data": data[start:start + kept],
+            "truncated": kept < length,
+        })
+    records.sort(key=lambda record: record["sequence"])  # the file is a ring
+    return records, max_records
+
+
+def printable(data):
+    """Request/response text with control chars escaped, ex: 41 0C 1A F8\\r\\r>"""
+    return "".join(chr(b) if 32 <= b < 127 else {13: "\\r", 10: "\\n"}.get(b, "\\x%02x" % b) for b in data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input")
+    parser.add_argument("--csv", action="store_true", help="write CSV to stdout")
+    args = parser.parse_args()
+
+    records, max_records = read_records(args.input)
+    if not records:
+        print("no records")
+        return
+
+    dropped = 0
+    for previous, record in zip(records, records[1:]):
+        dropped += record["sequence"] - previous["sequence"] - 1
+    start = records[0]["time_us"]
+
+    if args.csv:
+        writer = csv.writer(sys.stdout)
+        writer.writerow(["sequence", "time_s", "session", "direction", "latency_us", "length", "data"])
+        for record in records:
+            writer.writerow([record["sequence"], "%.6f" % (((record["time_us"] - start) & 0xFFFFFFFF) / 1e6),
+                             record["session"], record["direction"],
+                             record["latency_us"] if record["direction"] == "TX" else "",
+                             record["length"], printable(record["data"])])
+        return
+
+    for record in records:
+        line = "%12.6f  %d %s  " % (((record["time_us"] - start) & 0xFFFFFFFF) / 1e6, record["session"], record["direction"])
+        line += "%7d us  " % record["latency_us"] if record["direction"] == "TX" else " " * 12
+        line += printable(record["data"])
+        if record["truncated"]:
+            line += " ... (%d bytes)" % record["length"]
+        print(line)
+
+    latencies = sorted(record["latency_us"] for record in records if record["direction"] == "TX")
+    print("\n%d records (file keeps %d), %d dropped" % (len(records), max_records, dropped))
+    if latencies:
+        print("latency us: median %d, p99 %d, max %d" % (
+            latencies[len(latencies) // 2], latencies[min(len(latencies) - 1, len(latencies) * 99 // 100)], latencies[-1]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""
+Converts ELM327 capture logs to the binary trace format read by TraceReplay
+(see src/TraceReplay.h), or dumps a converted trace.
+
+Input: one response per line, "<time><separator><response>", where the
+separator is a comma, semicolon, tab or spaces and the response the hex bytes
+sent by the vehicle, with or without spaces (ex: "12.31,41 0C 1A F8"). Lines
+that are not mode 01 responses (headers, AT replies, NO DATA, ...) are skipped,
+responses to multi pid requests (ex: "41 0C 1A F8 0D 40") are split using the
+lengths of responseBytes in src/definitions.h.
+
+    trace_convert.py drive.csv drive.elmt                  # times in seconds
+    trace_convert.py --time-unit ms drive.log drive.elmt
+    trace_convert.py --header DRIVE_TRACE drive.csv drive.h # const array for MemoryTraceReader
+    trace_convert.py --info drive.elmt
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+MAGIC = b"ELMT"
+VERSION = 1
+HEADER = struct.Struct("<4sHHII")
+DIRECTORY_ENTRY = struct.Struct("<BBBBIII")
+RECORD = struct.Struct("<II")
+SERVICE_01 = 0x01
+MAX_VALUE_BYTES = 4
+
+DEFINITIONS = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "src", "definitions.h")
+
+
+def load_response_bytes(path):
+    """responseBytes table of definitions.h, pid -> number of value bytes"""
+    with open(path) as f:
+        match = re.search(r"responseBytes\[[^\]]*\]\s*=\s*\{([^}]*)\}", f.read())
+    if not match:
+        sys.exit("responseBytes not found in " + path)
+    return [int(n) for n in re.findall(r"\d+", match.group(1))]
+
+
+def parse_line(line, time_scale):
+    """(time ms, response bytes) of a log line, None if it is not a response"""
+    fields = re.split(r"[,;\t ]+", line.strip(), maxsplit=1)
+    if len(fields) != 2:
+        return None
+    try:
+        time = float(fields[0]) * time_scale
+    except ValueError:
+        return None  # header or text
+    response = re.sub(r"[\s>]", "", fields[1])
+    if not re.fullmatch(r"([0-9A-Fa-f]{2})+", response):
+        return None
+    return int(round(time)), bytes.fromhex(response)
+
+
+def split_response(response, response_bytes):
+    """[(pid, nBytes, value)] of a mode 01 response"""
+    if len(response) < 2 or response[0] != 0x40 + SERVICE_01:
+        return []
+    values = []
+    position = 1
+    while position < len(response):
+        pid = response[position]
+        remaining = len(response) - position - 1
+        # unknown length: the rest of the response
+        n = response_bytes[pid] if pid < len(response_bytes) and response_bytes[pid] else remaining
+        if n == 0 or n > remaining:
+            break  # truncated
+        if n <= MAX_VALUE_BYTES and pid % 0x20 != 0:  # support queries are answered by the library
+            values.append((pid, n, int.from_bytes(response[position + 1:position + 1 + n], "big")))
+        position += 1 + n
+    return values
+
+
+def read_log(path, time_scale, response_bytes):
+    """{pid: (nBytes, [(time, value)])}, times starting at 0"""
+    samples = {}
+    first_time = None
+    with open(path, errors="replace") as f:
+        for line in f:
+            parsed = parse_line(line, time_scale)
+            if parsed is None:
+                continue
+            time, response = parsed
+            values = split_response(response, response_bytes)
+            if not values:
+                continue
+            if first_time is None:
+                first_time = time
+            for pid, n, value in values:
+                samples.setdefault(pid, (n, []))[1].append((max(time - first_time, 0), value))
+    for _, records in samples.values():
+        records.sort(key=lambda record: record[0])  # stable, keeps the log order of equal times
+    return samples
+
+
+def build_trace(samples, index_interval):
+    pids = sorted(samples)
+    duration = max((records[-1][0] for _, records in samples.values()), default=0)
+    n_slots = duration // index_interval + 1
+
+    offset = HEADER.size + DIRECTORY_ENTRY.size * len(pids)
+    directory = b""
+    body = b""
+    for pid in pids:
+        n, records = samples[pid]
+        index_offset = offset + len(body)
+        # entry i: number of records at or before i * index_interval
+        count = 0
+        for slot in range(n_slots):
+            while count < len(records) and records[count][0] <= slot * index_interval:
+                count += 1
+            body += struct.pack("<I", count)
+        records_offset = offset + len(body)
+        for time, value in records:
+            body += RECORD.pack(time, value)
+        directory += DIRECTORY_ENTRY.pack(SERVICE_01, pid, n, 0, len(records), records_offset, index_offset)
+
+    return HEADER.pack(MAGIC, VERSION, len(pids), duration, index_interval) + directory + body
+
+
+def write_header(trace, name, path):
+    with open(path, "w") as f:
+        f.write("// Generated by extras/trace_convert.py, read it with MemoryTraceReader\n")
+        f.write("#pragma once\n#include <stdint.h>\n\n")
+        f.write("const uint8_t %s[%d] = {\n" % (name, len(trace)))
+        for i in range(0, len(trace), 16):
+            f.write("    " + ", ".join("0x%02X" % b for b in trace[i:i + 16]) + ",\n")
+        f.write("};\n")
+
+
+def print_info(path):
+    with open(path, "rb") as f:
+        trace = f.read()
+    magic, version, n_pids, duration, interval = HEADER.unpack_from(trace)
+    if magic != MAGIC:
+        sys.exit(path + " is not an ELMulator trace")
+    print("version %d, %d pids, %.1f s, index every %d ms, %d bytes" % (version, n_pids, duration / 1000.0, interval, len(trace)))
+    for i in range(n_pids):
+        mode, pid, n, _, n_records, records_offset, _ = DIRECTORY_ENTRY.unpack_from(trace, HEADER.size + i * DIRECTORY_ENTRY.size)
+        first = RECORD.unpack_from(trace, records_offset) if n_records else (0, 0)
+        print("  %02X %02X  %d bytes  %6d records  first %d ms = 0x%X" % (mode, pid, n, n_records, first[0], first[1]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input")
+    parser.add_argument("output", nargs="?")
+    parser.add_argument("--time-unit", choices=["s", "ms"], default="s", help="unit of the log times (default s)")
+    parser.add_argument("--index-interval", type=int, default=1000, help="ms between index entries (default 1000)")
+    parser.add_argument("--header", metavar="NAME", help="write a C header with a NAME array instead of a binary file")
+    parser.add_argument("--definitions", default=DEFINITIONS, help="definitions.h with the responseBytes table")
+    parser.add_argument("--info", action="store_true", help="describe the trace given as input")
+    args = parser.parse_args()
+
+    if args.info:
+        print_info(args.input)
+        return
+    if args.output is None:
+        parser.error("output is required")
+    if args.index_interval <= 0:
+        parser.error("--index-interval must be positive")
+
+    samples = read_log(args.input, 1000.0 if args.time_unit == "s" else 1.0, load_response_bytes(args.definitions))
+    if not samples:
+        sys.exit("no mode 01 responses in " + args.input)
+    trace = build_trace(samples, args.index_interval)
+
+    if args.header:
+        write_header(trace, args.header, args.output)
+    else:
+        with open(args.output, "wb") as f:
+            f.write(trace)
+    n_records = sum(len(records) for _, records in samples.values())
+    print("%d pids, %d records, %d bytes" % (len(samples), n_records, len(trace)))
+
+
+if __name__ == "__main__":
+    main()
@@ -1,15 +1,106 @@
 #include "ATCommands.h"
 #include "definitions.h"
+#include "HexCodec.h"
 
-#if USE_WIFI
-ATCommands::ATCommands(OBDWiFiComm *connection) {
-    this->connection = connection;
+/**
+ * All ELM327 AT commands (without "AT"), sorted by name so a command can be
+ * found by narrowing the table one char at a time (see findCommand).
+ * Commands that only change a setting we do not emulate answer OK.
+ */
+constexpr ATCommands::Command ATCommands::COMMANDS[] = {
+    {"@1",   &ATCommands::ATDESC},
+    {"@2",   &ATCommands::ATOK},
+    {"@3",   &ATCommands::ATOK},
+    {"@STATS", &ATCommands::ATSTATS},
+    {"AL",   &ATCommands::ATOK},
+    {"AR",   &ATCommands::ATOK},
+    {"AT",   &ATCommands::ATATx},
+    {"BD",   &ATCommands::ATOK},
+    {"BI",   &ATCommands::ATOK},
+    {"BRD",  &ATCommands::ATOK},
+    {"BRT",  &ATCommands::ATOK},
+    {"CAF",  &ATCommands::ATCAFx},
+    {"CEA",  &ATCommands::ATOK},
+    {"CF",   &ATCommands::ATOK},
+    {"CFC",  &ATCommands::ATOK},
+    {"CM",   &ATCommands::ATOK},
+    {"CP",   &ATCommands::ATOK},
+    {"CRA",  &ATCommands::ATCRAx},
+    {"CS",   &ATCommands::ATOK},
+    {"CSM",  &ATCommands::ATOK},
+    {"CV",   &ATCommands::ATOK},
+    {"D",    &ATCommands::ATD},
+    {"D0",   &ATCommands::ATD0},
+    {"D1",   &ATCommands::ATD1},
+    {"DESC", &ATCommands::ATDESC},
+    {"DM1",  &ATCommands::ATOK},
+    {"DP",   &ATCommands::ATDP},
+    {"DPN",  &ATCommands::ATDPN},
+    {"E",    &ATCommands::ATEx},
+    {"FC",   &ATCommands::ATOK},
+    {"FE",   &ATCommands::ATOK},
+    {"FI",   &ATCommands::ATOK},
+    {"H",    &ATCommands::ATHx},
+    {"I",    &ATCommands::ATI},
+    {"IB",   &ATCommands::ATOK},
+    {"IFR",  &ATCommands::ATOK},
+    {"IGN",  &ATCommands::ATOK},
+    {"IIA",  &ATCommands::ATOK},
+    {"JE",   &ATCommands::ATOK},
+    {"JHF",  &ATCommands::ATOK},
+    {"JS",   &ATCommands::ATOK},
+    {"JTM",  &ATCommands::ATOK},
+    {"KW",   &ATCommands::ATOK},
+    {"L",    &ATCommands::ATLx},
+    {"LP",   &ATCommands::ATOK},
+    {"M",    &ATCommands::ATMx},
+    {"MA",   &ATCommands::ATOK},
+    {"MP",   &ATCommands::ATOK},
+    {"MR",   &ATCommands::ATOK},
+    {"MT",   &ATCommands::ATOK},
+    {"NL",   &ATCommands::ATOK},
+    {"PB",   &ATCommands::ATOK},
+    {"PC",   &ATCommands::ATPC},
+    {"PP",   &ATCommands::ATOK},
+    {"PPS",  &ATCommands::ATOK},
+    {"R",    &ATCommands::ATOK},
+    {"RA",   &ATCommands::ATOK},
+    {"RD",   &ATCommands::ATOK},
+    {"RTR",  &ATCommands::ATOK},
+    {"RV",   &ATCommands::ATRV},
+    {"S",    &ATCommands::ATSx},
+    {"SD",   &ATCommands::ATOK},
+    {"SH",   &ATCommands::ATSHx},
+    {"SI",   &ATCommands::ATOK},
+    {"SP",   &ATCommands::ATSPx},
+    {"SR",   &ATCommands::ATOK},
+    {"SS",   &ATCommands::ATOK},
+    {"ST",   &ATCommands::ATOK},
+    {"SW",   &ATCommands::ATOK},
+    {"TA",   &ATCommands::ATOK},
+    {"TP",   &ATCommands::ATOK},
+    {"V",    &ATCommands::ATOK},
+    {"WM",   &ATCommands::ATOK},
+    {"WS",   &ATCommands::ATZ},
+    {"Z",    &ATCommands::ATZ},
+};
+
+const uint8_t ATCommands::N_COMMANDS = sizeof(ATCommands::COMMANDS) / sizeof(ATCommands::COMMANDS[0]);
+
+constexpr bool isLess(const char *a, const char *b) {
+    return (*a == *b) ? (*a != '\0' && isLess(a + 1, b + 1)) : ((uint8_t)*a < (uint8_t)*b);
 }
-#else
-ATCommands::ATCommands(OBDSerialComm *connection) {
+
+constexpr bool isSorted(const ATCommands::Command *commands, uint8_t n) {
+    return n < 2 || (isLess(commands[0].name, commands[1].name) && isSorted(commands + 1, n - 1));
+}
+
+static_assert(isSorted(ATCommands::COMMANDS, sizeof(ATCommands::COMMANDS) / sizeof(ATCommands::COMMANDS[0])),
+              "AT command table must be sorted by name");
+
+ATCommands::ATCommands(OBDComm *connection) {
     this->connection = connection;
 }
-#endif
 
 ATCommands::~ATCommands() {
     operator delete(this->connection);
@@ -17,55 +108,26 @@ ATCommands::~ATCommands() {
 
 
 bool ATCommands::process(const String& command) {
+    return process(command.c_str());
+}
+
+bool ATCommands::process(const char *command) {
     bool processed = false;
     if (isATCommand(command)) {
         processed = true;
         processCommand(command);
-        DEBUG("RX AT: " + command);
+        ELM_LOG_DEBUG("AT command %s", command);
     }
     return processed;
 }
 
-void ATCommands::processCommand(const String& command) {
-
-    // if space is enabled (ex: AT H[charPosition])
-    uint8_t offset = 2;
-    if (command.charAt(2) == 0x20) {
-        offset = 3;
-    }
+void ATCommands::processCommand(const char *command) {
 
-    // refer to ELM327 specs
-    String specificCommand = command.substring(offset, command.length());
-    if (specificCommand.startsWith("D",offset)) {
-        ATCommands::ATD();
-    } else if (specificCommand.startsWith("Z")) {
-        ATCommands::ATZ();
-    } else if (specificCommand.startsWith("I")) {
-        ATCommands::ATI();
-    } else if (specificCommand.startsWith("E")) {
-        ATCommands::ATEx(specificCommand);
-    } else if (specificCommand.startsWith("L")) {
-        ATCommands::ATLx(specificCommand);
-    } else if (specificCommand.startsWith("M")) {
-        ATCommands::ATMx(specificCommand);
-    } else if (specificCommand.startsWith("SH")) {
-        ATCommands::ATSHx(specificCommand);
-    } else if (specificCommand.startsWith("SP")) {
-        ATCommands::ATSPx(specificCommand);
-    } else if (specificCommand.startsWith("S")) {
-        ATCommands::ATSx(specificCommand);
-    } else if (specificCommand.startsWith("H")) {
-        ATCommands::ATHx(specificCommand);
-    } else if (specificCommand.startsWith("AT")) {
-        ATCommands::ATATx(specificCommand);
-    } else if (specificCommand.startsWith("DPN")) {
-        ATCommands::ATDPN();
-    }  else if (specificCommand.startsWith("DESC") || specificCommand.startsWith("@1")) {
-        ATCommands::ATDESC();
-    } else if (specificCommand.startsWith("PC")) {
-        ATCommands::ATPC();
-    } else if (specificCommand.startsWith("RV")){
-        ATCommands::ATRV();
+    // refer to ELM327 specs, ELMRequest::parse already dropped the spaces (ex: "AT H1" -> "ATH1")
+    const char *specificCommand = command + 2;
+    const Command *cmd = findCommand(specificCommand);
+    if (cmd != nullptr) {
+        (this->*(cmd->handler))(specificCommand + strlen(cmd->name));
     } else {
 
         // lets assume we process any at command
@@ -73,106 +135,235 @@ void ATCommands::processCommand(const String& command) {
     }
 }
 
+/**
+ * Finds the longest command name that is a prefix of command (ex: "SH7E0" -> "SH").
+ * Names sharing their first i chars are contiguous in the sorted table, so each
+ * char of the command only narrows [lo, hi) with two binary searches: no allocation,
+ * O(length * log(N_COMMANDS)).
+ */
+const ATCommands::Command *ATCommands::findCommand(const char *command) {
+    const Command *match = nullptr;
+    uint8_t lo = 0;
+    uint8_t hi = N_COMMANDS;
+
+    for (uint8_t i = 0; command[i] != '\0' && lo < hi; i++) {
+        uint8_t c = command[i];
+
+        // first entry with name[i] >= c
+        uint8_t first = lo, last = hi;
+        while (first < last) {
+            uint8_t mid = (first + last) / 2;
+            if ((uint8_t)COMMANDS[mid].name[i] < c) {
+                first = mid + 1;
+            } else {
+                last = mid;
+            }
+        }
+        lo = first;
+
+        // first entry with name[i] > c
+        last = hi;
+        while (first < last) {
+            uint8_t mid = (first + last) / 2;
+            if ((uint8_t)COMMANDS[mid].name[i] <= c) {
+                first = mid + 1;
+            } else {
+                last = mid;
+            }
+        }
+        hi = first;
+
+        // a name ending here sorts first in the range
+        if (lo < hi && COMMANDS[lo].name[i + 1] == '\0') {
+            match = &COMMANDS[lo];
+        }
+    }
+    return match;
+}
+
 // set all to defaults
-void ATCommands::ATD() {
+void ATCommands::ATD(const char *args) {
     connection->setToDefaults();
     connection->writeEndOK();
 }
 
 // reset all
-void ATCommands::ATZ() {
+void ATCommands::ATZ(const char *args) {
     connection->setToDefaults();
     connection->writeTo(ID);
     connection->writeEndOK();
 }
 
 // Print the version ID
-void ATCommands::ATI() {
+void ATCommands::ATI(const char *args) {
     connection->writeTo(ID);
     connection->writeEndOK();
 }
 
 // send description
-void ATCommands::ATDESC() {
+void ATCommands::ATDESC(const char *args) {
     connection->writeTo(DESC);
     connection->writeEnd();
 }
 
 // set echoEnable 0=off 1=on
-void ATCommands::ATEx(String& cmd) {
-    connection->setEcho(cmd.equals("E0") ? false : true);
+void ATCommands::ATEx(const char *args) {
+    connection->setEcho(args[0] != '0');
     connection->writeEndOK();
 }
 
 // set memory off=0 on=1
-void ATCommands::ATMx(String& cmd) {
-    connection->setMemory(cmd.equals("M0") ? false : true);
+void ATCommands::ATMx(const char *args) {
+    connection->setMemory(args[0] != '0');
     connection->writeEndOK();
 }
 
 // line feeds off=0 on=1
-void ATCommands::ATLx(String& cmd) {
-    connection->setLineFeeds(cmd.equals("L0") ? false : true);
+void ATCommands::ATLx(const char *args) {
+    connection->setLineFeeds(args[0] != '0');
     connection->writeEndOK();
 }
 
 // ATSx printing spaces off=0 on=1
-void ATCommands::ATSx(String& cmd) {
-    connection->setWhiteSpaces(cmd.equals("S0") ? false : true);
+void ATCommands::ATSx(const char *args) {
+    connection->setWhiteSpaces(args[0] != '0');
     connection->writeEndOK();
 }
 
-// Set a custom header from "SHxyz" (xyz = hex)
-void ATCommands::ATSHx(String& cmd) {
-    // Remove "SH" prefix and any whitespace
-    String headerStr = cmd.substring(2);
-    headerStr.trim();
-
-    // Convert hex string to integer
-    int headerValue = (int)strtol(headerStr.c_str(), nullptr, 16);
-    // Add 8 to the parsed value as required
-    headerValue += 8;
+// Set the request header from "SHxyz" (xyz = hex), responses come from xyz + 8,
+// or the last 3 bytes of a 29 bit header (ex: "SHDA10F1", 18DA10F1 -> 7E0).
+// Anything but 3, 6 or 8 hex digits is answered "?" and keeps the header.
+void ATCommands::ATSHx(const char *args) {
+    uint8_t length = strlen(args);
+    if ((length != 3 && length != 6 && length != 8) || !HexCodec::isHex(args, length)) {
+        connection->writeEndUnknown();
+        return;
+    }
+    uint32_t header = strtoul(args, nullptr, 16);
+    if (length > 3) {
+        header = FrameFormatter::getStandardId(header);
+    }
+    connection->setRequestHeader(header);
+    connection->writeEndOK();
+}
 
-    connection->setCustomHeader(headerValue);
-    connection->setUseCustomHeader(true);
+// Only show responses from "CRAxyz", all of them if there is no xyz
+void ATCommands::ATCRAx(const char *args) {
+    connection->setReceiveFilter((uint16_t)strtol(args, nullptr, 16));
     connection->writeEndOK();
 }
 
 // Headers off=0 on=1
-void ATCommands::ATHx(String& cmd) {
-    connection->setHeaders(cmd.equals("H0") ? false : true);
+void ATCommands::ATHx(const char *args) {
+    connection->setHeaders(args[0] != '0');
+    connection->writeEndOK();
+}
+
+// CAN auto formatting off=0 on=1
+void ATCommands::ATCAFx(const char *args) {
+    connection->setAutoFormat(args[0] != '0');
     connection->writeEndOK();
 }
 
-// ATSPx Define protocol 0=auto
-void ATCommands::ATSPx(String& cmd) {
+// ATSPx Define protocol 0=auto (ex: SP6, SPA7), 6 to 9 are emulated, anything else is taken as 6
+void ATCommands::ATSPx(const char *args) {
+    uint8_t length = strlen(args);
+    char protocol = length > 0 ? args[length - 1] : '0';
+    connection->setProtocol(protocol - '0');
     connection->writeEndOK();
 }
 
-// set protocol
-void ATCommands::ATDPN() {
-    connection->writeTo(PROTOCOL);
+// describe the current protocol
+void ATCommands::ATDP(const char *args) {
+    static const char *const NAMES[] = {"ISO 15765-4 (CAN 11/500)", "ISO 15765-4 (CAN 29/500)",
+                                        "ISO 15765-4 (CAN 11/250)", "ISO 15765-4 (CAN 29/250)"};
+    connection->writeTo(NAMES[connection->getProtocol() - PROTOCOL_CAN_11_500]);
     connection->writeEnd();
 }
 
+// current protocol number
+void ATCommands::ATDPN(const char *args) {
+    connection->writeTo(connection->getProtocol());
+    connection->writeEnd();
+}
+
+// DLC display off
+void ATCommands::ATD0(const char *args) {
+    connection->setDlc(false);
+    connection->writeEndOK();
+}
+
+// DLC display on (with headers)
+void ATCommands::ATD1(const char *args) {
+    connection->setDlc(true);
+    connection->writeEndOK();
+}
+
 // AT AT2 adaptative time control
-void ATCommands::ATATx(String& cmd) {
+void ATCommands::ATATx(const char *args) {
     connection->writeEndOK();
 }
 
 // Terminates current diagnostic session. Protocol close
-void ATCommands::ATPC() {
+void ATCommands::ATPC(const char *args) {
     connection->writeEndOK();
 }
 
-void ATCommands::ATRV() {
+void ATCommands::ATRV(const char *args) {
     connection->writeTo("AT RV\r13.5V");
     connection->writeEnd();
 }
 
-// return true ir connectionand is AT
-bool ATCommands::isATCommand(const String& command) {
-    toUpperCase(command.charAt(0));
-    return command.startsWith("AT") ? true : false;
+// Accepted but not emulated
+void ATCommands::ATOK(const char *args) {
+    connection->writeEndOK();
 }
 
+/**
+ * Request statistics (see ELMStats), one response line per report line;
+ * "AT@STATS RESET" clears them. Answers "?" when built without ELM_STATS.
+ */
+void ATCommands::ATSTATS(const char *args) {
+#if ELM_STATS
+    if (strcmp(args, "RESET") == 0) {
+        ELMStats::reset();
+        connection->writeEndOK();
+        return;
+    }
+
+    // ends lines with the connection line end, except the last one
+    class ResponsePrint : public Print {
+    public:
+        ResponsePrint(OBDComm *connection) : connection(connection), lineEnd(false) {}
+
+        size_t write(uint8_t c) override {
+            if (c == '\r' || c == '\n') {
+                lineEnd = true;
+                return 1;
+            }
+            if (lineEnd) {
+                connection->writeLineEnd();
+                lineEnd = false;
+            }
+            char string[2] = {(char)c, '\0'};
+            connection->writeTo(string);
+            return 1;
+        }
+
+    private:
+        OBDComm *connection;
+        bool lineEnd;
+    };
+
+    ResponsePrint response(connection);
+    ELMStats::print(response);
+    connection->writeEnd();
+#else
+    connection->writeEndUnknown();
+#endif
+}
+
+// return true ir connectionand is AT
+bool ATCommands::isATCommand(const char *command) {
+    return toUpperCase(command[0]) == 'A' && toUpperCase(command[1]) == 'T';
+}
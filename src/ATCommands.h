@@ -3,63 +3,90 @@
 
 #include <Arduino.h>
 #include "definitions.h"
-#if USE_WIFI
-#include "OBDWiFiComm.h"
-#else
-#include "OBDSerialComm.h"
-#endif
+#include "OBDComm.h"
+#include "ELMLog.h"
+#include "ELMStats.h"
 
 class ATCommands
 {
 
 public:
-#if USE_WIFI
-    ATCommands(OBDWiFiComm *connection);
-#else
-    ATCommands(OBDSerialComm *connection);
-#endif
+    ATCommands(OBDComm *connection);
     ~ATCommands();
 
     bool process(const String &string);
 
+    /**
+     * Process a normalized AT command (upper case, no spaces, ex: "ATSH7E0")
+     *
+     * @return true if command is an AT command
+     */
+    bool process(const char *command);
+
+    // Handler for one AT command, args points to the chars following the command name
+    typedef void (ATCommands::*Handler)(const char *args);
+
+    struct Command
+    {
+        const char *name; // command name without "AT" (ex: "SH")
+        Handler handler;
+    };
+
+    // Command table, sorted by name
+    static const Command COMMANDS[];
+    static const uint8_t N_COMMANDS;
+
+    // Entry with the longest name prefixing command (without "AT", ex: "SH7E0" -> "SH"), nullptr if none
+    static const Command *findCommand(const char *command);
+
 private:
     // Variables
-#if USE_WIFI
-    OBDWiFiComm *connection;
-#else
-    OBDSerialComm *connection;
-#endif
-    void ATD();
+    OBDComm *connection;
+    void ATD(const char *args);
+
+    void ATD0(const char *args);
+
+    void ATD1(const char *args);
+
+    void ATZ(const char *args);
+
+    void ATI(const char *args);
+
+    void ATEx(const char *args);
+
+    void ATMx(const char *args);
+
+    void ATLx(const char *args);
+
+    void ATSx(const char *args);
+    void ATSHx(const char *args);
+    void ATSPx(const char *args);
 
-    void ATZ();
+    void ATHx(const char *args);
 
-    void ATI();
+    void ATCAFx(const char *args);
 
-    void ATEx(String &x);
+    void ATCRAx(const char *args);
 
-    void ATMx(String &x);
+    void ATATx(const char *args);
 
-    void ATLx(String &x);
+    void ATPC(const char *args);
 
-    void ATSx(String &x);
-    void ATSHx(String &x);
-    void ATSPx(String &x);
-    
-    void ATHx(String &x);
+    void ATDP(const char *args);
 
-    void ATATx(String &cmd);
+    void ATDPN(const char *args);
 
-    void ATPC();
+    void ATDESC(const char *args);
 
-    void ATDPN();
+    void ATRV(const char *args);
 
-    void ATDESC();
+    void ATOK(const char *args);
 
-    void ATRV();
+    void ATSTATS(const char *args);
 
-    void processCommand(const String &command);
+    void processCommand(const char *command);
 
-    bool isATCommand(const String &command);
+    bool isATCommand(const char *command);
 };
 
 #endif
@@ -0,0 +1,232 @@
+#include "DtcStore.h"
+
+static const char DTC_LETTERS[] = "PCBU";
+static const uint8_t RESPONSE_MODES[DtcStore::N_LISTS] = {SERVICE_03, SERVICE_07, SERVICE_0A};
+
+DtcStore::DtcStore()
+{
+    memset(states, 0, sizeof(states));
+    for (uint8_t list = 0; list < N_LISTS; list++)
+    {
+        states[0].responses[list][0] = RESPONSE_MODES[list] + 0x40;
+    }
+    sequence = 0;
+    storedListener = nullptr;
+    storedListenerContext = nullptr;
+}
+
+void DtcStore::setStoredListener(StoredListener listener, void *context)
+{
+    storedListener = listener;
+    storedListenerContext = context;
+}
+
+bool DtcStore::encode(const char *code, uint16_t &dtc)
+{
+    const char *letter = strchr(DTC_LETTERS, code[0] & ~0x20);
+    if (code[0] == '\0' || letter == nullptr || strlen(code) != 5)
+    {
+        return false;
+    }
+    uint16_t value = (letter - DTC_LETTERS) << 14;
+    for (uint8_t i = 1; i < 5; i++)
+    {
+        uint8_t digit = HexCodec::decodeDigit(code[i]);
+        if (digit == HexCodec::INVALID || (i == 1 && digit > 3))
+        {
+            return false;
+        }
+        value |= digit << (4 * (4 - i));
+    }
+    dtc = value;
+    return true;
+}
+
+void DtcStore::decode(uint16_t dtc, char *code)
+{
+    code[0] = DTC_LETTERS[dtc >> 14];
+    code[1] = HexCodec::encodeDigit((dtc >> 12) & 0x03);
+    for (uint8_t i = 2; i < 5; i++)
+    {
+        code[i] = HexCodec::encodeDigit(dtc >> (4 * (4 - i)));
+    }
+    code[5] = '\0';
+}
+
+bool DtcStore::add(const char *code, LIST list)
+{
+    uint16_t dtc;
+    return encode(code, dtc) && add(dtc, list);
+}
+
+bool DtcStore::add(uint16_t dtc, LIST list)
+{
+    State &state = edit();
+    uint8_t *response = state.responses[list];
+    bool added = find(response, dtc) < 0;
+    if (added)
+    {
+        uint8_t count = response[1];
+        if (count == MAX_DTCS)
+        {
+            return false;
+        }
+        response[2 + 2 * count] = dtc >> 8;
+        response[3 + 2 * count] = dtc & 0xFF;
+        response[1] = count + 1;
+    }
+    if (list == STORED)
+    {
+        state.mil = true;
+    }
+    publish();
+    if (added && list == STORED && storedListener != nullptr)
+    {
+        storedListener(dtc, storedListenerContext);
+    }
+    return true;
+}
+
+bool DtcStore::remove(const char *code, LIST list)
+{
+    uint16_t dtc;
+    return encode(code, dtc) && remove(dtc, list);
+}
+
+bool DtcStore::remove(uint16_t dtc, LIST list)
+{
+    State &state = edit();
+    uint8_t *response = state.responses[list];
+    int8_t index = find(response, dtc);
+    if (index < 0)
+    {
+        return false;
+    }
+    uint8_t count = response[1] - 1;
+    memmove(response + 2 + 2 * index, response + 4 + 2 * index, 2 * (count - index));
+    response[1] = count;
+    if (list == STORED && count == 0)
+    {
+        state.mil = false;
+    }
+    publish();
+    return true;
+}
+
+void DtcStore::clear()
+{
+    State &state = edit();
+    state.responses[STORED][1] = 0;
+    state.responses[PENDING][1] = 0;
+    state.mil = false;
+    publish();
+}
+
+uint8_t DtcStore::getCount(LIST list)
+{
+    State state;
+    read(state);
+    return state.responses[list][1];
+}
+
+uint16_t DtcStore::getDtc(LIST list, uint8_t index)
+{
+    State state;
+    read(state);
+    const uint8_t *response = state.responses[list];
+    return index < response[1] ? (response[2 + 2 * index] << 8) | response[3 + 2 * index] : 0;
+}
+
+void DtcStore::setMil(bool on)
+{
+    edit().mil = on;
+    publish();
+}
+
+bool DtcStore::isMilOn()
+{
+    State state;
+    read(state);
+    return state.mil;
+}
+
+void DtcStore::setMonitorStatus(uint32_t status)
+{
+    edit().monitorStatus = status & 0xFFFFFF;
+    publish();
+}
+
+uint32_t DtcStore::getMonitorStatus()
+{
+    State state;
+    read(state);
+    uint8_t count = state.responses[STORED][1] & 0x7F;
+    return ((uint32_t)(state.mil ? 0x80 | count : count) << 24) | state.monitorStatus;
+}
+
+uint8_t DtcStore::getResponse(LIST list, uint8_t *payload)
+{
+    uint32_t published;
+    uint8_t length;
+    do
+    {
+        published = sequence;
+        __sync_synchronize();
+        const uint8_t *response = states[published & 1].responses[list];
+        length = 2 + 2 * response[1];
+        memcpy(payload, response, length);
+        __sync_synchronize();
+    } while (published != sequence);
+    return length;
+}
+
+bool DtcStore::getList(uint8_t mode, LIST &list)
+{
+    for (uint8_t i = 0; i < N_LISTS; i++)
+    {
+        if (RESPONSE_MODES[i] == mode)
+        {
+            list = (LIST)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+DtcStore::State &DtcStore::edit()
+{
+    State &next = states[(sequence + 1) & 1];
+    next = states[sequence & 1];
+    return next;
+}
+
+void DtcStore::publish()
+{
+    __sync_synchronize();
+    sequence = sequence + 1;
+}
+
+void DtcStore::read(State &state)
+{
+    uint32_t published;
+    do
+    {
+        published = sequence;
+        __sync_synchronize();
+        state = states[published & 1];
+        __sync_synchronize();
+    } while (published != sequence);
+}
+
+// Index of dtc in a response payload, -1 if it is not there
+int8_t DtcStore::find(const uint8_t *response, uint16_t dtc)
+{
+    for (uint8_t i = 0; i < response[1]; i++)
+    {
+        if (((response[2 + 2 * i] << 8) | response[3 + 2 * i]) == dtc)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,122 @@
+#ifndef ELMulator_DtcStore_h
+#define ELMulator_DtcStore_h
+
+#include <Arduino.h>
+#include "definitions.h"
+#include "HexCodec.h"
+
+/**
+ * Diagnostic trouble codes of the emulated ECU, with the MIL status they imply.
+ *
+ * Codes (ex: "P0301") are encoded once, when they are added, into the 2 bytes
+ * sent on the bus, straight into the response payload of their list:
+ *
+ *   stored     mode 03   43 NN + 2 bytes per code
+ *   pending    mode 07   47 NN ...
+ *   permanent  mode 0A   4A NN ...
+ *
+ * so a request only copies a payload. Pid 0101 (MIL and number of stored
+ * codes) is computed from the same state, and mode 04 clears it.
+ *
+ * Changes are written to a second copy of the state, then published by
+ * bumping a sequence number (as SensorSampler does), so codes can be set
+ * from another task (ex: fault injection) while requests are answered;
+ * changes must come from one task at a time.
+ */
+class DtcStore
+{
+public:
+    enum LIST
+    {
+        STORED = 0,
+        PENDING = 1,
+        PERMANENT = 2,
+        N_LISTS = 3
+    };
+
+    // Called when a new code is stored, in the task that added it
+    typedef void (*StoredListener)(uint16_t dtc, void *context);
+
+    DtcStore();
+
+    // Only one listener, PidProcessor uses it to capture freeze frames
+    void setStoredListener(StoredListener listener, void *context);
+
+    /**
+     * Encodes a code as sent on the bus (ex: "P0301" -> 0x0301, "U0100" -> 0xC100)
+     *
+     * @return false if code is not a letter P, C, B or U and 4 hex digits
+     */
+    static bool encode(const char *code, uint16_t &dtc);
+
+    // Writes the text of dtc (ex: "P0301") to code, which must hold 6 chars
+    static void decode(uint16_t dtc, char *code);
+
+    /**
+     * Adds a code to a list, a stored code also turns the MIL on
+     *
+     * @return false if the code is not valid or the list already has MAX_DTCS codes
+     */
+    bool add(const char *code, LIST list = STORED);
+
+    bool add(uint16_t dtc, LIST list = STORED);
+
+    // @return false if the code was not in the list
+    bool remove(const char *code, LIST list = STORED);
+
+    bool remove(uint16_t dtc, LIST list = STORED);
+
+    // Mode 04: stored and pending codes are cleared and the MIL turned off, permanent codes stay
+    void clear();
+
+    uint8_t getCount(LIST list);
+
+    // index-th code of list, 0 if there is none
+    uint16_t getDtc(LIST list, uint8_t index);
+
+    void setMil(bool on);
+
+    bool isMilOn();
+
+    // Bytes B, C and D of pid 0101 (readiness monitors), ex: 0x076504
+    void setMonitorStatus(uint32_t status);
+
+    // Pid 0101 value: MIL (bit 31), number of stored codes, monitors
+    uint32_t getMonitorStatus();
+
+    /**
+     * Copies the response payload of list (ex: 43 02 03 01 04 20) to
+     * payload, which must hold DTC_RESPONSE_SIZE bytes
+     *
+     * @return payload length
+     */
+    uint8_t getResponse(LIST list, uint8_t *payload);
+
+    // List answering mode (03, 07, 0A), false for other modes
+    static bool getList(uint8_t mode, LIST &list);
+
+private:
+    struct State
+    {
+        uint8_t responses[N_LISTS][DTC_RESPONSE_SIZE]; // [1] is the number of codes
+        bool mil;
+        uint32_t monitorStatus;
+    };
+
+    State states[2];
+    volatile uint32_t sequence; // states[sequence & 1] is published
+
+    StoredListener storedListener;
+    void *storedListenerContext;
+
+    // Copy of the published state to change, then publish()
+    State &edit();
+
+    void publish();
+
+    void read(State &state);
+
+    static int8_t find(const uint8_t *response, uint16_t dtc);
+};
+
+#endif
@@ -0,0 +1,282 @@
+#include "ELMLog.h"
+
+ELMLog::Record ELMLog::ring[LOG_RING_SIZE];
+volatile uint32_t ELMLog::head = 0;
+volatile uint32_t ELMLog::tail = 0;
+volatile uint32_t ELMLog::dropped = 0;
+Print *ELMLog::output = &Serial;
+bool ELMLog::running = false;
+
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "LOG_RING_SIZE must be a power of 2");
+static_assert(LOG_MAX_ARGS <= 4, "arg types are packed in 8 bits");
+
+static const char LEVEL_NAMES[] = "-EWIDT";
+
+// laps around the ring, a slot is written once per lap
+static inline uint32_t getLap(uint32_t position)
+{
+    return position / LOG_RING_SIZE;
+}
+
+void ELMLog::begin(Print *output)
+{
+    ELMLog::output = output;
+#if HAS_FREERTOS
+    if (!running)
+    {
+        running = xTaskCreatePinnedToCore(taskLoop, "ELMLog", LOG_TASK_STACK_SIZE, nullptr,
+                                          LOG_TASK_PRIORITY, nullptr, LOG_TASK_CORE) == pdPASS;
+    }
+#endif
+}
+
+void ELMLog::update()
+{
+    if (!running)
+    {
+        while (print())
+        {
+        }
+    }
+}
+
+uint32_t ELMLog::getDropped()
+{
+    return dropped;
+}
+
+#if HAS_FREERTOS
+void ELMLog::taskLoop(void *unused)
+{
+    while (true)
+    {
+        while (print())
+        {
+        }
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_PERIOD_MS));
+    }
+}
+#endif
+
+/**
+ * Bounded multi producer queue: a writer claims a position by moving head
+ * forward, and may use its slot once the reader is done with the previous
+ * lap (turn == 2 * lap), so tasks on both cores can log at once.
+ */
+ELMLog::Record *ELMLog::reserve(uint32_t &position)
+{
+#if HAS_FREERTOS
+    uint32_t current = __atomic_load_n(&head, __ATOMIC_RELAXED);
+    while (true)
+    {
+        Record &record = ring[current & (LOG_RING_SIZE - 1)];
+        int32_t diff = (int32_t)(__atomic_load_n(&record.turn, __ATOMIC_ACQUIRE) - 2 * getLap(current));
+        if (diff == 0)
+        {
+            if (__atomic_compare_exchange_n(&head, &current, current + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                position = current;
+                return &record;
+            }
+        }
+        else if (diff < 0)
+        {
+            __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+            return nullptr;
+        }
+        else
+        {
+            current = __atomic_load_n(&head, __ATOMIC_RELAXED);
+        }
+    }
+#else
+    Record &record = ring[head & (LOG_RING_SIZE - 1)];
+    if (record.turn != 2 * getLap(head))
+    {
+        dropped = dropped + 1;
+        return nullptr;
+    }
+    position = head;
+    head = head + 1;
+    return &record;
+#endif
+}
+
+void ELMLog::commit(Record &record, uint32_t position)
+{
+#if HAS_FREERTOS
+    __atomic_store_n(&record.turn, 2 * getLap(position) + 1, __ATOMIC_RELEASE);
+#else
+    record.turn = 2 * getLap(position) + 1;
+#endif
+}
+
+// Prints the oldest message, false if there is none
+bool ELMLog::print()
+{
+    Record &record = ring[tail & (LOG_RING_SIZE - 1)];
+    uint32_t written = 2 * getLap(tail) + 1;
+#if HAS_FREERTOS
+    if (__atomic_load_n(&record.turn, __ATOMIC_ACQUIRE) != written)
+#else
+    if (record.turn != written)
+#endif
+    {
+        return false;
+    }
+
+    char line[LOG_LINE_SIZE];
+    format(record, line, sizeof(line));
+
+#if HAS_FREERTOS
+    __atomic_store_n(&record.turn, written + 1, __ATOMIC_RELEASE);
+#else
+    record.turn = written + 1;
+#endif
+    tail = tail + 1;
+
+    if (output != nullptr)
+    {
+        output->println(line);
+    }
+    return true;
+}
+
+/**
+ * printf of the record format with its stored args, one conversion at a
+ * time; length modifiers are ignored as every number was stored in 32 bits
+ */
+uint16_t ELMLog::format(const Record &record, char *line, uint16_t size)
+{
+    int n = snprintf(line, size, "%lu %c ", (unsigned long)record.timeMs, LEVEL_NAMES[record.level <= ELM_LOG_LEVEL_TRACE ? record.level : 0]);
+    uint16_t pos = n > 0 ? n : 0;
+    uint8_t arg = 0;
+    const char *f = record.format;
+
+    while (*f && pos < size - 1)
+    {
+        if (*f != '%' || f[1] == '%')
+        {
+            line[pos++] = *f;
+            f += (*f == '%') ? 2 : 1;
+            continue;
+        }
+
+        char spec[16];
+        uint8_t specLength = 0;
+        spec[specLength++] = *f++;
+        while (*f && strchr("-+ #0123456789.", *f) && specLength < sizeof(spec) - 3)
+        {
+            spec[specLength++] = *f++;
+        }
+        while (*f && strchr("hlzjtL", *f))
+        {
+            f++;
+        }
+        char conversion = *f;
+        if (conversion == '\0')
+        {
+            break;
+        }
+        f++;
+
+        if (arg >= record.nArgs)
+        {
+            line[pos++] = '?';
+            continue;
+        }
+        ARG_TYPE type = (ARG_TYPE)((record.types >> (2 * arg)) & 3);
+        uint32_t value = record.args[arg++];
+        float floatValue;
+        memcpy(&floatValue, &value, sizeof(floatValue));
+
+        char *end = line + pos;
+        uint16_t left = size - pos;
+        switch (conversion)
+        {
+        case 'd':
+        case 'i':
+            memcpy(spec + specLength, "ld", 3);
+            n = snprintf(end, left, spec, type == ARG_FLOAT ? (long)floatValue : (long)(int32_t)value);
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            spec[specLength++] = 'l';
+            spec[specLength++] = conversion;
+            spec[specLength] = '\0';
+            n = snprintf(end, left, spec, type == ARG_FLOAT ? (unsigned long)floatValue : (unsigned long)value);
+            break;
+        case 'c':
+            memcpy(spec + specLength, "c", 2);
+            n = snprintf(end, left, spec, (int)value);
+            break;
+        case 's':
+            memcpy(spec + specLength, "s", 2);
+            n = snprintf(end, left, spec, type == ARG_STRING ? record.text + value : "?");
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+            spec[specLength++] = conversion;
+            spec[specLength] = '\0';
+            n = snprintf(end, left, spec, type == ARG_FLOAT ? (double)floatValue
+                                          : type == ARG_INT ? (double)(int32_t)value : (double)value);
+            break;
+        default:
+            n = snprintf(end, left, "?");
+            break;
+        }
+        if (n > 0)
+        {
+            pos += (n < left) ? n : left - 1;
+        }
+    }
+    line[pos] = '\0';
+    return pos;
+}
+
+void ELMLog::addValue(Record &record, ARG_TYPE type, uint32_t value)
+{
+    if (record.nArgs == LOG_MAX_ARGS)
+    {
+        return;
+    }
+    record.types |= type << (2 * record.nArgs);
+    record.args[record.nArgs++] = value;
+}
+
+void ELMLog::addArg(Record &record, double value)
+{
+    float floatValue = value;
+    uint32_t bits;
+    memcpy(&bits, &floatValue, sizeof(bits));
+    addValue(record, ARG_FLOAT, bits);
+}
+
+// copied, the string may be gone when the message is printed
+void ELMLog::addArg(Record &record, const char *value)
+{
+    uint8_t offset = record.textLength;
+    if (value == nullptr)
+    {
+        value = "(null)";
+    }
+    while (*value && record.textLength < LOG_TEXT_SIZE - 1)
+    {
+        record.text[record.textLength++] = *value++;
+    }
+    if (record.textLength < LOG_TEXT_SIZE)
+    {
+        record.text[record.textLength++] = '\0';
+    }
+    else
+    {
+        offset = LOG_TEXT_SIZE - 1; // full, empty string
+    }
+    addValue(record, ARG_STRING, offset);
+}
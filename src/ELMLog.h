@@ -0,0 +1,151 @@
+#ifndef ELMulator_ELMLog_h
+#define ELMulator_ELMLog_h
+
+#include <Arduino.h>
+#include "definitions.h"
+
+/**
+ * Leveled printf style logging that stays out of the request path:
+ *
+ * ELM_LOG_WARN("Trace has %u pids, keeping %u", nPids, MAX_TRACE_PIDS);
+ *
+ * Messages above ELM_LOG_LEVEL (definitions.h) are removed by the
+ * preprocessor, their arguments are not even evaluated. Enabled messages
+ * only store the format (which must be a string literal), up to
+ * LOG_MAX_ARGS numbers and LOG_TEXT_SIZE chars of string arguments into a
+ * lock-free ring buffer; they are formatted and printed later by a
+ * background task (begin(), ESP32) or update(), called by ELMulator
+ * between requests. When the ring is full messages are dropped and counted.
+ */
+class ELMLog
+{
+public:
+    /**
+     * Print the messages to output (default Serial), in a background task
+     * if the board has FreeRTOS
+     */
+    static void begin(Print *output);
+
+    // Prints the waiting messages, does nothing while the background task runs
+    static void update();
+
+    // Messages lost because the ring buffer was full
+    static uint32_t getDropped();
+
+    template <typename... Args>
+    static void log(uint8_t level, const char *format, const Args &...args)
+    {
+        uint32_t position;
+        Record *record = reserve(position);
+        if (record == nullptr)
+        {
+            return;
+        }
+        record->timeMs = millis();
+        record->format = format;
+        record->level = level;
+        record->nArgs = 0;
+        record->types = 0;
+        record->textLength = 0;
+        addArgs(*record, args...);
+        commit(*record, position);
+    }
+
+private:
+    enum ARG_TYPE
+    {
+        ARG_INT = 0,
+        ARG_UINT = 1,
+        ARG_FLOAT = 2,
+        ARG_STRING = 3 // value is the offset in text
+    };
+
+    struct Record
+    {
+        volatile uint32_t turn; // even: free for lap turn / 2, odd: written in lap turn / 2
+        uint32_t timeMs;
+        const char *format;
+        uint8_t level;
+        uint8_t nArgs;
+        uint8_t types; // ARG_TYPE of each arg, 2 bits each
+        uint8_t textLength;
+        uint32_t args[LOG_MAX_ARGS];
+        char text[LOG_TEXT_SIZE];
+    };
+
+    static Record ring[LOG_RING_SIZE];
+    static volatile uint32_t head; // next position reserved by a writer
+    static volatile uint32_t tail; // next position printed
+    static volatile uint32_t dropped;
+    static Print *output;
+    static bool running;
+
+    static Record *reserve(uint32_t &position);
+
+    static void commit(Record &record, uint32_t position);
+
+    static bool print();
+
+    static uint16_t format(const Record &record, char *line, uint16_t size);
+
+    static void addArgs(Record &record) {}
+
+    template <typename First, typename... Rest>
+    static void addArgs(Record &record, const First &first, const Rest &...rest)
+    {
+        addArg(record, first);
+        addArgs(record, rest...);
+    }
+
+    static void addValue(Record &record, ARG_TYPE type, uint32_t value);
+
+    static void addArg(Record &record, bool value) { addValue(record, ARG_UINT, value); }
+    static void addArg(Record &record, char value) { addValue(record, ARG_INT, value); }
+    static void addArg(Record &record, signed char value) { addValue(record, ARG_INT, value); }
+    static void addArg(Record &record, unsigned char value) { addValue(record, ARG_UINT, value); }
+    static void addArg(Record &record, short value) { addValue(record, ARG_INT, value); }
+    static void addArg(Record &record, unsigned short value) { addValue(record, ARG_UINT, value); }
+    static void addArg(Record &record, int value) { addValue(record, ARG_INT, value); }
+    static void addArg(Record &record, unsigned int value) { addValue(record, ARG_UINT, value); }
+    static void addArg(Record &record, long value) { addValue(record, ARG_INT, value); }
+    static void addArg(Record &record, unsigned long value) { addValue(record, ARG_UINT, value); }
+    static void addArg(Record &record, double value);
+    static void addArg(Record &record, const char *value);
+    static void addArg(Record &record, const String &value) { addArg(record, value.c_str()); }
+
+#if HAS_FREERTOS
+    static void taskLoop(void *unused);
+#endif
+};
+
+#if ELM_LOG_LEVEL >= ELM_LOG_LEVEL_ERROR
+#define ELM_LOG_ERROR(...) ELMLog::log(ELM_LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define ELM_LOG_ERROR(...) do {} while (0)
+#endif
+
+#if ELM_LOG_LEVEL >= ELM_LOG_LEVEL_WARN
+#define ELM_LOG_WARN(...) ELMLog::log(ELM_LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define ELM_LOG_WARN(...) do {} while (0)
+#endif
+
+#if ELM_LOG_LEVEL >= ELM_LOG_LEVEL_INFO
+#define ELM_LOG_INFO(...) ELMLog::log(ELM_LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define ELM_LOG_INFO(...) do {} while (0)
+#endif
+
+#if ELM_LOG_LEVEL >= ELM_LOG_LEVEL_DEBUG
+#define ELM_LOG_DEBUG(...) ELMLog::log(ELM_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define ELM_LOG_DEBUG(...) do {} while (0)
+#endif
+
+#if ELM_LOG_LEVEL >= ELM_LOG_LEVEL_TRACE
+#define ELM_LOG_TRACE(...) ELMLog::log(ELM_LOG_LEVEL_TRACE, __VA_ARGS__)
+#else
+#define ELM_LOG_TRACE(...) do {} while (0)
+#endif
+
+#endif
@@ -0,0 +1,123 @@
+#include "ELMRequest.h"
+
+// services that are requested without a pid (ex: "03")
+static inline bool hasNoPid(uint8_t mode) {
+    return mode == 0x03 || mode == 0x04 || mode == 0x07 || mode == 0x0A;
+}
+
+void ELMRequest::clear() {
+    command[0] = '\0';
+    length = 0;
+    type = EMPTY;
+    mode = 0;
+    pid = 0;
+    pidBytes = 0;
+    numResponses = 0;
+    frame = 0;
+    pidCount = 0;
+}
+
+ELMRequest::TYPE ELMRequest::parse(const char *rxData, uint8_t rxLength) {
+    clear();
+
+    // single pass: drop whitespace and control chars, upper case the rest
+    for (uint8_t i = 0; i < rxLength; i++) {
+        char c = rxData[i];
+        if (c <= 0x20 || c == 0x7F) {
+            continue;
+        }
+        if (length == MAX_REQUEST_SIZE) {
+            command[0] = '\0';
+            length = 0;
+            type = INVALID;
+            return type;
+        }
+        if (c >= 'a' && c <= 'z') {
+            c -= 'a' - 'A';
+        }
+        command[length++] = c;
+    }
+    command[length] = '\0';
+
+    // a single <cr> means repeat the last command
+    if (length == 0) {
+        type = REPEAT;
+        return type;
+    }
+
+    if (length >= 2 && command[0] == 'A' && command[1] == 'T') {
+        type = AT;
+        return type;
+    }
+
+    if (length < 2 || !HexCodec::isHex(command, length)) {
+        type = INVALID;
+        return type;
+    }
+
+    mode = HexCodec::decodeByte(command);
+
+    // split the remaining chars in pid and response count
+    uint8_t rest = length - 2;
+    uint8_t pidChars = 0;
+    if (!hasNoPid(mode)) {
+        pidChars = (mode == 0x22 && rest >= 4) ? 4 : 2;
+        if (rest < pidChars) {
+            pidChars = rest & ~1;
+        }
+    }
+
+    uint8_t pos = 2;
+    for (; pos < 2 + pidChars; pos++) {
+        pid = (pid << 4) | HexCodec::decodeDigit(command[pos]);
+    }
+    pidBytes = pidChars / N_CHARS_IN_BYTE;
+    if (pidBytes == 1) {
+        pids[pidCount++] = (uint8_t)pid;
+    }
+
+    // mode 01 can request more pids in one go (ex: 010C0D11)
+    if (mode == 0x01) {
+        while (length - pos >= 2 && pidCount < MAX_PIDS_PER_REQUEST) {
+            pids[pidCount++] = HexCodec::decodeByte(command + pos);
+            pos += 2;
+        }
+    }
+
+    // mode 02 pids are followed by the frame number (ex: 020C00)
+    if (mode == 0x02 && pidBytes == 1 && length - pos >= 2) {
+        frame = HexCodec::decodeByte(command + pos);
+        pos += 2;
+    }
+
+    if (length - pos == 1) {
+        numResponses = HexCodec::decodeDigit(command[pos]);
+    }
+
+    // keep only mode + pids (+ frame), response count and extra pids are dropped
+    length = pos;
+    command[length] = '\0';
+    type = PID;
+    return type;
+}
+
+bool ELMRequest::isMode(uint8_t service) const {
+    return type == PID && mode == service;
+}
+
+bool ELMRequest::isMultiPid() const {
+    return pidCount > 1;
+}
+
+void ELMRequest::setPids(const uint8_t *newPids, uint8_t count) {
+    length = 2; // keep the mode
+    for (uint8_t i = 0; i < count; i++) {
+        pids[i] = newPids[i];
+        HexCodec::encodeByte(pids[i], command + length);
+        length += 2;
+    }
+    command[length] = '\0';
+    pidCount = count;
+    pid = count > 0 ? pids[0] : 0;
+    pidBytes = count > 0 ? 1 : 0;
+}
@@ -0,0 +1,69 @@
+#ifndef ELMulator_ELMRequest_h
+#define ELMulator_ELMRequest_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include "definitions.h"
+#include "HexCodec.h"
+
+/**
+ * A single request received from the OBD client, tokenized in place.
+ *
+ * The raw line is parsed in a single pass without any heap allocation:
+ * whitespace and control chars are dropped, letters are upper-cased and
+ * PID requests are split into mode, PID and the optional response count
+ * (ex: "01 0c 1" -> mode 0x01, pid 0x0C, numResponses 1).
+ */
+struct ELMRequest
+{
+    enum TYPE
+    {
+        EMPTY = 0,   // nothing received (ex: read timeout)
+        REPEAT = 1,  // a single <cr>, repeat the last command
+        AT = 2,      // AT command
+        PID = 3,     // OBD request (mode + optional pid + optional response count)
+        INVALID = 4  // not hex, too long or otherwise malformed
+    };
+
+    // Normalized request: upper case, no whitespace or control chars,
+    // response count removed (ex: "010C", "2218E4", "ATSP6")
+    char command[MAX_REQUEST_SIZE + 1];
+    uint8_t length;
+
+    TYPE type;
+    uint8_t mode;         // OBD service (ex: 0x01)
+    uint16_t pid;         // 8 bit for standard services, 16 bit for mode 22
+    uint8_t pidBytes;     // number of bytes of the pid (0 if the request has no pid)
+    uint8_t numResponses; // optional response count, 0 if not present
+    uint8_t frame;        // freeze frame number of a mode 02 request (ex: "020C01" -> 1), 0 if not present
+
+    // All requested 1 byte pids, pids[0] == pid (only mode 01 can have more than one)
+    uint8_t pids[MAX_PIDS_PER_REQUEST];
+    uint8_t pidCount;
+
+    void clear();
+
+    /**
+     * Parse a raw line as received from the client (without the end char).
+     *
+     * @param rxData - raw chars received
+     * @param rxLength - number of chars in rxData; anything over
+     *                   MAX_REQUEST_SIZE is reported as INVALID
+     * @return the request type
+     */
+    TYPE parse(const char *rxData, uint8_t rxLength);
+
+    bool isMode(uint8_t service) const;
+
+    bool isMultiPid() const;
+
+    /**
+     * Replace the 1 byte pids of the request (ex: to drop unsupported ones),
+     * command is rebuilt to match (ex: "010C0D")
+     *
+     * @param newPids - may be pids itself
+     */
+    void setPids(const uint8_t *newPids, uint8_t count);
+};
+
+#endif
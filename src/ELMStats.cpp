@@ -0,0 +1,274 @@
+#include "ELMStats.h"
+
+#if ELM_STATS
+
+ELMStats::Histogram ELMStats::histograms[N_STAGES];
+uint32_t ELMStats::current[N_STAGES];
+uint8_t ELMStats::touched = 0;
+bool ELMStats::active = false;
+uint32_t ELMStats::startTicks = 0;
+uint32_t ELMStats::lastTicks = 0;
+uint32_t ELMStats::requests = 0;
+uint32_t ELMStats::modeRequests[N_MODE_SLOTS];
+uint32_t ELMStats::pidRequests[maxPid + 1];
+uint32_t ELMStats::errors[N_ERROR_TYPES];
+uint32_t ELMStats::rxBytes = 0;
+uint32_t ELMStats::txBytes = 0;
+uint32_t ELMStats::resetMs = 0;
+
+static const char *const STAGE_NAMES[] = {"parse", "dispatch", "handler", "format", "transport", "total"};
+static const char *const ERROR_NAMES[] = {"?", "NO DATA", "ERROR"};
+
+void ELMStats::startRequest(uint16_t rxBytes)
+{
+    ELMStats::rxBytes += rxBytes;
+    startTicks = getTicks();
+    lastTicks = startTicks;
+    touched = 0;
+    active = true;
+}
+
+void ELMStats::mark(STAGE stage)
+{
+    if (!active)
+    {
+        return;
+    }
+    uint32_t now = getTicks();
+    uint8_t bit = 1 << stage;
+    current[stage] = (touched & bit) ? current[stage] + (now - lastTicks) : now - lastTicks;
+    touched |= bit;
+    lastTicks = now;
+}
+
+void ELMStats::endRequest()
+{
+    if (!active)
+    {
+        return;
+    }
+    mark(STAGE_TRANSPORT);
+    for (uint8_t stage = 0; stage < STAGE_TOTAL; stage++)
+    {
+        if (touched & (1 << stage))
+        {
+            add(histograms[stage], current[stage]);
+        }
+    }
+    add(histograms[STAGE_TOTAL], lastTicks - startTicks);
+    active = false;
+}
+
+void ELMStats::countRequest(const ELMRequest &request)
+{
+    requests++;
+    if (request.type == ELMRequest::AT)
+    {
+        modeRequests[0]++;
+        return;
+    }
+    modeRequests[getModeSlot(request.mode)]++;
+    if (request.isMode(SERVICE_01))
+    {
+        for (uint8_t i = 0; i < request.pidCount; i++)
+        {
+            pidRequests[request.pids[i]]++;
+        }
+    }
+}
+
+void ELMStats::countError(ERROR_TYPE error)
+{
+    errors[error]++;
+}
+
+void ELMStats::countTx(uint16_t txBytes)
+{
+    ELMStats::txBytes += txBytes;
+}
+
+void ELMStats::reset()
+{
+    memset(histograms, 0, sizeof(histograms));
+    memset(modeRequests, 0, sizeof(modeRequests));
+    memset(pidRequests, 0, sizeof(pidRequests));
+    memset(errors, 0, sizeof(errors));
+    requests = 0;
+    rxBytes = 0;
+    txBytes = 0;
+    active = false;
+    resetMs = millis();
+}
+
+uint32_t ELMStats::getRequests()
+{
+    return requests;
+}
+
+uint32_t ELMStats::getModeRequests(uint8_t mode)
+{
+    return modeRequests[mode == 0 ? 0 : getModeSlot(mode)];
+}
+
+uint32_t ELMStats::getPidRequests(uint8_t pid)
+{
+    return pidRequests[pid];
+}
+
+uint32_t ELMStats::getErrors(ERROR_TYPE error)
+{
+    return errors[error];
+}
+
+uint32_t ELMStats::getCount(STAGE stage)
+{
+    return histograms[stage].count;
+}
+
+uint32_t ELMStats::getPercentileNs(STAGE stage, uint8_t percent)
+{
+    const Histogram &histogram = histograms[stage];
+    if (histogram.count == 0)
+    {
+        return 0;
+    }
+    uint32_t rank = ((uint64_t)histogram.count * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (uint8_t bucket = 0; bucket < STATS_HISTOGRAM_BUCKETS - 1; bucket++)
+    {
+        seen += histogram.buckets[bucket];
+        if (seen >= rank)
+        {
+            uint32_t upper = (uint32_t)2 << bucket;
+            return toNs(upper < histogram.max ? upper : histogram.max);
+        }
+    }
+    return toNs(histogram.max);
+}
+
+uint32_t ELMStats::getMaxNs(STAGE stage)
+{
+    return toNs(histograms[stage].max);
+}
+
+uint32_t ELMStats::getMeanNs(STAGE stage)
+{
+    const Histogram &histogram = histograms[stage];
+    return histogram.count > 0 ? toNs(histogram.sum / histogram.count) : 0;
+}
+
+void ELMStats::print(Print &out)
+{
+    char line[STATS_LINE_SIZE];
+    uint32_t elapsedMs = millis() - resetMs;
+    snprintf(line, sizeof(line), "%lu requests in %lu s (%lu/s), rx %lu B, tx %lu B",
+             (unsigned long)requests, (unsigned long)(elapsedMs / 1000),
+             (unsigned long)(elapsedMs > 0 ? (uint64_t)requests * 1000 / elapsedMs : 0),
+             (unsigned long)rxBytes, (unsigned long)txBytes);
+    out.println(line);
+
+    out.println("stage         count   mean ns    p50 ns    p99 ns    max ns");
+    for (uint8_t stage = 0; stage < N_STAGES; stage++)
+    {
+        STAGE s = (STAGE)stage;
+        snprintf(line, sizeof(line), "%-9s %9lu %9lu %9lu %9lu %9lu", STAGE_NAMES[stage],
+                 (unsigned long)getCount(s), (unsigned long)getMeanNs(s), (unsigned long)getPercentileNs(s, 50),
+                 (unsigned long)getPercentileNs(s, 99), (unsigned long)getMaxNs(s));
+        out.println(line);
+    }
+
+    int n = snprintf(line, sizeof(line), "errors");
+    for (uint8_t error = 0; error < N_ERROR_TYPES; error++)
+    {
+        n += snprintf(line + n, sizeof(line) - n, " %s %lu", ERROR_NAMES[error], (unsigned long)errors[error]);
+    }
+    out.println(line);
+
+    // only what was requested, several entries per line
+    n = snprintf(line, sizeof(line), "modes");
+    for (uint8_t slot = 0; slot < N_MODE_SLOTS; slot++)
+    {
+        if (modeRequests[slot] == 0)
+        {
+            continue;
+        }
+        char name[6];
+        if (slot == 0)
+        {
+            strcpy(name, "AT");
+        }
+        else if (slot == MODE_SLOT_OTHER)
+        {
+            strcpy(name, "other");
+        }
+        else
+        {
+            snprintf(name, sizeof(name), "%02X", slot == MODE_SLOT_22 ? SERVICE_22 : slot);
+        }
+        if (n > (int)sizeof(line) - 20)
+        {
+            out.println(line);
+            n = snprintf(line, sizeof(line), "modes");
+        }
+        n += snprintf(line + n, sizeof(line) - n, " %s %lu", name, (unsigned long)modeRequests[slot]);
+    }
+    out.println(line);
+
+    n = snprintf(line, sizeof(line), "pids");
+    bool empty = true;
+    for (uint16_t pid = 0; pid <= maxPid; pid++)
+    {
+        if (pidRequests[pid] == 0)
+        {
+            continue;
+        }
+        if (n > (int)sizeof(line) - 16)
+        {
+            out.println(line);
+            n = snprintf(line, sizeof(line), "pids");
+        }
+        n += snprintf(line + n, sizeof(line) - n, " %02X %lu", (unsigned)pid, (unsigned long)pidRequests[pid]);
+        empty = false;
+    }
+    if (!empty)
+    {
+        out.println(line);
+    }
+}
+
+uint32_t ELMStats::toNs(uint64_t ticks)
+{
+#ifdef ARDUINO_ARCH_ESP32
+    return ticks * 1000 / ESP.getCpuFreqMHz();
+#else
+    return ticks * 1000; // micros()
+#endif
+}
+
+// bucket b holds [2^b, 2^(b+1)) ticks, 0 and 1 tick go to bucket 0
+void ELMStats::add(Histogram &histogram, uint32_t ticks)
+{
+    uint8_t bucket = ticks > 1 ? 31 - __builtin_clz(ticks) : 0;
+    if (bucket >= STATS_HISTOGRAM_BUCKETS)
+    {
+        bucket = STATS_HISTOGRAM_BUCKETS - 1;
+    }
+    histogram.buckets[bucket]++;
+    histogram.count++;
+    histogram.sum += ticks;
+    if (ticks > histogram.max)
+    {
+        histogram.max = ticks;
+    }
+}
+
+uint8_t ELMStats::getModeSlot(uint8_t mode)
+{
+    if (mode > 0 && mode < MODE_SLOT_22)
+    {
+        return mode;
+    }
+    return mode == SERVICE_22 ? MODE_SLOT_22 : MODE_SLOT_OTHER;
+}
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef ELMulator_ELMStats_h
+#define ELMulator_ELMStats_h
+
+#include <Arduino.h>
+#include "definitions.h"
+#include "ELMRequest.h"
+
+/**
+ * Where the time of each request goes, and what clients ask for.
+ *
+ * A request is timed from its end char to its last transport write, split
+ * into stages by marks along the request path; the time since the previous
+ * mark is added to the marked stage:
+ *
+ *   parse      tokenizing the line (ELMRequest::parse)
+ *   dispatch   routing: AT command lookup, supported pid checks
+ *   handler    getting the values: pid handlers, sampler, replay, simulation
+ *   format     hex, spaces, headers, cache lookups, up to the transport write
+ *   transport  transport writes and flush
+ *   total      the whole request
+ *
+ * Times are read from the CPU cycle counter (micros() on boards without
+ * one) and kept as log2 histograms, so recording a stage is a few
+ * instructions and percentiles are within a factor of 2. Requests are
+ * also counted per mode and per mode 01 pid, and "?", NO DATA and ERROR
+ * answers are counted.
+ *
+ * Everything compiles out unless ELM_STATS is set (definitions.h). The
+ * statistics are global and not locked: they assume requests are handled by
+ * one ELMulator loop at a time. Print them with print(Serial) or send
+ * AT@STATS (AT@STATS RESET clears them).
+ */
+class ELMStats
+{
+public:
+    enum STAGE
+    {
+        STAGE_PARSE = 0,
+        STAGE_DISPATCH = 1,
+        STAGE_HANDLER = 2,
+        STAGE_FORMAT = 3,
+        STAGE_TRANSPORT = 4,
+        STAGE_TOTAL = 5,
+        N_STAGES = 6
+    };
+
+    enum ERROR_TYPE
+    {
+        ERROR_UNKNOWN = 0, // "?"
+        ERROR_NO_DATA = 1,
+        ERROR_ERROR = 2,
+        N_ERROR_TYPES = 3
+    };
+
+    // A request line was received, starts timing it
+    static void startRequest(uint16_t rxBytes);
+
+    // Adds the time since the previous mark to stage
+    static void mark(STAGE stage);
+
+    // The response was sent, adds the times of the request to the histograms
+    static void endRequest();
+
+    static void countRequest(const ELMRequest &request);
+
+    static void countError(ERROR_TYPE error);
+
+    static void countTx(uint16_t txBytes);
+
+    static void reset();
+
+    // Human readable report, one line per stage plus counters
+    static void print(Print &out);
+
+    static uint32_t getRequests();
+
+    // mode is 0 for AT commands
+    static uint32_t getModeRequests(uint8_t mode);
+
+    static uint32_t getPidRequests(uint8_t pid);
+
+    static uint32_t getErrors(ERROR_TYPE error);
+
+    // Requests timed for stage
+    static uint32_t getCount(STAGE stage);
+
+    // Upper bound of the time under which percent % of the stage samples are, in ns
+    static uint32_t getPercentileNs(STAGE stage, uint8_t percent);
+
+    static uint32_t getMaxNs(STAGE stage);
+
+    static uint32_t getMeanNs(STAGE stage);
+
+private:
+    // AT, modes 0x01 to 0x0F, 0x22, anything else
+    static const uint8_t MODE_SLOT_22 = 16;
+    static const uint8_t MODE_SLOT_OTHER = 17;
+    static const uint8_t N_MODE_SLOTS = 18;
+
+    struct Histogram
+    {
+        uint32_t buckets[STATS_HISTOGRAM_BUCKETS];
+        uint32_t count;
+        uint64_t sum; // ticks
+        uint32_t max;
+    };
+
+    static Histogram histograms[N_STAGES];
+
+    // ticks of each stage for the current request
+    static uint32_t current[N_STAGES];
+    static uint8_t touched; // bit for each stage marked in the current request
+    static bool active;
+    static uint32_t startTicks;
+    static uint32_t lastTicks;
+
+    static uint32_t requests;
+    static uint32_t modeRequests[N_MODE_SLOTS];
+    static uint32_t pidRequests[maxPid + 1];
+    static uint32_t errors[N_ERROR_TYPES];
+    static uint32_t rxBytes;
+    static uint32_t txBytes;
+    static uint32_t resetMs;
+
+    static inline uint32_t getTicks()
+    {
+#ifdef ARDUINO_ARCH_ESP32
+        return ESP.getCycleCount();
+#else
+        return micros();
+#endif
+    }
+
+    static uint32_t toNs(uint64_t ticks);
+
+    static void add(Histogram &histogram, uint32_t ticks);
+
+    static uint8_t getModeSlot(uint8_t mode);
+};
+
+#if ELM_STATS
+#define ELM_STATS_START(rxBytes) ELMStats::startRequest(rxBytes)
+#define ELM_STATS_MARK(stage) ELMStats::mark(ELMStats::STAGE_##stage)
+#define ELM_STATS_END() ELMStats::endRequest()
+#define ELM_STATS_REQUEST(request) ELMStats::countRequest(request)
+#define ELM_STATS_ERROR(error) ELMStats::countError(ELMStats::ERROR_##error)
+#define ELM_STATS_TX(txBytes) ELMStats::countTx(txBytes)
+#else
+#define ELM_STATS_START(rxBytes) do {} while (0)
+#define ELM_STATS_MARK(stage) do {} while (0)
+#define ELM_STATS_END() do {} while (0)
+#define ELM_STATS_REQUEST(request) do {} while (0)
+#define ELM_STATS_ERROR(error) do {} while (0)
+#define ELM_STATS_TX(txBytes) do {} while (0)
+#endif
+
+#endif
@@ -1,28 +1,32 @@
 #include "ELMulator.h"
 
+#if HAS_ESP32_TRANSPORTS
 #if USE_WIFI
-ELMulator::ELMulator()
+ELMulator::ELMulator() : ELMulator(new OBDWiFiComm())
 {
-    _connection = new OBDWiFiComm();
-    _atProcessor = new ATCommands(_connection);
-    _pidProcessor = new PidProcessor(_connection);
-    _lastCommand = "";
-    elmRequest.reserve(MAX_REQUEST_SIZE);
-    elmRequest = "";
 }
 #else
-ELMulator::ELMulator()
+ELMulator::ELMulator() : ELMulator(new OBDSerialComm())
+{
+}
+#endif
+#endif
+
+ELMulator::ELMulator(OBDTransport *transport)
 {
-    _connection = new OBDSerialComm();
+    _connection = new OBDComm(transport);
     _atProcessor = new ATCommands(_connection);
     _pidProcessor = new PidProcessor(_connection);
-    _lastCommand = "";
+    _pidProcessor->setValueSource(onFreezeFrameValue, this);
+    _pidRequestCallback = nullptr;
+    _sampler = nullptr;
+    _replay = nullptr;
+    _recorder = nullptr;
+    _request.clear();
+    _lastRequest.clear();
     elmRequest.reserve(MAX_REQUEST_SIZE);
     elmRequest = "";
 }
-#endif
-
-
 
 ELMulator::~ELMulator() {}
 
@@ -35,38 +39,126 @@ void ELMulator::init(const String &deviceName, bool registerPids)
     }
 }
 
+// PIDs 0x01 to 0x65, built at compile time
+static constexpr SupportedPids MOCK_MODE01_PIDS = makeSupportedPidRange(0x01, 0x65);
+
 void ELMulator::registerAllMode01Pids()
 {
     // Set up PIDs 0x00 to 0x65
     // Will be provided a response with mock data value if no special handling is performed.
     // Requests for PID > 0x65 are not currently supported - will return "NO DATA"
-    for (int i = 0; i < 0x66; i++)
+    _pidProcessor->registerPids(SERVICE_01, MOCK_MODE01_PIDS);
+}
+
+bool ELMulator::registerPids(uint8_t mode, const SupportedPids &pids)
+{
+    return _pidProcessor->registerPids(mode, pids);
+}
+
+bool ELMulator::readELMRequest()
+{
+    while (!receiveRequest())
     {
-        _pidProcessor->registerMode01Pid(i);
+        yield();
     }
+    return true; // We have received a valid PID request we need to respond to
 }
 
-bool ELMulator::readELMRequest()
+bool ELMulator::poll()
 {
-    do
+    if (!receiveRequest())
+    {
+        return false;
+    }
+
+    if (_pidRequestCallback != nullptr)
     {
-        elmRequest.clear(); // clear buffer from previous requests
-        _connection->readData(elmRequest);
-        elmRequest.toUpperCase();
-        // TODO ignore spaces, and all control chars (tab, etc)
-        // TODO accept single carriage return as repeat last command at or pid
-        // ignore null i.e 00
-    } while (processRequest(elmRequest)); // processRequest handles all non PID requests (AT commands, errors etc)
-    return true;                          // We have received a valid PID request we need to respond to
+        _pidRequestCallback(elmRequest);
+    }
+    else
+    {
+        sendELMResponse();
+    }
+    return true;
+}
+
+void ELMulator::setFlushPolicy(OBDComm::FLUSH_POLICY policy)
+{
+    _connection->setFlushPolicy(policy);
+}
+
+void ELMulator::setSessionRecorder(SessionRecorder *recorder)
+{
+    _recorder = recorder;
+    _connection->setRecorder(recorder);
+}
+
+void ELMulator::onPidRequest(PidRequestCallback callback)
+{
+    _pidRequestCallback = callback;
+}
+
+/**
+ * Takes the bytes available without waiting and, once a line is complete,
+ * handles it. Returns true only for a PID request the user has to answer.
+ */
+bool ELMulator::receiveRequest()
+{
+    if (_sampler != nullptr)
+    {
+        _sampler->update(); // no-op if it has its own task
+    }
+    _simulator.update(millis());
+#if HAS_FS
+    if (_recorder != nullptr)
+    {
+        _recorder->update(); // no-op if it has its own task
+    }
+#endif
+
+    int16_t rxLength = _connection->pollData(_rxBuffer, sizeof(_rxBuffer));
+    if (rxLength < 0)
+    {
+#if ELM_LOG_LEVEL > ELM_LOG_LEVEL_NONE
+        ELMLog::update(); // idle, print the waiting log messages
+#endif
+        return false; // no complete line yet
+    }
+
+    if (rxLength >= (int16_t)sizeof(_rxBuffer))
+    {
+        _request.clear(); // request longer than we can buffer
+        _request.type = ELMRequest::INVALID;
+    }
+    else
+    {
+        _request.parse(_rxBuffer, rxLength);
+    }
+    ELM_STATS_MARK(PARSE);
+
+    if (processRequest(_request)) // processRequest handles all non PID requests (AT commands, errors etc)
+    {
+        return false;
+    }
+    elmRequest = _request.command; // compatibility view, reserved in the constructor so no allocation here
+    ELM_STATS_MARK(DISPATCH);
+    return true;
 }
 
 void ELMulator::sendELMResponse()
 {
-    // Respond to any mode 01 request with a mock sensor value    
-    if (isMode01(elmRequest)) 
+    // Respond to any mode 01 request, with a replayed, simulated (or at least mock) value for each pid without a handler
+    if (_request.isMode(SERVICE_01) && _request.pidCount > 0)
     {
-        uint8_t pidCode = getPidCode(elmRequest);
-        writePidResponse(elmRequest, responseBytes[pidCode], getMockSensorValue());
+        uint32_t values[MAX_PIDS_PER_REQUEST];
+        for (uint8_t i = 0; i < _request.pidCount; i++)
+        {
+            if (!getPidValue(_request.pids[i], values[i]))
+            {
+                values[i] = getMockSensorValue();
+            }
+        }
+        _pidProcessor->writePidResponse(_request, values);
         return;
     }
     // Not a mode 01 PID request. Report it as not supported (ie, "NO DATA");
@@ -76,11 +168,26 @@ void ELMulator::sendELMResponse()
     }
 }
 
+bool ELMulator::getPidValue(uint8_t pid, uint32_t &value)
+{
+    return _pidProcessor->getPidValue(pid, value) ||
+           (_replay != nullptr && _replay->getValue(pid, millis(), value)) ||
+           _simulator.getRawValue(pid, value);
+}
+
+bool ELMulator::onFreezeFrameValue(uint8_t pid, uint32_t &value, void *context)
+{
+    return static_cast<ELMulator *>(context)->getPidValue(pid, value);
+}
+
 void ELMulator::begin()
 {
-    while (readELMRequest())
+    while (true)
     {
-        sendELMResponse();
+        if (!poll())
+        {
+            yield();
+        }
     }
 }
 
@@ -94,6 +201,79 @@ bool ELMulator::registerMode01Pid(uint32_t pid)
     return _pidProcessor->registerMode01Pid(pid);
 }
 
+bool ELMulator::registerMode01Pid(uint32_t pid, PidHandler handler)
+{
+    return _pidProcessor->registerMode01Pid(pid, handler);
+}
+
+bool ELMulator::registerMode01Pid(uint32_t pid, PidHandler handler, uint32_t refreshPeriodMs)
+{
+    if (_sampler == nullptr)
+    {
+        _sampler = new SensorSampler();
+        _pidProcessor->setSampler(_sampler);
+        _sampler->begin();
+    }
+    return _pidProcessor->registerMode01Pid(pid) &&
+           _sampler->addPid(_pidProcessor->getPidCodeFromHex(pid), handler, refreshPeriodMs);
+}
+
+bool ELMulator::registerMode01Pid(uint32_t pid, SensorHandler handler)
+{
+    return _pidProcessor->registerMode01Pid(pid, handler);
+}
+
+uint32_t ELMulator::encodePidValue(uint8_t pid, float value)
+{
+    const PidDescriptor *descriptor = PidDescriptor::find(pid);
+    return descriptor != nullptr ? descriptor->encode(value) : 0;
+}
+
+uint32_t ELMulator::getSampleAge(uint8_t pid)
+{
+    return _sampler != nullptr ? _sampler->getAge(pid) : UINT32_MAX;
+}
+
+bool ELMulator::isSampleStale(uint8_t pid)
+{
+    return _sampler == nullptr || _sampler->isStale(pid);
+}
+
+bool ELMulator::registerMode09Pid(uint8_t pid, uint8_t numberOfBytes, PidHandler handler)
+{
+    return _pidProcessor->registerModePid(SERVICE_09, pid, numberOfBytes, handler);
+}
+
+bool ELMulator::registerMode22Pid(uint16_t pid, uint8_t numberOfBytes, PidHandler handler)
+{
+    return _pidProcessor->registerModePid(SERVICE_22, pid, numberOfBytes, handler);
+}
+
+DtcStore &ELMulator::getDtcStore()
+{
+    return _pidProcessor->getDtcStore();
+}
+
+VehicleInfo &ELMulator::getVehicleInfo()
+{
+    return _pidProcessor->getVehicleInfo();
+}
+
+FreezeFrames &ELMulator::getFreezeFrames()
+{
+    return _pidProcessor->getFreezeFrames();
+}
+
+bool ELMulator::captureFreezeFrame(uint16_t dtc)
+{
+    return _pidProcessor->captureFreezeFrame(dtc);
+}
+
+EcuTable &ELMulator::getEcuTable()
+{
+    return _pidProcessor->getEcuTable();
+}
+
 bool ELMulator::registerMode01MILResponse(const String &response)
 {
     return _pidProcessor->registerMode01MILResponse(response);
@@ -114,58 +294,66 @@ void ELMulator::writePidResponse(const String &requestPid, uint8_t numberOfBytes
     _pidProcessor->writePidResponse(requestPid, numberOfBytes, value);
 }
 
+void ELMulator::writeMultiPidResponse(const uint32_t values[])
+{
+    _pidProcessor->writePidResponse(_request, values);
+}
+
+const ELMRequest &ELMulator::getRequest()
+{
+    return _request;
+}
+
 void ELMulator::writeResponse(const String &response)
 {
     _connection->writeTo(response.c_str());
     _connection->writeEnd();
 }
 
-bool ELMulator::processRequest(String &command)
+void ELMulator::writeResponse(const uint8_t *payload, uint16_t length)
 {
+    _connection->writeEndPayload(payload, length);
+}
 
-    // TODO: check for no 0X0D char in command, return ? and >
-    // TODO: receive only <cr>, repeat last command
-
-    // carriage return, means repeat last command
-    if (command == "\n")
+bool ELMulator::processRequest(ELMRequest &request)
+{
+    switch (request.type)
     {
-        command = _lastCommand;
-    }
+    // carriage return, means repeat last command
+    case ELMRequest::REPEAT:
+        if (_lastRequest.type == ELMRequest::EMPTY)
+        {
+            return true;
+        }
+        request = _lastRequest;
+        break;
 
     // empty command, do not send to user
-    if (command.length() == 0)
-    {
+    case ELMRequest::EMPTY:
         return true;
-    }
 
-    // Check for AT command
-    if (_atProcessor->process(command))
-    {
-        _lastCommand = command;
-        return true;
-    }
-
-    // Check for a valid hex string, return error if false
-    if (!isValidHex(command.c_str()))
-    {
+    // not hex or too long, return error
+    case ELMRequest::INVALID:
         _connection->writeEndUnknown();
-        DEBUG("Invalid HEX command: " + command);
+        ELM_LOG_DEBUG("Invalid HEX command: %s", request.command);
         return true;
+
+    default:
+        break;
     }
+    ELM_STATS_REQUEST(request);
 
-    // Check for a valid PID request
-    if (_pidProcessor->process(command))
+    // Check for AT command
+    if (request.type == ELMRequest::AT)
     {
-        _lastCommand = command;
+        _atProcessor->process(request.command);
+        _lastRequest = request;
         return true;
     }
 
-    return false;
-}
-
-bool ELMulator::isValidHex(const char *pid)
-{
-    return (pid[strspn(pid, "0123456789abcdefABCDEF")] == 0);
+    // Check for a valid PID request
+    _lastRequest = request;
+    return _pidProcessor->process(request);
 }
 
 bool ELMulator::isMode01(const String &command)
@@ -188,6 +376,21 @@ bool ELMulator::isMode01MIL(const String &command)
     return _pidProcessor->isMode01MIL(command);
 }
 
+VehicleSimulator &ELMulator::getSimulator()
+{
+    return _simulator;
+}
+
+void ELMulator::setTraceReplay(TraceReplay *replay)
+{
+    _replay = replay;
+    if (replay != nullptr)
+    {
+        _pidProcessor->registerPids(SERVICE_01, replay->getSupportedPids());
+        replay->start(millis());
+    }
+}
+
 /**
  * Fake some data
  * start counter = 0
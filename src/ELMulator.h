@@ -4,14 +4,19 @@
 #include <Arduino.h>
 #include "definitions.h"
 
-#if USE_WIFI
-#include "OBDWiFiComm.h"
-#else
+#include "OBDComm.h"
 #include "OBDSerialComm.h"
-#endif
+#include "OBDWiFiComm.h"
+#include "OBDStreamComm.h"
 
 #include "ATCommands.h"
 #include "PidProcessor.h"
+#include "ELMRequest.h"
+#include "SensorSampler.h"
+#include "VehicleSimulator.h"
+#include "TraceReplay.h"
+#include "ELMLog.h"
+#include "ELMStats.h"
 #include "definitions.h"
 
 class ELMulator
@@ -29,7 +34,23 @@ public:
      */
     ELMulator(uint32_t baudRate, uint8_t rxPin, uint8_t txPin);
 
+#if HAS_ESP32_TRANSPORTS
+    // Uses the ESP32 builtin Bluetooth, or WiFi if USE_WIFI is set
     ELMulator();
+#endif
+
+    /**
+     * Serve OBD clients over the given transport, ex:
+     *
+     * OBDStreamComm uart(Serial2);
+     * ELMulator myELMulator(&uart);
+     *
+     * Several instances, each with its own transport, can run in the same
+     * sketch (ex: Bluetooth and UART at once).
+     *
+     * @param transport - connection to the client, must outlive the ELMulator
+     */
+    ELMulator(OBDTransport *transport);
 
     ~ELMulator();
 
@@ -51,8 +72,52 @@ public:
      */
     bool readELMRequest();
     void sendELMResponse();
+
+    // Runs forever answering requests, see poll() to keep control of loop()
     void begin();
 
+    /**
+     * Each response is sent with a single write once complete; with
+     * OBDComm::FLUSH_EACH_RESPONSE (default) it also waits until it is sent,
+     * OBDComm::FLUSH_NEVER leaves that to the Bluetooth/TCP stack
+     */
+    void setFlushPolicy(OBDComm::FLUSH_POLICY policy);
+
+    /**
+     * Log every request and response with timestamps and latency, see
+     * SessionRecorder, ex:
+     *
+     * File file = LittleFS.open("/session.elmr", FILE_WRITE);
+     * SessionRecorder recorder;
+     * recorder.begin(file, 10000); // last 10000 records, 640 kB
+     * myELMulator.setSessionRecorder(&recorder);
+     *
+     * @param recorder - must outlive the ELMulator, nullptr to stop recording
+     */
+    void setSessionRecorder(SessionRecorder *recorder);
+
+    typedef void (*PidRequestCallback)(const String &request);
+
+    /**
+     * Non blocking alternative to readELMRequest()/begin(), call it from loop()
+     * or a FreeRTOS task as often as possible.
+     *
+     * Reads whatever bytes are available (never waits for more) and once a
+     * request is complete handles it: AT commands, PID support queries and
+     * errors are answered directly, PID requests are passed to the callback
+     * set with onPidRequest(), or answered with mock values if there is none.
+     *
+     * @return true if a PID request was dispatched during this call
+     */
+    bool poll();
+
+    /**
+     * Set the function poll() calls for each PID request, it gets the
+     * request (ex: "010C") and must write the response, like handlePIDRequest
+     * in the examples.
+     */
+    void onPidRequest(PidRequestCallback callback);
+
     /**
      * Registry the PID's (sensors) your arduino will support.
      * Currently ELMulator lib only supports MODE 01 PID's
@@ -71,8 +136,134 @@ public:
      */
     bool registerMode01Pid(uint32_t pidHexId);
 
+    typedef PidProcessor::PidHandler PidHandler;
+
+    /**
+     * Registry a MODE 01 PID answered by the library: handler is called with
+     * the pid each time it is requested and returns the sensor value, the
+     * response length comes from responseBytes. Requests for these PIDs are
+     * never passed to readELMRequest()/onPidRequest().
+     *
+     * Example: registerMode01Pid(ENGINE_RPM, readRpm)
+     *
+     * @return false if the PID is out of range
+     */
+    bool registerMode01Pid(uint32_t pidHexId, PidHandler handler);
+
+    /**
+     * Same as registerMode01Pid(pid, handler) for slow sensors: handler is
+     * called every refreshPeriodMs out of the request path (in a background
+     * task on ESP32, from poll()/readELMRequest() elsewhere) and requests
+     * are answered with the latest value. Until the first sample the PID is
+     * handled like a PID registered without a handler.
+     *
+     * On ESP32 handler runs in another task, it must not share unprotected
+     * state with loop().
+     *
+     * Example: registerMode01Pid(VEHICLE_SPEED, readGpsSpeed, 200)
+     *
+     * @return false if the PID is out of range or MAX_SAMPLED_PIDS are sampled
+     */
+    bool registerMode01Pid(uint32_t pidHexId, PidHandler handler, uint32_t refreshPeriodMs);
+
+    typedef PidProcessor::SensorHandler SensorHandler;
+
+    /**
+     * Same as registerMode01Pid(pid, handler) with a handler returning the
+     * value in engineering units (ex: rpm, °C, %), the library encodes it
+     * with the SAE J1979 formula of the PID, clamped to its range.
+     *
+     * Example: float readCoolantTemp(uint16_t pid) { return 90.5; }
+     *          registerMode01Pid(ENGINE_COOLANT_TEMP, readCoolantTemp)
+     *
+     * @return false if the PID has no formula (see PidDescriptor::TABLE)
+     */
+    bool registerMode01Pid(uint32_t pidHexId, SensorHandler handler);
+
+    /**
+     * Encodes a value in engineering units for writePidResponse
+     * (ex: encodePidValue(ENGINE_RPM, 3000) == 12000)
+     *
+     * @return 0 if the PID has no formula
+     */
+    uint32_t encodePidValue(uint8_t pid, float value);
+
+    // ms since the last sample of a sampled PID, UINT32_MAX if there is none
+    uint32_t getSampleAge(uint8_t pid);
+
+    // true if the last sample of a PID is older than twice its refresh period
+    bool isSampleStale(uint8_t pid);
+
+    /**
+     * Same as registerMode01Pid(pid, handler) for MODE 09 (vehicle information),
+     * numberOfBytes is the length of the value returned by handler
+     *
+     * @return false if there is no room for more MODE 09/22 handlers
+     */
+    bool registerMode09Pid(uint8_t pid, uint8_t numberOfBytes, PidHandler handler);
+
+    /**
+     * Same as registerMode09Pid for MODE 22 (manufacturer specific) 8 or 16 bit PIDs
+     *
+     * Example, ethanol percent: registerMode22Pid(0x0052, 1, readEthanol)
+     */
+    bool registerMode22Pid(uint16_t pid, uint8_t numberOfBytes, PidHandler handler);
+
+    /**
+     * Registry a table of PIDs at once for a service with supported PID
+     * queries (01, 02, 05, 06, 09), the table can be built at compile time:
+     *
+     * constexpr SupportedPids MY_PIDS = makeSupportedPids(ENGINE_RPM, VEHICLE_SPEED);
+     * registerPids(SERVICE_01, MY_PIDS);
+     *
+     * @return false if the service has no supported PID table
+     */
+    bool registerPids(uint8_t mode, const SupportedPids &pids);
+
+    /**
+     * Trouble codes of the emulated ECU, answered without the sketch once used:
+     * modes 03 (stored), 07 (pending), 0A (permanent), 04 (clear) and pid 0101
+     * (MIL and number of codes, unless it has a handler)
+     *
+     * getDtcStore().add("P0301");
+     * getDtcStore().add("P0420", DtcStore::PENDING);
+     */
+    DtcStore &getDtcStore();
+
+    /**
+     * Vehicle information of the emulated ECU, answered without the sketch once
+     * set: VIN (0902), calibration IDs (0904), CVNs (0906) and ECU name (090A)
+     *
+     * getVehicleInfo().setVin("1HGCM82633A004352");
+     * getVehicleInfo().addCalibrationId("JMB*36761500");
+     */
+    VehicleInfo &getVehicleInfo();
+
+    /**
+     * Mode 02 freeze frames, answered without the sketch once used: a frame
+     * with the values of all registered mode 01 pids is captured each time a
+     * new code is stored in getDtcStore(), mode 04 clears them
+     */
+    FreezeFrames &getFreezeFrames();
+
+    // Captures a freeze frame now, caused by dtc (0 if none), false if the frames are full
+    bool captureFreezeFrame(uint16_t dtc = 0);
+
+    /**
+     * Other ECUs answering next to the engine one, each with its own pids:
+     *
+     * int8_t transmission = getEcuTable().addEcu(0x7E1); // answers from 7E9
+     * getEcuTable().registerPid(transmission, SERVICE_01, 0xA4, 2, myGearHandler);
+     *
+     * Functional requests (ATSH 7DF, the default) are answered by every ECU
+     * with the pid, physical ones (ex: ATSH 7E1) only by the addressed ECU.
+     */
+    EcuTable &getEcuTable();
+
+    // Legacy hex string versions of getDtcStore().setMil/setMonitorStatus (ex: "4101830000")
     bool registerMode01MILResponse(const String &response);
 
+    // Legacy hex string version of getDtcStore().add (ex: "43010341\r\n43010123", P0341 and P0123)
     bool registerMode03Response(const String &response);
 
     uint8_t getPidCodeOnly(uint16_t hexCommand);
@@ -98,11 +289,32 @@ public:
      */
     void writePidResponse(const String &requestPid, uint8_t numberOfBytes, uint32_t value);
 
+    /**
+     * Respond to the current mode 01 request, which may ask for
+     * several PIDs at once (ex: 010C0D11), in a single response
+     *
+     * @param values - sensor value for each PID, in request order (see getRequest().pids)
+     */
+    void writeMultiPidResponse(const uint32_t values[]);
+
+    // The request returned by readELMRequest, already parsed
+    const ELMRequest &getRequest();
+
     // Write the response back to the requestor without PID formatting, etc
     // Just pass the response string on. Useful for testing with a specific response
     // that has been pre-configured.
     void writeResponse(const String &response);
 
+    /**
+     * Respond with raw payload bytes, sent as CAN frames the way the client
+     * expects them (ATH, ATS, ATCAF): responses over 7 bytes (ex: VIN, DTC
+     * lists) become ISO-TP multi frame responses
+     *
+     * const uint8_t VIN[] = {0x49, 0x02, 0x01, '1', 'G', '1', ...};
+     * writeResponse(VIN, sizeof(VIN));
+     */
+    void writeResponse(const uint8_t *payload, uint16_t length);
+
     bool isMode01(const String &command);
     bool isMode03(const String &command);
     bool isMode01MIL(const String &command);
@@ -112,27 +324,68 @@ public:
     void registerAllMode01Pids();
     uint32_t getMockSensorValue();
 
+    /**
+     * Drive cycle simulation answering registered mode 01 PIDs that have no
+     * handler (see sendELMResponse), it advances on each poll()/readELMRequest().
+     * Call getSimulator().reset(seed) to replay a different, reproducible drive.
+     */
+    VehicleSimulator &getSimulator();
+
+    /**
+     * Answer the mode 01 PIDs of a recorded drive with its values instead of
+     * the simulation (PIDs with a handler keep it), the PIDs of the trace are
+     * registered and it starts playing now:
+     *
+     * File file = LittleFS.open("/drive.elmt");
+     * FileTraceReader reader(file);
+     * TraceReplay replay;
+     * replay.begin(&reader);
+     * myELMulator.setTraceReplay(&replay);
+     *
+     * @param replay - must outlive the ELMulator, nullptr to stop replaying
+     */
+    void setTraceReplay(TraceReplay *replay);
+
+    // Compatibility view of the last PID request (ex: "010C"),
+    // use it only for the String based API above
     String elmRequest;
 
 private:
-#if USE_WIFI
-    OBDWiFiComm *_connection;
-#else
-    OBDSerialComm *_connection;
-#endif
+    OBDComm *_connection;
     ATCommands *_atProcessor;
 
     PidProcessor *_pidProcessor;
 
-    String _lastCommand;
+    // created by the first registerMode01Pid with a refresh period
+    SensorSampler *_sampler;
+
+    VehicleSimulator _simulator;
+
+    TraceReplay *_replay;
+
+    SessionRecorder *_recorder;
+
+    char _rxBuffer[MAX_REQUEST_SIZE + 1];
+
+    ELMRequest _request;
+
+    ELMRequest _lastRequest;
 
     bool isCycleUp = true;
 
     uint32_t cycle = 0;
 
-    bool processRequest(String &command);
+    PidRequestCallback _pidRequestCallback;
+
+    bool receiveRequest();
+
+    bool processRequest(ELMRequest &request);
+
+    // Value of a mode 01 pid from its handler, the trace replay or the simulator, false if none has it
+    bool getPidValue(uint8_t pid, uint32_t &value);
 
-    bool isValidHex(const char *pid);
+    // the freeze frames take the values live requests get
+    static bool onFreezeFrameValue(uint8_t pid, uint32_t &value, void *context);
 };
 
 #endif
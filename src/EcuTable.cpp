@@ -0,0 +1,139 @@
+#include "EcuTable.h"
+
+EcuTable::EcuTable()
+{
+    nEcus = 0;
+}
+
+int8_t EcuTable::addEcu(uint16_t requestId)
+{
+    if (nEcus == MAX_ECUS || find(requestId) >= 0 || requestId == ENGINE_REQUEST_ID ||
+        requestId == FUNCTIONAL_REQUEST_ID)
+    {
+        return -1;
+    }
+    Ecu &ecu = ecus[nEcus];
+    ecu.requestId = requestId;
+    ecu.mode01Pids.clear();
+    ecu.mode09Pids.clear();
+    ecu.nHandlers = 0;
+    return nEcus++;
+}
+
+bool EcuTable::registerPid(uint8_t ecu, uint8_t mode, uint16_t pid, uint8_t numberOfBytes, PidHandler handler)
+{
+    if (ecu >= nEcus || (mode != SERVICE_01 && mode != SERVICE_09 && mode != SERVICE_22) ||
+        ecus[ecu].nHandlers == MAX_ECU_PID_HANDLERS || numberOfBytes == 0 || numberOfBytes > 4)
+    {
+        return false;
+    }
+    Ecu &e = ecus[ecu];
+    e.handlers[e.nHandlers++] = {mode, pid, numberOfBytes, handler};
+    if (mode == SERVICE_01)
+    {
+        e.mode01Pids.add(pid);
+    }
+    else if (mode == SERVICE_09)
+    {
+        e.mode09Pids.add(pid);
+    }
+    return true;
+}
+
+uint8_t EcuTable::getCount()
+{
+    return nEcus;
+}
+
+int8_t EcuTable::find(uint16_t requestId)
+{
+    for (uint8_t i = 0; i < nEcus; i++)
+    {
+        if (ecus[i].requestId == requestId)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+uint16_t EcuTable::getResponseId(uint8_t ecu)
+{
+    return ecus[ecu].requestId + RESPONSE_ID_OFFSET;
+}
+
+uint8_t EcuTable::getResponse(uint8_t ecu, const ELMRequest &request, uint8_t *payload)
+{
+    if (ecu >= nEcus || request.pidBytes == 0)
+    {
+        return 0;
+    }
+    const Ecu &e = ecus[ecu];
+    payload[0] = request.mode + 0x40;
+    uint8_t length = 1;
+
+    // mode 01 requests can have several pids, only the ones of this ECU are answered
+    if (request.isMode(SERVICE_01))
+    {
+        for (uint8_t i = 0; i < request.pidCount; i++)
+        {
+            length += writePid(e, request.mode, request.pids[i], 1, payload + length);
+        }
+    }
+    else
+    {
+        length += writePid(e, request.mode, request.pid, request.pidBytes, payload + length);
+    }
+    return length > 1 ? length : 0;
+}
+
+const EcuTable::Handler *EcuTable::findHandler(const Ecu &ecu, uint8_t mode, uint16_t pid)
+{
+    for (uint8_t i = 0; i < ecu.nHandlers; i++)
+    {
+        if (ecu.handlers[i].mode == mode && ecu.handlers[i].pid == pid)
+        {
+            return &ecu.handlers[i];
+        }
+    }
+    return nullptr;
+}
+
+uint8_t EcuTable::writePid(const Ecu &ecu, uint8_t mode, uint16_t pid, uint8_t pidBytes, uint8_t *payload)
+{
+    uint32_t value;
+    uint8_t numberOfBytes;
+    const SupportedPids *supported = mode == SERVICE_01 ? &ecu.mode01Pids
+                                   : mode == SERVICE_09 ? &ecu.mode09Pids
+                                   : nullptr;
+    const Handler *handler;
+    if (supported != nullptr && SupportedPids::isQuery(pid))
+    {
+        value = supported->getBitmap(pid);
+        numberOfBytes = 4;
+        if (value == 0)
+        {
+            return 0;
+        }
+    }
+    else if ((handler = findHandler(ecu, mode, pid)) != nullptr)
+    {
+        value = handler->handler(pid);
+        numberOfBytes = handler->numberOfBytes;
+    }
+    else
+    {
+        return 0;
+    }
+
+    uint8_t length = 0;
+    for (uint8_t i = pidBytes; i > 0; i--)
+    {
+        payload[length++] = pid >> (8 * (i - 1));
+    }
+    for (uint8_t i = numberOfBytes; i > 0; i--)
+    {
+        payload[length++] = value >> (8 * (i - 1));
+    }
+    return length;
+}
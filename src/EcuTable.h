@@ -0,0 +1,91 @@
+#ifndef ELMulator_EcuTable_h
+#define ELMulator_EcuTable_h
+
+#include <Arduino.h>
+#include "definitions.h"
+#include "ELMRequest.h"
+#include "SupportedPids.h"
+
+/**
+ * ECUs answering next to the engine one (PidProcessor, 7E0/7E8), ex: the
+ * transmission at 7E1/7E9 and the ABS at 7E2/7EA, each with its own pids
+ * and handlers.
+ *
+ * A functional request (ATSH 7DF, the default) fans out: every ECU that has
+ * the pid writes its own response, with its own header, then the engine ECU
+ * answers and closes the ELM327 response. A physical request (ex: ATSH 7E1)
+ * is answered by that ECU alone. ATCRA hides the responses from other ids.
+ *
+ * Everything is in fixed arrays of MAX_ECUS ECUs and MAX_ECU_PID_HANDLERS
+ * handlers each, a request only builds payloads on the stack.
+ */
+class EcuTable
+{
+public:
+    // Same as PidProcessor::PidHandler
+    typedef uint32_t (*PidHandler)(uint16_t pid);
+
+    EcuTable();
+
+    /**
+     * Adds an ECU answering physical requests to requestId (ex: 0x7E1),
+     * from requestId + 8 (ex: 0x7E9)
+     *
+     * @return the ECU number for registerPid, -1 if there are MAX_ECUS already
+     *         or requestId is taken
+     */
+    int8_t addEcu(uint16_t requestId);
+
+    /**
+     * Registers a mode 01, 09 or 22 pid of ecu, answered with the
+     * numberOfBytes lower bytes of handler
+     *
+     * @return false if ecu does not exist, the mode is not supported or the ECU has
+     *         MAX_ECU_PID_HANDLERS pids already
+     */
+    bool registerPid(uint8_t ecu, uint8_t mode, uint16_t pid, uint8_t numberOfBytes, PidHandler handler);
+
+    uint8_t getCount();
+
+    // ECU answering physical requests to requestId, -1 if none
+    int8_t find(uint16_t requestId);
+
+    uint16_t getResponseId(uint8_t ecu);
+
+    /**
+     * Response payload of ecu to request (ex: 41 0C 1A F8), with the pids it
+     * has (or the support queries 00, 20, ... of modes 01 and 09)
+     *
+     * @param payload - must hold ECU_RESPONSE_SIZE bytes
+     * @return payload length, 0 if ecu has none of the requested pids
+     */
+    uint8_t getResponse(uint8_t ecu, const ELMRequest &request, uint8_t *payload);
+
+private:
+    struct Handler
+    {
+        uint8_t mode;
+        uint16_t pid;
+        uint8_t numberOfBytes;
+        PidHandler handler;
+    };
+
+    struct Ecu
+    {
+        uint16_t requestId;
+        SupportedPids mode01Pids;
+        SupportedPids mode09Pids;
+        Handler handlers[MAX_ECU_PID_HANDLERS];
+        uint8_t nHandlers;
+    };
+
+    Ecu ecus[MAX_ECUS];
+    uint8_t nEcus;
+
+    static const Handler *findHandler(const Ecu &ecu, uint8_t mode, uint16_t pid);
+
+    // Appends the pid and its value bytes (or support bitmap) to payload, 0 if ecu does not have it
+    static uint8_t writePid(const Ecu &ecu, uint8_t mode, uint16_t pid, uint8_t pidBytes, uint8_t *payload);
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "FrameFormatter.h"
+
+FrameFormatter::FrameFormatter(uint8_t flags, uint16_t header)
+{
+    this->flags = flags;
+    this->header = header;
+}
+
+// a byte count line before the frames when they are shown as "0:", "1:", ...
+uint16_t FrameFormatter::getLineCount(const IsoTpFrames &frames) const
+{
+    return frames.getCount() + (isIndexed(frames) ? 1 : 0);
+}
+
+uint8_t FrameFormatter::formatLine(const IsoTpFrames &frames, uint16_t index, char *line) const
+{
+    bool autoFormat = flags & AUTO_FORMAT;
+    bool headers = flags & HEADERS;
+    bool indexed = isIndexed(frames);
+    uint8_t pos = 0;
+    if (indexed)
+    {
+        if (index == 0)
+        {
+            uint16_t length = frames.getLength();
+            line[pos++] = HexCodec::encodeDigit(length >> 8);
+            HexCodec::encodeByte(length, line + pos);
+            pos += 2;
+            line[pos] = '\0';
+            return pos;
+        }
+        index--;
+    }
+
+    uint8_t frame[CAN_FRAME_SIZE];
+    uint8_t used = frames.getFrame(index, frame);
+    uint8_t first = 0;
+    uint8_t end = CAN_FRAME_SIZE;
+    if (autoFormat && !frames.isMultiFrame())
+    {
+        first = headers ? 0 : 1;
+        end = used;
+    }
+    else if (indexed)
+    {
+        first = frames.getPciSize(index);
+    }
+
+    if (headers)
+    {
+        if (flags & EXTENDED_IDS)
+        {
+            uint32_t id = getExtendedId(header);
+            for (int8_t shift = 24; shift >= 0; shift -= 8)
+            {
+                pos = writeByte(id >> shift, line, pos);
+            }
+        }
+        else
+        {
+            line[pos++] = HexCodec::encodeDigit(header >> 8);
+            HexCodec::encodeByte(header, line + pos);
+            pos += 2;
+        }
+        if (flags & DLC)
+        {
+            if (flags & SPACES)
+            {
+                line[pos++] = 0x20;
+            }
+            line[pos++] = HexCodec::encodeDigit(CAN_FRAME_SIZE);
+        }
+    }
+    if (indexed)
+    {
+        line[pos++] = HexCodec::encodeDigit(index);
+        line[pos++] = ':';
+    }
+    for (uint8_t b = first; b < end; b++)
+    {
+        pos = writeByte(frame[b], line, pos);
+    }
+    line[pos] = '\0';
+    return pos;
+}
+
+uint32_t FrameFormatter::getExtendedId(uint16_t id)
+{
+    if (id == FUNCTIONAL_REQUEST_ID)
+    {
+        return FUNCTIONAL_EXTENDED_ID;
+    }
+    uint8_t address = ECU_ADDRESS + (id & 0x07);
+    return (id & RESPONSE_ID_OFFSET) ? 0x18DA0000 | (TESTER_ADDRESS << 8) | address
+                                     : 0x18DA0000 | ((uint32_t)address << 8) | TESTER_ADDRESS;
+}
+
+uint16_t FrameFormatter::getStandardId(uint32_t id)
+{
+    // 18 DB 33 F1 functional, 18 DA target source physical
+    if (((id >> 16) & 0xFF) == 0xDB)
+    {
+        return FUNCTIONAL_REQUEST_ID;
+    }
+    uint8_t target = (id >> 8) & 0xFF;
+    uint8_t source = id & 0xFF;
+    return source == TESTER_ADDRESS ? ENGINE_REQUEST_ID + (target & 0x07)
+                                    : ENGINE_REQUEST_ID + RESPONSE_ID_OFFSET + (source & 0x07);
+}
+
+uint8_t FrameFormatter::writeByte(uint8_t byte, char *line, uint8_t pos) const
+{
+    if ((flags & SPACES) && pos > 0)
+    {
+        line[pos++] = 0x20;
+    }
+    HexCodec::encodeByte(byte, line + pos);
+    return pos + 2;
+}
+
+bool FrameFormatter::isIndexed(const IsoTpFrames &frames) const
+{
+    return (flags & AUTO_FORMAT) && !(flags & HEADERS) && frames.isMultiFrame();
+}
@@ -0,0 +1,69 @@
+#ifndef ELMulator_FrameFormatter_h
+#define ELMulator_FrameFormatter_h
+
+#include <stdint.h>
+#include "definitions.h"
+#include "IsoTpFrames.h"
+#include "HexCodec.h"
+
+/**
+ * Renders the CAN frames of a response (see IsoTpFrames) as an ELM327
+ * shows them, one line per frame:
+ *
+ *   AUTO_FORMAT            data only; multi frame: byte count line, then
+ *                          "0:" + 6 bytes, "1:" + 7 bytes, ... (last one padded)
+ *   AUTO_FORMAT HEADERS    header, PCI and data of each frame (single frame
+ *                          without padding)
+ *   HEADERS                header and all 8 bytes of each frame
+ *
+ * The header is 3 hex digits (ex: 7E8), or 4 bytes with EXTENDED_IDS
+ * (ex: 18 DA F1 10), followed by the DLC if DLC is set (ATD1). SPACES puts
+ * a space between bytes (ATS1).
+ *
+ * Lines are written straight into the caller's buffer (ex: the transmit
+ * buffer), bytes are encoded by HexCodec.
+ */
+class FrameFormatter
+{
+public:
+    enum FLAG
+    {
+        HEADERS = 0x01,     // ATH1
+        SPACES = 0x02,      // ATS1
+        AUTO_FORMAT = 0x04, // ATCAF1
+        DLC = 0x08,         // ATD1, only shown with the header
+        EXTENDED_IDS = 0x10 // 29 bit CAN ids (ATSP7, ATSP9)
+    };
+
+    // header is an 11 bit CAN id, shown as its 29 bit equivalent with EXTENDED_IDS
+    FrameFormatter(uint8_t flags, uint16_t header);
+
+    uint16_t getLineCount(const IsoTpFrames &frames) const;
+
+    /**
+     * Writes line index to line, which must hold FRAME_LINE_SIZE chars
+     *
+     * @return line length, without the null terminator
+     */
+    uint8_t formatLine(const IsoTpFrames &frames, uint16_t index, char *line) const;
+
+    /**
+     * 29 bit id of an 11 bit one (ISO 15765-4): 7DF -> 18DB33F1,
+     * 7E0 + n -> 18DA(10 + n)F1, 7E8 + n -> 18DAF1(10 + n)
+     */
+    static uint32_t getExtendedId(uint16_t id);
+
+    // 11 bit id of a 29 bit one, the reverse of getExtendedId
+    static uint16_t getStandardId(uint32_t id);
+
+private:
+    uint8_t flags;
+    uint16_t header;
+
+    // Writes byte as 2 hex digits at line + pos, after a space if SPACES and pos > 0
+    uint8_t writeByte(uint8_t byte, char *line, uint8_t pos) const;
+
+    bool isIndexed(const IsoTpFrames &frames) const;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "FreezeFrames.h"
+
+FreezeFrames::FreezeFrames()
+{
+    clear();
+}
+
+void FreezeFrames::clear()
+{
+    count = 0;
+    nPids = 0;
+    for (uint16_t pid = 0; pid <= maxPid; pid++)
+    {
+        offsets[pid] = NOT_STORED;
+    }
+    recordSize = 2;
+    supported.clear();
+    supported.add(FREEZE_DTC);
+}
+
+bool FreezeFrames::addPid(uint8_t pid, uint8_t numberOfBytes)
+{
+    if (count > 0 || offsets[pid] != NOT_STORED || recordSize + numberOfBytes > FREEZE_FRAME_ARENA_SIZE)
+    {
+        return false;
+    }
+    pids[nPids++] = pid;
+    offsets[pid] = recordSize;
+    sizes[pid] = numberOfBytes;
+    recordSize += numberOfBytes;
+    supported.add(pid);
+    return true;
+}
+
+uint8_t FreezeFrames::getPidCount()
+{
+    return nPids;
+}
+
+uint8_t FreezeFrames::getPid(uint8_t index)
+{
+    return pids[index];
+}
+
+uint8_t FreezeFrames::getNumberOfBytes(uint8_t pid)
+{
+    return sizes[pid];
+}
+
+uint8_t *FreezeFrames::startFrame(uint16_t dtc)
+{
+    if (count == MAX_FREEZE_FRAMES || (count + 1) * recordSize > FREEZE_FRAME_ARENA_SIZE)
+    {
+        return nullptr;
+    }
+    uint8_t *record = arena + count * recordSize;
+    record[0] = dtc >> 8;
+    record[1] = dtc & 0xFF;
+    return record + 2;
+}
+
+void FreezeFrames::endFrame()
+{
+    __sync_synchronize();
+    count = count + 1;
+}
+
+uint8_t FreezeFrames::getCount()
+{
+    return count;
+}
+
+uint8_t FreezeFrames::getResponse(uint8_t pid, uint8_t frame, uint8_t *payload)
+{
+    if (frame >= count)
+    {
+        return 0;
+    }
+    const uint8_t *record = arena + frame * recordSize;
+    payload[0] = SERVICE_02 + 0x40;
+    payload[1] = pid;
+    payload[2] = frame;
+    if (SupportedPids::isQuery(pid))
+    {
+        uint32_t bitmap = supported.getBitmap(pid);
+        for (uint8_t i = 0; i < 4; i++)
+        {
+            payload[3 + i] = bitmap >> (24 - 8 * i);
+        }
+        return 7;
+    }
+    if (pid == FREEZE_DTC)
+    {
+        memcpy(payload + 3, record, 2);
+        return 5;
+    }
+    if (offsets[pid] == NOT_STORED)
+    {
+        return 0;
+    }
+    memcpy(payload + 3, record + offsets[pid], sizes[pid]);
+    return 3 + sizes[pid];
+}
@@ -0,0 +1,87 @@
+#ifndef ELMulator_FreezeFrames_h
+#define ELMulator_FreezeFrames_h
+
+#include <Arduino.h>
+#include "definitions.h"
+#include "SupportedPids.h"
+
+/**
+ * Mode 02 freeze frames: snapshots of the mode 01 pid values taken when a
+ * trouble code is stored (or on demand).
+ *
+ * All frames share one layout, the pids and the offset of their value in a
+ * record, fixed by the first capture after a clear. A record is the code
+ * that caused the frame (2 bytes) followed by the values, encoded as sent on
+ * the bus, so a capture only copies bytes and a request (ex: 020C00) copies
+ * the bytes at the layout offset of the pid in the record of the frame:
+ *
+ *   arena  | 03 01 | 1A F8 | 5A | ... | 04 20 | 1B 00 | 5C | ... |
+ *            dtc     0C      05         dtc     0C      05
+ *
+ * Records live in a fixed arena of FREEZE_FRAME_ARENA_SIZE bytes, which
+ * holds up to MAX_FREEZE_FRAMES frames (less if the layout is large); once
+ * full, new captures are dropped so the first frames are kept until a clear.
+ * A record is written before the frame count is bumped, so captures can run
+ * in another task than the one answering requests.
+ */
+class FreezeFrames
+{
+public:
+    FreezeFrames();
+
+    // Drops all frames and the layout (mode 04)
+    void clear();
+
+    /**
+     * Adds a pid to the layout, only while there is no frame
+     *
+     * @return false if there are frames already or a record would not fit the arena
+     */
+    bool addPid(uint8_t pid, uint8_t numberOfBytes);
+
+    uint8_t getPidCount();
+
+    // index-th pid of the layout
+    uint8_t getPid(uint8_t index);
+
+    // Size of the value of a pid in the layout
+    uint8_t getNumberOfBytes(uint8_t pid);
+
+    /**
+     * Starts a frame for dtc, its pid values must then be written in layout
+     * order (big endian, numberOfBytes each) to the returned bytes, and the
+     * frame published with endFrame()
+     *
+     * @return nullptr if there is no room left
+     */
+    uint8_t *startFrame(uint16_t dtc);
+
+    void endFrame();
+
+    uint8_t getCount();
+
+    /**
+     * Response payload of a mode 02 request (ex: 42 0C 00 1A F8), pid 02 is
+     * the code that caused the frame and 00, 20, ... the pids in the layout
+     *
+     * @param payload - must hold 3 + 4 bytes
+     * @return payload length, 0 if frame or pid is not stored
+     */
+    uint8_t getResponse(uint8_t pid, uint8_t frame, uint8_t *payload);
+
+private:
+    static const uint16_t NOT_STORED = 0xFFFF;
+
+    uint8_t arena[FREEZE_FRAME_ARENA_SIZE];
+    volatile uint8_t count;
+
+    // layout
+    uint8_t pids[maxPid];
+    uint8_t nPids;
+    uint16_t offsets[maxPid + 1]; // of each pid value in a record, NOT_STORED if not in the layout
+    uint8_t sizes[maxPid + 1];
+    uint16_t recordSize;
+    SupportedPids supported;
+};
+
+#endif
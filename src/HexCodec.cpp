@@ -0,0 +1,125 @@
+#include "HexCodec.h"
+
+// value of each char as a hex digit, INVALID if it is not one
+const uint8_t HexCodec::DECODE_TABLE[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+// both digits of each byte, byte b at 2 * b
+const char HexCodec::PAIR_TABLE[513] =
+    "000102030405060708090A0B0C0D0E0F"
+    "101112131415161718191A1B1C1D1E1F"
+    "202122232425262728292A2B2C2D2E2F"
+    "303132333435363738393A3B3C3D3E3F"
+    "404142434445464748494A4B4C4D4E4F"
+    "505152535455565758595A5B5C5D5E5F"
+    "606162636465666768696A6B6C6D6E6F"
+    "707172737475767778797A7B7C7D7E7F"
+    "808182838485868788898A8B8C8D8E8F"
+    "909192939495969798999A9B9C9D9E9F"
+    "A0A1A2A3A4A5A6A7A8A9AAABACADAEAF"
+    "B0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+    "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECF"
+    "D0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+    "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEF"
+    "F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+static const char DIGITS[] = "0123456789ABCDEF";
+
+/**
+ * Per byte high bit set where m < byte < n, for m <= 127, n <= 128
+ * (bytes with the high bit set are never in range)
+ */
+static inline uint32_t bytesBetween(uint32_t x, uint8_t m, uint8_t n)
+{
+    const uint32_t ONES = 0x01010101;
+    const uint32_t LOW7 = ONES * 0x7F;
+    return (ONES * (127 + n) - (x & LOW7)) & ~x & ((x & LOW7) + ONES * (127 - m)) & (ONES * 0x80);
+}
+
+// 4 chars at once, each must be 0-9, A-F or a-f
+static inline bool isHexWord(uint32_t x)
+{
+    uint32_t digits = bytesBetween(x, '0' - 1, '9' + 1);
+    uint32_t letters = bytesBetween(x | 0x20202020, 'a' - 1, 'f' + 1); // upper case to lower case
+    return (digits | letters) == 0x80808080;
+}
+
+bool HexCodec::isHex(const char *text, uint16_t length)
+{
+    uint16_t i = 0;
+    for (; i + 4 <= length; i += 4)
+    {
+        uint32_t x;
+        memcpy(&x, text + i, 4);
+        if (!isHexWord(x))
+        {
+            return false;
+        }
+    }
+    for (; i < length; i++)
+    {
+        if (DECODE_TABLE[(uint8_t)text[i]] == INVALID)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint16_t HexCodec::decode(const char *hex, uint16_t length, uint8_t *bytes)
+{
+    uint16_t nBytes = length / 2;
+    uint16_t i = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // 4 digits, 2 bytes at once: a digit is its low nibble, + 9 for letters (bit 6 set)
+    for (; i + 2 <= nBytes; i += 2)
+    {
+        uint32_t x;
+        memcpy(&x, hex + 2 * i, 4);
+        uint32_t values = (x & 0x0F0F0F0F) + 9 * ((x >> 6) & 0x01010101);
+        uint32_t pairs = ((values << 4) | (values >> 8)) & 0x00FF00FF;
+        bytes[i] = pairs;
+        bytes[i + 1] = pairs >> 16;
+    }
+#endif
+    for (; i < nBytes; i++)
+    {
+        bytes[i] = decodeByte(hex + 2 * i);
+    }
+    return nBytes;
+}
+
+char HexCodec::encodeDigit(uint8_t value)
+{
+    return DIGITS[value & 0x0F];
+}
+
+uint16_t HexCodec::encode(const uint8_t *bytes, uint16_t n, char *out, bool spaces)
+{
+    char *start = out;
+    for (uint16_t i = 0; i < n; i++)
+    {
+        if (spaces && i > 0)
+        {
+            *out++ = 0x20;
+        }
+        out = encodeByte(bytes[i], out);
+    }
+    return out - start;
+}
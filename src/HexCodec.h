@@ -0,0 +1,67 @@
+#ifndef ELMulator_HexCodec_h
+#define ELMulator_HexCodec_h
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Hex text to bytes and back, for requests (ex: "010C") and responses
+ * (ex: 41 0C 1A F8).
+ *
+ * Decoding looks digits up in a 256 entry table; whole strings are checked
+ * 4 chars at a time in a 32 bit word (SWAR) and decoded 4 digits at a time.
+ * Encoding copies both digits of a byte from a 512 char table, so a
+ * response is written in one pass, with or without spaces.
+ */
+class HexCodec
+{
+public:
+    static const uint8_t INVALID = 0xFF;
+
+    // Value of a hex digit (upper or lower case), INVALID if c is not one
+    static inline uint8_t decodeDigit(char c)
+    {
+        return DECODE_TABLE[(uint8_t)c];
+    }
+
+    // Byte of 2 hex digits, which must be valid
+    static inline uint8_t decodeByte(const char *hex)
+    {
+        return (DECODE_TABLE[(uint8_t)hex[0]] << 4) | DECODE_TABLE[(uint8_t)hex[1]];
+    }
+
+    // True if the length chars of text are all hex digits
+    static bool isHex(const char *text, uint16_t length);
+
+    /**
+     * Decodes the digits of hex, which must be valid, into bytes
+     * (a last odd digit is ignored)
+     *
+     * @return number of bytes, length / 2
+     */
+    static uint16_t decode(const char *hex, uint16_t length, uint8_t *bytes);
+
+    // Upper case digit of the low nibble of value
+    static char encodeDigit(uint8_t value);
+
+    // Writes the 2 upper case digits of byte to out, returns out + 2
+    static inline char *encodeByte(uint8_t byte, char *out)
+    {
+        memcpy(out, PAIR_TABLE + 2 * byte, 2);
+        return out + 2;
+    }
+
+    /**
+     * Writes n bytes as upper case hex (ex: "410C1AF8", or "41 0C 1A F8" with
+     * spaces), not null terminated
+     *
+     * @return number of chars written
+     */
+    static uint16_t encode(const uint8_t *bytes, uint16_t n, char *out, bool spaces);
+
+private:
+    static const uint8_t DECODE_TABLE[256];
+    static const char PAIR_TABLE[513];
+};
+
+#endif
@@ -0,0 +1,64 @@
+#include "IsoTpFrames.h"
+#include <string.h>
+
+IsoTpFrames::IsoTpFrames(const uint8_t *payload, uint16_t length)
+{
+    this->payload = payload;
+    this->length = length < ISOTP_MAX_PAYLOAD ? length : ISOTP_MAX_PAYLOAD;
+}
+
+uint16_t IsoTpFrames::getLength() const
+{
+    return length;
+}
+
+uint16_t IsoTpFrames::getCount() const
+{
+    if (!isMultiFrame())
+    {
+        return 1;
+    }
+    uint16_t consecutive = length - FIRST_FRAME_MAX_BYTES;
+    return 1 + (consecutive + CONSECUTIVE_FRAME_MAX_BYTES - 1) / CONSECUTIVE_FRAME_MAX_BYTES;
+}
+
+bool IsoTpFrames::isMultiFrame() const
+{
+    return length > SINGLE_FRAME_MAX_BYTES;
+}
+
+uint8_t IsoTpFrames::getPciSize(uint16_t index) const
+{
+    return (isMultiFrame() && index == 0) ? 2 : 1;
+}
+
+uint8_t IsoTpFrames::getFrame(uint16_t index, uint8_t *frame) const
+{
+    uint16_t offset;
+    uint8_t nBytes;
+    if (!isMultiFrame())
+    {
+        frame[0] = length;
+        offset = 0;
+        nBytes = length;
+    }
+    else if (index == 0)
+    {
+        frame[0] = 0x10 | (length >> 8);
+        frame[1] = length & 0xFF;
+        offset = 0;
+        nBytes = FIRST_FRAME_MAX_BYTES;
+    }
+    else
+    {
+        frame[0] = 0x20 | (index & 0x0F);
+        offset = FIRST_FRAME_MAX_BYTES + (index - 1) * CONSECUTIVE_FRAME_MAX_BYTES;
+        nBytes = (length - offset < CONSECUTIVE_FRAME_MAX_BYTES) ? length - offset : CONSECUTIVE_FRAME_MAX_BYTES;
+    }
+
+    uint8_t pciSize = getPciSize(index);
+    memcpy(frame + pciSize, payload + offset, nBytes);
+    uint8_t used = pciSize + nBytes;
+    memset(frame + used, ISOTP_PADDING, CAN_FRAME_SIZE - used);
+    return used;
+}
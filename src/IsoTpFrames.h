@@ -0,0 +1,46 @@
+#ifndef ELMulator_IsoTpFrames_h
+#define ELMulator_IsoTpFrames_h
+
+#include <stdint.h>
+#include "definitions.h"
+
+/**
+ * Splits a payload (ex: 49 02 01 + 17 VIN chars) into the CAN frames an ECU
+ * sends for it (ISO 15765-2), computed one at a time from the payload, so
+ * long responses need no buffer of their own:
+ *
+ *   up to 7 bytes  single frame       0L + payload           (L = length)
+ *   longer         first frame        1L LL + 6 bytes         (LLL = length)
+ *                  consecutive frames 2N + 7 bytes, N = 1, 2, ... F, 0, 1, ...
+ *
+ * Frames are CAN_FRAME_SIZE bytes, the last one padded with ISOTP_PADDING.
+ */
+class IsoTpFrames
+{
+public:
+    // payload must outlive the frames, anything over ISOTP_MAX_PAYLOAD is dropped
+    IsoTpFrames(const uint8_t *payload, uint16_t length);
+
+    uint16_t getLength() const;
+
+    uint16_t getCount() const;
+
+    bool isMultiFrame() const;
+
+    /**
+     * Writes frame index (PCI, payload bytes, padding) to frame, which
+     * must hold CAN_FRAME_SIZE bytes
+     *
+     * @return number of bytes before the padding
+     */
+    uint8_t getFrame(uint16_t index, uint8_t *frame) const;
+
+    // Size of the PCI of frame index, its payload bytes follow
+    uint8_t getPciSize(uint16_t index) const;
+
+private:
+    const uint8_t *payload;
+    uint16_t length;
+};
+
+#endif
@@ -0,0 +1,437 @@
+#include "OBDComm.h"
+#include "definitions.h"
+
+
+OBDComm::OBDComm(OBDTransport *transport) {
+    this->transport = transport;
+    formatCounter = 0;
+    formatResetListener = nullptr;
+    formatResetListenerContext = nullptr;
+    ecuResponseId = 0;
+    nEcuResponses = 0;
+    flushPolicy = FLUSH_EACH_RESPONSE;
+    recorder = nullptr;
+    rxTimeUs = 0;
+    txLength = 0;
+    nSessions = transport->getMaxSessions();
+    sessions = new Session[nSessions];
+    for (uint8_t i = 0; i < nSessions; i++) {
+        sessions[i].connected = false;
+        sessions[i].lineLength = 0;
+        sessions[i].connectionId = 0;
+        activateSession(i);
+        setToDefaults();
+    }
+    activateSession(0);
+}
+
+OBDComm::~OBDComm() {
+    delete[] sessions;
+}
+
+void OBDComm::init(const String& deviceName) {
+    transport->init(deviceName);
+    setToDefaults();
+}
+
+void OBDComm::writeEnd() {
+
+    // 1 - write carriage return
+    writeTo("\r");
+
+    // 2- (optional ) write linefeed
+    if (settings->lineFeedEnable) {
+        writeTo("\n");
+    }
+
+    // another ECU answered, the response goes on
+    if (ecuResponseId != 0) {
+        ecuResponseId = 0;
+        nEcuResponses++;
+        return;
+    }
+
+    // 3 - Write prompt
+    writeTo(">");
+    nEcuResponses = 0;
+    endResponse();
+};
+
+
+void OBDComm::writeEndOK() {
+    writeTo("OK");
+    writeEnd();
+}
+
+void OBDComm::writeEndERROR() {
+    ELM_STATS_ERROR(ERROR);
+    writeTo("ERROR");
+    writeEnd();
+}
+
+void OBDComm::writeEndNoData() {
+    // other ECUs answered, only their responses are shown
+    if (nEcuResponses > 0) {
+        write(">");
+        nEcuResponses = 0;
+        endResponse();
+        return;
+    }
+    ELM_STATS_ERROR(NO_DATA);
+    writeTo("NO DATA");
+    writeEnd();
+}
+
+void OBDComm::writeEndUnknown() {
+    ELM_STATS_ERROR(UNKNOWN);
+    writeTo("?");
+    writeEnd();
+}
+
+void OBDComm::setToDefaults() {
+    setEcho(true);
+    setStatus(READY);
+    setWhiteSpaces(true);
+    setHeaders(false);
+    setAutoFormat(true);
+    setDlc(false);
+    setProtocol(PROTOCOL_CAN_11_500);
+    setLineFeeds(true);
+    setMemory(false);
+    setRequestHeader(FUNCTIONAL_REQUEST_ID);
+    setReceiveFilter(0);
+}
+
+// a functional request is answered by the engine ECU, unless another one is writing its response
+uint16_t OBDComm::getResponseHeader() {
+    if (ecuResponseId != 0) {
+        return ecuResponseId;
+    }
+    uint16_t request = settings->requestHeader == FUNCTIONAL_REQUEST_ID ? ENGINE_REQUEST_ID : settings->requestHeader;
+    return request + RESPONSE_ID_OFFSET;
+}
+
+// headers are only part of response frames (see writeEndPayload), never of text (ex: OK, echo)
+void OBDComm::writeTo(char const *response) {
+    write(response);
+}
+
+void OBDComm::writeTo(uint8_t cChar) {
+    char cValue[4];
+    itoa(cChar, cValue, DEC);
+    write(cValue);
+}
+
+void OBDComm::write(char const *string) {
+    while (*string) {
+        if (txLength == TX_BUFFER_SIZE) {
+            sendBuffer();
+        }
+        txBuffer[txLength++] = *string++;
+    }
+}
+
+void OBDComm::sendBuffer() {
+    if (txLength > 0) {
+        ELM_STATS_MARK(FORMAT);
+        transport->write((const uint8_t *)txBuffer, txLength);
+        ELM_STATS_TX(txLength);
+        if (recorder != nullptr) {
+            recorder->record(SessionRecorder::TX, activeSession, txBuffer, txLength, micros() - rxTimeUs);
+        }
+        txLength = 0;
+        ELM_STATS_MARK(TRANSPORT);
+    }
+}
+
+void OBDComm::endResponse() {
+    sendBuffer();
+    if (flushPolicy == FLUSH_EACH_RESPONSE) {
+        transport->flush();
+    }
+    ELM_STATS_END();
+}
+
+void OBDComm::setFlushPolicy(FLUSH_POLICY policy) {
+    flushPolicy = policy;
+}
+
+void OBDComm::setRecorder(SessionRecorder *recorder) {
+    this->recorder = recorder;
+}
+
+void OBDComm::writeEndPidTo(char const *response) {
+    uint16_t length = strlen(response);
+    uint8_t payload[length / N_CHARS_IN_BYTE + 1];
+    writeEndPayload(payload, HexCodec::decode(response, length, payload));
+}
+
+void OBDComm::writeEndMultiFrameTo(char const *response) {
+    writeEndPidTo(response);
+}
+
+void OBDComm::writeEndPayload(const uint8_t *payload, uint16_t length) {
+    IsoTpFrames frames(payload, length);
+    FrameFormatter formatter = getFrameFormatter();
+    uint16_t nLines = formatter.getLineCount(frames);
+    for (uint16_t i = 0; i < nLines; i++) {
+        if (i > 0) {
+            writeLineEnd();
+        }
+        if (txLength + FRAME_LINE_SIZE > TX_BUFFER_SIZE) {
+            sendBuffer();
+        }
+        txLength += formatter.formatLine(frames, i, txBuffer + txLength);
+    }
+    writeEnd();
+}
+
+uint16_t OBDComm::formatPayload(const uint8_t *payload, uint16_t length, char *formatted, uint16_t size) {
+    IsoTpFrames frames(payload, length);
+    FrameFormatter formatter = getFrameFormatter();
+    const char *lineEnd = settings->lineFeedEnable ? "\r\n" : "\r";
+    uint8_t lineEndLength = strlen(lineEnd);
+    uint16_t nLines = formatter.getLineCount(frames);
+    uint16_t pos = 0;
+    char line[FRAME_LINE_SIZE];
+    for (uint16_t i = 0; i < nLines; i++) {
+        uint8_t lineLength = formatter.formatLine(frames, i, line);
+        if (pos + lineLength + lineEndLength + 2 > size) { // > \0
+            return 0;
+        }
+        memcpy(formatted + pos, line, lineLength);
+        pos += lineLength;
+        memcpy(formatted + pos, lineEnd, lineEndLength);
+        pos += lineEndLength;
+    }
+    formatted[pos++] = '>';
+    formatted[pos] = '\0';
+    return pos;
+}
+
+FrameFormatter OBDComm::getFrameFormatter() {
+    uint8_t flags = (settings->headersEnabled ? FrameFormatter::HEADERS : 0) |
+                    (settings->whiteSpacesEnabled ? FrameFormatter::SPACES : 0) |
+                    (settings->autoFormatEnabled ? FrameFormatter::AUTO_FORMAT : 0) |
+                    (settings->dlcEnabled ? FrameFormatter::DLC : 0) |
+                    (settings->protocol & 1 ? FrameFormatter::EXTENDED_IDS : 0); // 7, 9
+    return FrameFormatter(flags, getResponseHeader());
+}
+
+void OBDComm::writeLineEnd() {
+    writeTo("\r");
+    if (settings->lineFeedEnable) {
+        writeTo("\n");
+    }
+}
+
+uint8_t OBDComm::formatPidResponse(char const *response, char *formatted, uint8_t size) {
+    uint8_t length = strlen(response);
+    if (length / N_CHARS_IN_BYTE > SINGLE_FRAME_MAX_BYTES) {
+        return 0;
+    }
+    uint8_t payload[SINGLE_FRAME_MAX_BYTES];
+    return formatPayload(payload, HexCodec::decode(response, length, payload), formatted, size);
+}
+
+void OBDComm::writeEndFormatted(char const *formatted) {
+    write(formatted); // headers, if any, are part of it
+    nEcuResponses = 0;
+    endResponse();
+}
+
+uint16_t OBDComm::getFormatVersion() {
+    return settings->formatVersion;
+}
+
+void OBDComm::setFormatResetListener(FormatResetListener listener, void *context) {
+    formatResetListener = listener;
+    formatResetListenerContext = context;
+}
+
+/**
+ * 0 is "not rendered yet" for the caches, so when the counter wraps every
+ * session is numbered again from 1 and the listener drops what was rendered
+ * before: an old version could otherwise match a new one.
+ */
+void OBDComm::nextFormatVersion() {
+    if (formatCounter == UINT16_MAX) {
+        formatCounter = 0;
+        for (uint8_t i = 0; i < nSessions; i++) {
+            sessions[i].settings.formatVersion = ++formatCounter;
+        }
+        if (formatResetListener != nullptr) {
+            formatResetListener(formatResetListenerContext);
+        }
+    }
+    settings->formatVersion = ++formatCounter;
+}
+
+int16_t OBDComm::readData(char *rxData, uint8_t size) {
+    unsigned long start = millis();
+    do {
+        int16_t length = pollData(rxData, size);
+        if (length >= 0) {
+            return length;
+        }
+        yield();
+    } while (millis() - start < SERIAL_READ_TIMEOUT);
+    return -1;
+}
+
+int16_t OBDComm::pollData(char *rxData, uint8_t size) {
+    // output left over from the last request (ex: echo without a response)
+    // goes to the client that sent it, before another session becomes active
+    sendBuffer();
+    transport->update();
+
+    // round robin over the sessions, starting after the last one served
+    for (uint8_t n = 1; n <= nSessions; n++) {
+        uint8_t session = (activeSession + n) % nSessions;
+        int16_t length = readSession(session, rxData, size);
+        if (length >= 0) {
+            return length;
+        }
+    }
+    transport->selectSession(activeSession);
+    return -1;
+}
+
+/**
+ * Appends the bytes available on session to its line buffer. When the line is
+ * complete it is copied to rxData and the session becomes the active one, so
+ * the response and any AT setting change go to that client.
+ */
+int16_t OBDComm::readSession(uint8_t session, char *rxData, uint8_t size) {
+    Session &s = sessions[session];
+    transport->selectSession(session);
+    if (!transport->connected()) {
+        s.connected = false;
+        return -1;
+    }
+
+    // new client on this session, starts with default settings; the connection
+    // id also catches a client replacing another within a single update()
+    uint16_t connectionId = transport->getConnectionId();
+    if (!s.connected || s.connectionId != connectionId) {
+        s.connected = true;
+        s.connectionId = connectionId;
+        s.lineLength = 0;
+        Settings *current = settings;
+        settings = &s.settings;
+        setToDefaults();
+        settings = current;
+    }
+
+    int c;
+    while ((c = transport->read()) >= 0) {
+        if (c == SERIAL_END_CHAR) {
+            uint8_t length = s.lineLength;
+            uint8_t stored = (length < size) ? length : size - 1;
+            memcpy(rxData, s.line, stored);
+            rxData[stored] = '\0';
+            s.lineLength = 0;
+            ELM_STATS_START(length + 1);
+
+            if (recorder != nullptr) {
+                rxTimeUs = micros();
+                recorder->record(SessionRecorder::RX, session, s.line, length < sizeof(s.line) ? length : sizeof(s.line));
+            }
+            activateSession(session);
+            if (isEchoEnable()) {
+                writeTo(rxData);
+                writeLineEnd();
+            }
+            return length;
+        }
+        if (s.lineLength < sizeof(s.line)) {
+            s.line[s.lineLength] = c;
+        }
+        if (s.lineLength < 0xFF) {
+            s.lineLength++;
+        }
+    }
+    return -1;
+}
+
+void OBDComm::activateSession(uint8_t session) {
+    activeSession = session;
+    settings = &sessions[session].settings;
+    transport->selectSession(session);
+}
+
+uint8_t OBDComm::getActiveSession() {
+    return activeSession;
+}
+
+bool OBDComm::isEchoEnable() {
+    return settings->echoEnable;
+}
+
+void OBDComm::setEcho(bool echo) {
+    settings->echoEnable = echo;
+}
+
+void OBDComm::setStatus(STATUS status) {
+    this->status = status;
+}
+
+void OBDComm::setLineFeeds(bool status) {
+    settings->lineFeedEnable = status;
+    nextFormatVersion();
+}
+
+void OBDComm::setMemory(bool status) {
+    settings->memoryEnabled = status;
+}
+
+void OBDComm::setWhiteSpaces(bool status) {
+    settings->whiteSpacesEnabled = status;
+    nextFormatVersion();
+}
+
+void OBDComm::setHeaders(bool status) {
+    settings->headersEnabled = status;
+    nextFormatVersion();
+}
+
+void OBDComm::setAutoFormat(bool status) {
+    settings->autoFormatEnabled = status;
+    nextFormatVersion();
+}
+
+void OBDComm::setDlc(bool status) {
+    settings->dlcEnabled = status;
+    nextFormatVersion();
+}
+
+void OBDComm::setProtocol(uint8_t protocol) {
+    bool can = protocol >= PROTOCOL_CAN_11_500 && protocol <= PROTOCOL_CAN_29_250;
+    settings->protocol = can ? protocol : PROTOCOL_CAN_11_500;
+    nextFormatVersion();
+}
+
+uint8_t OBDComm::getProtocol() {
+    return settings->protocol;
+}
+
+void OBDComm::setRequestHeader(uint16_t header) {
+    settings->requestHeader = header;
+    nextFormatVersion();
+}
+
+uint16_t OBDComm::getRequestHeader() {
+    return settings->requestHeader;
+}
+
+void OBDComm::setReceiveFilter(uint16_t header) {
+    settings->receiveFilter = header;
+}
+
+bool OBDComm::isReceived(uint16_t header) {
+    return settings->receiveFilter == 0 || settings->receiveFilter == header;
+}
+
+void OBDComm::beginEcuResponse(uint16_t responseId) {
+    ecuResponseId = responseId;
+}
@@ -0,0 +1,255 @@
+#ifndef ELMulator_OBDComm_h
+#define ELMulator_OBDComm_h
+
+#include <Arduino.h>
+#include "definitions.h"
+#include "OBDTransport.h"
+#include "SessionRecorder.h"
+#include "ELMStats.h"
+#include "IsoTpFrames.h"
+#include "FrameFormatter.h"
+#include "HexCodec.h"
+
+/**
+ * ELM327 side of a connection: echo, line feeds, spaces, headers and
+ * response formatting. The bytes themselves go through an OBDTransport
+ * (Bluetooth, WiFi, any Arduino Stream), so every transport answers the same way.
+ */
+class OBDComm
+{
+public:
+    enum STATUS
+    {
+        IDLE = 0,
+        READY = 1
+    };
+
+    // When the transport is flushed, see setFlushPolicy
+    enum FLUSH_POLICY
+    {
+        FLUSH_NEVER = 0,        // leave it to the transport (Bluetooth/TCP stack)
+        FLUSH_EACH_RESPONSE = 1 // wait until each response is sent
+    };
+
+    OBDComm(OBDTransport *transport);
+
+    ~OBDComm();
+
+    void init(const String &deviceName);
+
+    void writeEndOK();
+
+    void writeEndERROR();
+
+    /**
+     * Response for unsupported PID command or missing sensor, respond "NO DATA".
+     */
+    void writeEndNoData();
+
+    /**
+     * Response for invalid AT command, or invalid PID or other bad input, respond "?"
+     */
+    void writeEndUnknown();
+
+    void setToDefaults();
+
+    /**
+     * Reads one request line into rxData, up to SERIAL_END_CHAR (not stored).
+     * Chars that do not fit in rxData are dropped but still counted.
+     *
+     * @param rxData - buffer for the received chars, null terminated
+     * @param size - size of rxData
+     * @return number of chars received, or -1 if no complete line was received
+     */
+    int16_t readData(char *rxData, uint8_t size);
+
+    /**
+     * Non blocking readData: takes whatever bytes are available on each
+     * session and returns as soon as one of them completes a line.
+     *
+     * @return number of chars received, or -1 if no line is complete yet
+     */
+    int16_t pollData(char *rxData, uint8_t size);
+
+    void writeTo(uint8_t cChar);
+
+    void writeTo(char const *string);
+
+    void setEcho(bool echo);
+
+    void writeEnd();
+
+    // End of a line inside a multi line response
+    void writeLineEnd();
+
+    bool isEchoEnable();
+
+    void setLineFeeds(bool status);
+
+    void setMemory(bool status);
+
+    void setWhiteSpaces(bool status);
+
+    void setHeaders(bool status);
+
+    // CAN auto formatting (ATCAF), see writeEndPayload
+    void setAutoFormat(bool status);
+
+    // Show the DLC after the header (ATD1)
+    void setDlc(bool status);
+
+    /**
+     * CAN protocol (ATSP): 6, 8 for 11 bit ids, 7, 9 for 29 bit ids (500,
+     * 250 kbps), anything else (ex: 0 auto) is taken as 6
+     */
+    void setProtocol(uint8_t protocol);
+
+    uint8_t getProtocol();
+
+    void setStatus(STATUS status);
+
+    // Write a response given as hex chars (ex: 410C1AF8), see writeEndPayload
+    void writeEndPidTo(char const *string);
+
+    // Same as writeEndPidTo, kept for compatibility
+    void writeEndMultiFrameTo(char const *string);
+
+    /**
+     * Writes a response payload (ex: 49 02 01 + VIN) the way an ELM327 shows
+     * the CAN frames carrying it, one line per frame, following ATCAF, ATH,
+     * ATD, ATS and the protocol (see FrameFormatter). Each line is formatted
+     * straight into the transmit buffer, nothing is allocated.
+     */
+    void writeEndPayload(const uint8_t *payload, uint16_t length);
+
+    /**
+     * Renders a payload response as writeEndPayload would write it, end chars
+     * included, so it can be cached and written again with writeEndFormatted
+     *
+     * @return number of chars written to formatted, 0 if it does not fit in size
+     */
+    uint16_t formatPayload(const uint8_t *payload, uint16_t length, char *formatted, uint16_t size);
+
+    /**
+     * Renders a PID response (ex: 410C1AF8) as it would be written by
+     * writeEndPidTo, so it can be cached and written again with writeEndFormatted.
+     *
+     * @return number of chars written to formatted, 0 if it does not fit in size
+     *         or the response is multi frame
+     */
+    uint8_t formatPidResponse(char const *response, char *formatted, uint8_t size);
+
+    // Write a response rendered by formatPidResponse
+    void writeEndFormatted(char const *formatted);
+
+    // Changes every time a setting that affects formatPidResponse output changes,
+    // unique across sessions, never 0
+    uint16_t getFormatVersion();
+
+    // Called when the format versions wrapped around and were renumbered, so
+    // anything rendered for an older version must be dropped
+    typedef void (*FormatResetListener)(void *context);
+
+    // Only one listener, PidProcessor uses it to flush its rendered responses
+    void setFormatResetListener(FormatResetListener listener, void *context);
+
+    // Session (client) the current request came from and the response goes to
+    uint8_t getActiveSession();
+
+    // CAN id requests are sent to (ATSH), FUNCTIONAL_REQUEST_ID (7DF) for all ECUs
+    void setRequestHeader(uint16_t header);
+
+    uint16_t getRequestHeader();
+
+    // Only show responses from CAN id header (ATCRA), 0 to show all
+    void setReceiveFilter(uint16_t header);
+
+    // CAN id of the ECU answering: the addressed one (ATSH + 8), the engine ECU for functional requests
+    uint16_t getResponseHeader();
+
+    // False if responses from CAN id header are hidden by ATCRA
+    bool isReceived(uint16_t header);
+
+    /**
+     * Starts the response of another ECU than the one the request is for
+     * (functional requests, see EcuTable): it is written with header
+     * responseId and its end has no prompt, so the next response (or
+     * writeEndNoData, which then only writes the prompt) completes it
+     */
+    void beginEcuResponse(uint16_t responseId);
+
+    /**
+     * Responses are always sent with a single transport write when complete,
+     * FLUSH_EACH_RESPONSE also waits for it to be sent (as before), FLUSH_NEVER
+     * returns right away. Default is FLUSH_EACH_RESPONSE.
+     */
+    void setFlushPolicy(FLUSH_POLICY policy);
+
+    // Record every request line and transport write, nullptr to stop
+    void setRecorder(SessionRecorder *recorder);
+
+private:
+    // AT settings, kept for each session (client)
+    struct Settings
+    {
+        uint16_t requestHeader; // ATSH, responses come from requestHeader + 8
+        uint16_t receiveFilter; // ATCRA, 0 == all responses shown
+        bool echoEnable;   // echoEnable command after received
+        bool lineFeedEnable;
+        bool memoryEnabled;
+        bool whiteSpacesEnabled;
+        bool headersEnabled; // Headers enabled in response
+        bool autoFormatEnabled; // ATCAF, hide the PCI bytes and padding
+        bool dlcEnabled;        // ATD1, DLC after the header
+        uint8_t protocol;       // ATSP, 6 to 9
+        uint16_t formatVersion; // changed when a response formatting setting changes
+    };
+
+    struct Session
+    {
+        Settings settings;
+        char line[MAX_REQUEST_SIZE + 1]; // request being received
+        uint8_t lineLength;              // chars received, may exceed line
+        bool connected;
+        uint16_t connectionId;           // transport connection the settings belong to
+    };
+
+    OBDTransport *transport;
+    STATUS status;     // Operation status
+    Session *sessions;
+    uint8_t nSessions;
+    uint8_t activeSession;
+    Settings *settings; // settings of the active session
+    uint16_t formatCounter;
+    FormatResetListener formatResetListener;
+    void *formatResetListenerContext;
+    uint16_t ecuResponseId; // header of the other ECU response being written, 0 if none
+    uint8_t nEcuResponses;  // other ECU responses written in the current response
+    FLUSH_POLICY flushPolicy;
+    SessionRecorder *recorder;
+    uint32_t rxTimeUs; // micros() when the current request was received
+
+    // response being assembled, sent by endResponse
+    char txBuffer[TX_BUFFER_SIZE];
+    uint16_t txLength;
+
+    int16_t readSession(uint8_t session, char *rxData, uint8_t size);
+
+    void activateSession(uint8_t session);
+
+    // gives the active session a new format version
+    void nextFormatVersion();
+
+    // Formatter of the response frames for the current settings and ECU
+    FrameFormatter getFrameFormatter();
+
+    void write(char const *string);
+
+    // send the buffered output with a single transport write
+    void sendBuffer();
+
+    // send the complete response and flush according to flushPolicy
+    void endResponse();
+};
+
+#endif
\ No newline at end of file
@@ -1,9 +1,11 @@
 #include "OBDSerialComm.h"
-#include "definitions.h"
 
+#if HAS_ESP32_TRANSPORTS
+
+volatile uint16_t OBDSerialComm::connectionId = 0;
 
 OBDSerialComm::OBDSerialComm() {
-    
+    serial = nullptr;
 }
 
 OBDSerialComm::~OBDSerialComm() {
@@ -13,157 +15,36 @@ OBDSerialComm::~OBDSerialComm() {
 void OBDSerialComm::init(const String& deviceName) {
     Serial.println("Starting BT . . .");
     serial = new BluetoothSerial();
+    serial->register_callback(onSppEvent);
     //delay(2000);
     serial->begin(deviceName, false);
-    setToDefaults();
-
-}
-
-void OBDSerialComm::writeEnd() {
-
-    // 1 - write carriage return
-    writeTo("\r");
-
-    // 2- (optional ) write linefeed
-    if (lineFeedEnable) {
-        writeTo("\n");
-    }
-
-    // 3 - Write prompt
-    writeTo(">");
-    headerPrintedThisResponse = false; // Reset for next response
-    serial->flush();
-};
-
-
-void OBDSerialComm::writeEndOK() {
-    writeTo("OK");
-    writeEnd();
 }
 
-void OBDSerialComm::writeEndERROR() {
-    writeTo("ERROR");
-    writeEnd();
+int OBDSerialComm::available() {
+    return serial->available();
 }
 
-void OBDSerialComm::writeEndNoData() {
-    writeTo("NO DATA");
-    writeEnd();
+int OBDSerialComm::read() {
+    return serial->read();
 }
 
-void OBDSerialComm::writeEndUnknown() {
-    writeTo("?");
-    writeEnd();
+size_t OBDSerialComm::write(const uint8_t *data, size_t length) {
+    return serial->write(data, length);
 }
 
-void OBDSerialComm::setToDefaults() {
-    setEcho(true);
-    setStatus(READY);
-    setWhiteSpaces(true);
-    setHeaders(false);
-    setLineFeeds(true);
-    setMemory(false);
-    setUseCustomHeader(false);
-    setCustomHeader(0); // Use 0 instead of NULL
-}
-
-void OBDSerialComm::printHeaderIfEnabled() {
-    if (headersEnabled && !headerPrintedThisResponse) {
-        int headerToPrint = 0x7E7;
-        if (useCustomHeader && customHeader != 0) {
-            headerToPrint = customHeader;
-        }
-        char headerStr[5];
-        snprintf(headerStr, sizeof(headerStr), "%03X ", headerToPrint);
-        serial->print(headerStr);
-        headerPrintedThisResponse = true;
-    }
-}
-
-void OBDSerialComm::writeTo(char const *response) {
-    printHeaderIfEnabled();
-    serial->print(response);
-}
-
-void OBDSerialComm::writeTo(uint8_t cChar) {
-    printHeaderIfEnabled();
-    serial->print(cChar);
+void OBDSerialComm::flush() {
+    serial->flush();
 }
 
-void OBDSerialComm::writeEndPidTo(char const *response) {
-    if (whiteSpacesEnabled) {
-        uint8_t len = strlen(response);
-        char spacedResponse[len + len / 2 + 1];
-        addSpacesToResponse(response, spacedResponse);
-        writeTo(spacedResponse);
-    } else {
-        writeTo(response);
-    }
-    writeEnd();
+uint16_t OBDSerialComm::getConnectionId() {
+    return connectionId;
 }
 
-void OBDSerialComm::readData(String& rxData) {
-    serial->flush(); // temp remove this
-    rxData = serial->readStringUntil(SERIAL_END_CHAR);
-    if (isEchoEnable()) {
-        writeTo(rxData.c_str());
+// Bluetooth task
+void OBDSerialComm::onSppEvent(esp_spp_cb_event_t event, esp_spp_cb_param_t *param) {
+    if (event == ESP_SPP_SRV_OPEN_EVT) {
+        connectionId = connectionId + 1;
     }
-    //return rxData;
-}
-
-void OBDSerialComm::setBaudRate(uint32_t rate) {
-    this->baudRate = rate;
 }
 
-long OBDSerialComm::getBaudRate() {
-    return this->baudRate;
-}
-
-bool OBDSerialComm::isEchoEnable() {
-    return this->echoEnable;
-}
-
-void OBDSerialComm::setEcho(bool echo) {
-    this->echoEnable = echo;
-}
-
-void OBDSerialComm::setStatus(STATUS status) {
-    this->status = status;
-}
-
-void OBDSerialComm::setLineFeeds(bool status) {
-    this->lineFeedEnable = status;
-}
-
-void OBDSerialComm::setMemory(bool status) {
-    this->memoryEnabled = status;
-}
-
-void OBDSerialComm::setWhiteSpaces(bool status) {
-    this->whiteSpacesEnabled = status;
-}
-
-void OBDSerialComm::setHeaders(bool status) {
-    this->headersEnabled = status;
-}
-
-void OBDSerialComm::setUseCustomHeader(bool use) {
-    this->useCustomHeader = use;
-}
-
-void OBDSerialComm::setCustomHeader(uint16_t header) {
-    this->customHeader = header;
-}
-
-void OBDSerialComm::addSpacesToResponse(const char *response, char spacedRes[]) {
-    uint8_t len = strlen(response);
-    int j = 0;
-    for (int i = 0; i < len;) {
-        *(spacedRes + j++) = *(response + i++);
-        *(spacedRes + j++) = *(response + i++);
-        if (i < len) {
-            *(spacedRes + j++) = 0x20;
-        }
-    }
-    *(spacedRes + j) = '\0';
-}
+#endif
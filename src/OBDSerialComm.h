@@ -3,97 +3,41 @@
 
 #include <Arduino.h>
 #include "definitions.h"
+#include "OBDTransport.h"
 
-#include <BluetoothSerial.h>
+#if HAS_ESP32_TRANSPORTS
 
+#include <BluetoothSerial.h>
 
-class OBDSerialComm
+// Bluetooth SPP transport using the ESP32 builtin Bluetooth
+class OBDSerialComm : public OBDTransport
 {
 public:
-    enum STATUS
-    {
-        IDLE = 0,
-        READY = 1
-    };
-
-// // Bluetooth is not built in, we are using a BT module via GPIO
-//     OBDSerialComm(uint32_t baudRate, uint8_t rxPin, uint8_t txPin);
-
     OBDSerialComm();
 
     ~OBDSerialComm();
 
-    void init(const String &deviceName);
-
-    void writeEndOK();
-
-    void writeEndERROR();
-
-    /**
-     * Response for unsupported PID command or missing sensor, respond "NO DATA".
-     */
-    void writeEndNoData();
-
-    /**
-     * Response for invalid AT command, or invalid PID or other bad input, respond "?"
-     */
-    void writeEndUnknown();
-
-    void setToDefaults();
-
-    void readData(String &rxData);
-
-    void writeTo(uint8_t cChar);
+    void init(const String &deviceName) override;
 
-    void writeTo(char const *string);
+    int available() override;
 
-    void setEcho(bool echo);
+    int read() override;
 
-    void writeEnd();
+    size_t write(const uint8_t *data, size_t length) override;
 
-    bool isEchoEnable();
+    void flush() override;
 
-    void setLineFeeds(bool status);
+    uint16_t getConnectionId() override;
 
-    void setMemory(bool status);
-
-    void setWhiteSpaces(bool status);
-
-    void setHeaders(bool status);
-
-    void setStatus(STATUS status);
-
-    void writeEndPidTo(char const *string);
+private:
+    BluetoothSerial *serial;
 
-    void setCustomHeader(uint16_t header);
-    
-    void setUseCustomHeader(bool useCustomHeader);
+    // incremented for each client opening the SPP connection
+    static volatile uint16_t connectionId;
 
-    void printHeaderIfEnabled();
+    static void onSppEvent(esp_spp_cb_event_t event, esp_spp_cb_param_t *param);
+};
 
-private:
-    uint32_t baudRate; // Serial Baud Rate
-    uint16_t customHeader; // Custom header for the response
-    STATUS status;     // Operation status
-    bool echoEnable;   // echoEnable command after received
-    bool lineFeedEnable;
-    bool memoryEnabled;
-    bool whiteSpacesEnabled;
-    bool headersEnabled; // Headers enabled in response
-    bool useCustomHeader; // Use custom header in response
-    bool headerPrintedThisResponse; // Flag to track if header was printed in the current response
-
-    void setBaudRate(uint32_t rate);
-
-    long getBaudRate();
-
-    void addSpacesToResponse(const char *response, char string[]);
-
-#ifndef BLUETOOTH_BUILTIN
-    HardwareSerial *serial; // lib to communicate with bluetooth
-#else
-    BluetoothSerial *serial;
 #endif
-};
 
-#endif
\ No newline at end of file
+#endif
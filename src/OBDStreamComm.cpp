@@ -0,0 +1,24 @@
+#include "OBDStreamComm.h"
+
+OBDStreamComm::OBDStreamComm(Stream &stream) {
+    this->stream = &stream;
+}
+
+void OBDStreamComm::init(const String& deviceName) {
+}
+
+int OBDStreamComm::available() {
+    return stream->available();
+}
+
+int OBDStreamComm::read() {
+    return stream->read();
+}
+
+size_t OBDStreamComm::write(const uint8_t *data, size_t length) {
+    return stream->write(data, length);
+}
+
+void OBDStreamComm::flush() {
+    stream->flush();
+}
@@ -0,0 +1,31 @@
+#ifndef ELMulator_OBDStreamComm_h
+#define ELMulator_OBDStreamComm_h
+
+#include <Arduino.h>
+#include "OBDTransport.h"
+
+/**
+ * Transport over any Arduino Stream: a hardware UART (Serial2, ...) or,
+ * off device, an in memory or pty Stream driving the whole stack.
+ * The stream must already be started (ex: Serial2.begin(38400)).
+ */
+class OBDStreamComm : public OBDTransport
+{
+public:
+    OBDStreamComm(Stream &stream);
+
+    void init(const String &deviceName) override;
+
+    int available() override;
+
+    int read() override;
+
+    size_t write(const uint8_t *data, size_t length) override;
+
+    void flush() override;
+
+private:
+    Stream *stream;
+};
+
+#endif
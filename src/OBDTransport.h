@@ -0,0 +1,45 @@
+#ifndef ELMulator_OBDTransport_h
+#define ELMulator_OBDTransport_h
+
+#include <Arduino.h>
+
+/**
+ * Byte level connection to the OBD client software (Bluetooth SPP, WiFi TCP,
+ * UART, ...). Only moves bytes: all ELM327 formatting is done by OBDComm on top.
+ */
+class OBDTransport
+{
+public:
+    virtual ~OBDTransport() {}
+
+    // Start the transport (ex: Bluetooth device name, WiFi SSID)
+    virtual void init(const String &deviceName) = 0;
+
+    // false while no client is connected, reading is skipped
+    virtual bool connected() { return true; }
+
+    virtual int available() = 0;
+
+    // next received byte, or -1 if none available
+    virtual int read() = 0;
+
+    virtual size_t write(const uint8_t *data, size_t length) = 0;
+
+    // push written bytes out to the client
+    virtual void flush() {}
+
+    // Transports serving several clients at once (ex: WiFi) have one session
+    // per client; connected, available, read and write act on the selected one
+    virtual uint8_t getMaxSessions() { return 1; }
+
+    virtual void selectSession(uint8_t session) {}
+
+    // Changes each time a new client takes the selected session, so a client
+    // replacing another between two polls is not taken for the same one
+    virtual uint16_t getConnectionId() { return 0; }
+
+    // Non blocking housekeeping, ex: accept new clients
+    virtual void update() {}
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include "OBDWiFiComm.h"
-#include "definitions.h"
+
+#if HAS_ESP32_TRANSPORTS
 
 WiFiServer server(35000);
 IPAddress localIP = IPAddress(192, 168, 0, 10);
@@ -7,7 +8,8 @@ IPAddress gateway = IPAddress(192, 168, 0, 10);
 IPAddress subnet = IPAddress(255,255,255,0);
 
 OBDWiFiComm::OBDWiFiComm() {
-    
+    session = 0;
+    memset(connectionIds, 0, sizeof(connectionIds));
 }
 
 OBDWiFiComm::~OBDWiFiComm() {
@@ -25,127 +27,54 @@ void OBDWiFiComm::init(const String& deviceName) {
     Serial.print("AP SSID: ");
     Serial.println(deviceName);
     server.begin();
-    setToDefaults();
-}
-
-void OBDWiFiComm::writeEnd() {
-
-    // 1 - write carriage return
-    writeTo("\r");
-
-    // 2- (optional ) write linefeed
-    if (lineFeedEnable) {
-        writeTo("\n");
-    }
-
-    // 3 - Write prompt
-    writeTo(">");
-};
-
-
-void OBDWiFiComm::writeEndOK() {
-    writeTo("OK");
-    writeEnd();
-}
-
-void OBDWiFiComm::writeEndERROR() {
-    writeTo("ERROR");
-    writeEnd();
-}
-
-void OBDWiFiComm::writeEndNoData() {
-    writeTo("NO DATA");
-    writeEnd();
-}
-
-void OBDWiFiComm::writeEndUnknown() {
-    writeTo("?");
-    writeEnd();
-}
-
-void OBDWiFiComm::setToDefaults() {
-    setEcho(true);
-    setStatus(READY);
-    setWhiteSpaces(true);
-    setHeaders(false);
-    setLineFeeds(true);
-    setMemory(false);
-}
-
-void OBDWiFiComm::writeTo(char const *response) {
-    client.print(response);
-}
-
-
-void OBDWiFiComm::writeTo(uint8_t cChar) {
-    client.print(cChar);
+    server.setNoDelay(true);
 }
 
-void OBDWiFiComm::writeEndPidTo(char const *response) {
-    if (this->whiteSpacesEnabled) {
-        uint8_t len = strlen(response);
-        char spacedResponse[len + len / 2 + 1];
-        addSpacesToResponse(response, spacedResponse);
-        writeTo(spacedResponse);
-    } else {
-        writeTo(response);
-    }
-    writeEnd();
-}
-
-void OBDWiFiComm::readData(String& rxData) {
-    if (!client.connected()) {
-        client = server.available();
+void OBDWiFiComm::update() {
+    if (!server.hasClient()) {
+        return;
     }
 
-    if(client)
-    {
-        rxData
-         = client.readStringUntil(SERIAL_END_CHAR);
-        if (isEchoEnable()) 
-        {
-            writeTo(rxData.c_str());
+    WiFiClient client = server.available();
+    for (uint8_t i = 0; i < MAX_WIFI_CLIENTS; i++) {
+        if (!clients[i].connected()) {
+            clients[i].stop();
+            clients[i] = client;
+            connectionIds[i]++;
+            return;
         }
     }
-}
 
-bool OBDWiFiComm::isEchoEnable() {
-    return this->echoEnable;
+    // all sessions in use
+    client.stop();
 }
 
-void OBDWiFiComm::setEcho(bool echo) {
-    this->echoEnable = echo;
+bool OBDWiFiComm::connected() {
+    return clients[session].connected();
 }
 
-void OBDWiFiComm::setStatus(STATUS status) {
-    this->status = status;
+int OBDWiFiComm::available() {
+    return clients[session].available();
 }
 
-void OBDWiFiComm::setLineFeeds(bool status) {
-    this->lineFeedEnable = status;
+int OBDWiFiComm::read() {
+    return clients[session].read();
 }
 
-void OBDWiFiComm::setMemory(bool status) {
-    this->memoryEnabled = status;
+size_t OBDWiFiComm::write(const uint8_t *data, size_t length) {
+    return clients[session].write(data, length);
 }
 
-void OBDWiFiComm::setWhiteSpaces(bool status) {
-    this->whiteSpacesEnabled = status;
+uint8_t OBDWiFiComm::getMaxSessions() {
+    return MAX_WIFI_CLIENTS;
 }
 
-void OBDWiFiComm::setHeaders(bool status) {
-    this->headersEnabled = status;
+void OBDWiFiComm::selectSession(uint8_t session) {
+    this->session = session;
 }
 
-void OBDWiFiComm::addSpacesToResponse(const char *response, char spacedRes[]) {
-    uint8_t len = strlen(response);
-    int j = 0;
-    for (int i = 0; i < len;) {
-        *(spacedRes + j++) = *(response + i++);
-        *(spacedRes + j++) = *(response + i++);
-        if (i < len) {
-            *(spacedRes + j++) = 0x20;
-        }
-    }
-    *(spacedRes + j) = '\0';
+uint16_t OBDWiFiComm::getConnectionId() {
+    return connectionIds[session];
 }
+
+#endif
@@ -2,77 +2,52 @@
 #define ELMulator_OBDWiFiComm_h
 
 #include <Arduino.h>
-#include <WiFi.h>
-#include <WiFiServer.h>
 #include "definitions.h"
+#include "OBDTransport.h"
+
+#if HAS_ESP32_TRANSPORTS
 
+#include <WiFi.h>
+#include <WiFiServer.h>
 
-class OBDWiFiComm
+/**
+ * WiFi transport: soft AP with a TCP server. Up to MAX_WIFI_CLIENTS clients
+ * are served at once, one session each; accept and reads never block.
+ */
+class OBDWiFiComm : public OBDTransport
 {
 public:
-    enum STATUS
-    {
-        IDLE = 0,
-        READY = 1
-    };
-
     OBDWiFiComm();
 
     ~OBDWiFiComm();
 
-    void init(const String &deviceName);
-
-    void writeEndOK();
-
-    void writeEndERROR();
-
-    /**
-     * Response for unsupported PID command or missing sensor, respond "NO DATA".
-     */
-    void writeEndNoData();
+    void init(const String &deviceName) override;
 
-    /**
-     * Response for invalid AT command, or invalid PID or other bad input, respond "?"
-     */
-    void writeEndUnknown();
+    bool connected() override;
 
-    void setToDefaults();
+    int available() override;
 
-    void readData(String &rxData);
+    int read() override;
 
-    void writeTo(uint8_t cChar);
+    size_t write(const uint8_t *data, size_t length) override;
 
-    void writeTo(char const *string);
+    // flush() is not overridden: WiFiClient::flush() drops received data
 
-    void setEcho(bool echo);
+    uint8_t getMaxSessions() override;
 
-    void writeEnd();
+    void selectSession(uint8_t session) override;
 
-    bool isEchoEnable();
+    uint16_t getConnectionId() override;
 
-    void setLineFeeds(bool status);
-
-    void setMemory(bool status);
-
-    void setWhiteSpaces(bool status);
-
-    void setHeaders(bool status);
-
-    void setStatus(STATUS status);
-
-    void writeEndPidTo(char const *string);
+    // accepts a pending client into a free session
+    void update() override;
 
 private:
-    STATUS status;     // Operation status
-    bool echoEnable;   // echoEnable command after received
-    bool lineFeedEnable;
-    bool memoryEnabled;
-    bool whiteSpacesEnabled;
-    bool headersEnabled;
-
-    void addSpacesToResponse(const char *response, char string[]);
-
-    WiFiClient client;
+    WiFiClient clients[MAX_WIFI_CLIENTS];
+    uint16_t connectionIds[MAX_WIFI_CLIENTS]; // incremented for each client accepted
+    uint8_t session;
 };
 
-#endif
\ No newline at end of file
+#endif
+
+#endif
@@ -0,0 +1,120 @@
+#include "PidDescriptor.h"
+
+/**
+ * Mode 01 pids of definitions.h with a linear SAE J1979 formula
+ * (https://en.wikipedia.org/wiki/OBD-II_PIDs#Service_01), sorted by pid.
+ * Bit encoded, signed and multi value pids are not listed.
+ */
+constexpr PidDescriptor PidDescriptor::TABLE[] = {
+    pidDescriptor(ENGINE_LOAD,                    1, 0,   255, 100, "%"),
+    pidDescriptor(ENGINE_COOLANT_TEMP,            1, 40,  1,   1,   "C"),
+    pidDescriptor(SHORT_TERM_FUEL_TRIM_BANK_1,    1, 100, 128, 100, "%"),
+    pidDescriptor(LONG_TERM_FUEL_TRIM_BANK_1,     1, 100, 128, 100, "%"),
+    pidDescriptor(SHORT_TERM_FUEL_TRIM_BANK_2,    1, 100, 128, 100, "%"),
+    pidDescriptor(LONG_TERM_FUEL_TRIM_BANK_2,     1, 100, 128, 100, "%"),
+    pidDescriptor(FUEL_PRESSURE,                  1, 0,   1,   3,   "kPa"),
+    pidDescriptor(INTAKE_MANIFOLD_ABS_PRESSURE,   1, 0,   1,   1,   "kPa"),
+    pidDescriptor(ENGINE_RPM,                     2, 0,   4,   1,   "rpm"),
+    pidDescriptor(VEHICLE_SPEED,                  1, 0,   1,   1,   "km/h"),
+    pidDescriptor(TIMING_ADVANCE,                 1, 64,  2,   1,   "deg"),
+    pidDescriptor(INTAKE_AIR_TEMP,                1, 40,  1,   1,   "C"),
+    pidDescriptor(MAF_FLOW_RATE,                  2, 0,   100, 1,   "g/s"),
+    pidDescriptor(THROTTLE_POSITION,              1, 0,   255, 100, "%"),
+    pidDescriptor(RUN_TIME_SINCE_ENGINE_START,    2, 0,   1,   1,   "s"),
+    pidDescriptor(DISTANCE_TRAVELED_WITH_MIL_ON,  2, 0,   1,   1,   "km"),
+    pidDescriptor(FUEL_RAIL_PRESSURE,             2, 0,   1000, 79, "kPa"),
+    pidDescriptor(FUEL_RAIL_GUAGE_PRESSURE,       2, 0,   1,   10,  "kPa"),
+    pidDescriptor(COMMANDED_EGR,                  1, 0,   255, 100, "%"),
+    pidDescriptor(EGR_ERROR,                      1, 100, 128, 100, "%"),
+    pidDescriptor(COMMANDED_EVAPORATIVE_PURGE,    1, 0,   255, 100, "%"),
+    pidDescriptor(FUEL_TANK_LEVEL_INPUT,          1, 0,   255, 100, "%"),
+    pidDescriptor(WARM_UPS_SINCE_CODES_CLEARED,   1, 0,   1,   1,   "count"),
+    pidDescriptor(DIST_TRAV_SINCE_CODES_CLEARED,  2, 0,   1,   1,   "km"),
+    pidDescriptor(ABS_BAROMETRIC_PRESSURE,        1, 0,   1,   1,   "kPa"),
+    pidDescriptor(CATALYST_TEMP_BANK_1_SENSOR_1,  2, 40,  10,  1,   "C"),
+    pidDescriptor(CATALYST_TEMP_BANK_2_SENSOR_1,  2, 40,  10,  1,   "C"),
+    pidDescriptor(CATALYST_TEMP_BANK_1_SENSOR_2,  2, 40,  10,  1,   "C"),
+    pidDescriptor(CATALYST_TEMP_BANK_2_SENSOR_2,  2, 40,  10,  1,   "C"),
+    pidDescriptor(CONTROL_MODULE_VOLTAGE,         2, 0,   1000, 1,  "V"),
+    pidDescriptor(ABS_LOAD_VALUE,                 2, 0,   255, 100, "%"),
+    pidDescriptor(FUEL_AIR_COMMANDED_EQUIV_RATIO, 2, 0,   32768, 1, "ratio"),
+    pidDescriptor(RELATIVE_THROTTLE_POSITION,     1, 0,   255, 100, "%"),
+    pidDescriptor(AMBIENT_AIR_TEMP,               1, 40,  1,   1,   "C"),
+    pidDescriptor(ABS_THROTTLE_POSITION_B,        1, 0,   255, 100, "%"),
+    pidDescriptor(ABS_THROTTLE_POSITION_C,        1, 0,   255, 100, "%"),
+    pidDescriptor(ABS_THROTTLE_POSITION_D,        1, 0,   255, 100, "%"),
+    pidDescriptor(ABS_THROTTLE_POSITION_E,        1, 0,   255, 100, "%"),
+    pidDescriptor(ABS_THROTTLE_POSITION_F,        1, 0,   255, 100, "%"),
+    pidDescriptor(COMMANDED_THROTTLE_ACTUATOR,    1, 0,   255, 100, "%"),
+    pidDescriptor(TIME_RUN_WITH_MIL_ON,           2, 0,   1,   1,   "min"),
+    pidDescriptor(TIME_SINCE_CODES_CLEARED,       2, 0,   1,   1,   "min"),
+    pidDescriptor(ETHANOL_FUEL_PERCENT,           1, 0,   255, 100, "%"),
+    pidDescriptor(ABS_EVAP_SYS_VAPOR_PRESSURE,    2, 0,   200, 1,   "kPa"),
+    pidDescriptor(EVAP_SYS_VAPOR_PRESSURE,        2, 32767, 1, 1,   "Pa"),
+    pidDescriptor(FUEL_RAIL_ABS_PRESSURE,         2, 0,   1,   10,  "kPa"),
+    pidDescriptor(RELATIVE_ACCELERATOR_PEDAL_POS, 1, 0,   255, 100, "%"),
+    pidDescriptor(HYBRID_BATTERY_REMAINING_LIFE,  1, 0,   255, 100, "%"),
+    pidDescriptor(ENGINE_OIL_TEMP,                1, 40,  1,   1,   "C"),
+    pidDescriptor(FUEL_INJECTION_TIMING,          2, 210, 128, 1,   "deg"),
+    pidDescriptor(ENGINE_FUEL_RATE,               2, 0,   20,  1,   "L/h"),
+    pidDescriptor(DEMANDED_ENGINE_PERCENT_TORQUE, 1, 125, 1,   1,   "%"),
+    pidDescriptor(ACTUAL_ENGINE_TORQUE,           1, 125, 1,   1,   "%"),
+    pidDescriptor(ENGINE_REFERENCE_TORQUE,        2, 0,   1,   1,   "Nm"),
+    pidDescriptor(ODOMETER,                       4, 0,   10,  1,   "km"),
+};
+
+const uint8_t PidDescriptor::N_DESCRIPTORS = sizeof(PidDescriptor::TABLE) / sizeof(PidDescriptor::TABLE[0]);
+
+constexpr bool isSorted(const PidDescriptor *descriptors, uint8_t n) {
+    return n < 2 || (descriptors[0].pid < descriptors[1].pid && isSorted(descriptors + 1, n - 1));
+}
+
+// responseBytes does not reach past 0x9C
+constexpr bool matchesResponseBytes(const PidDescriptor *descriptors, uint8_t n) {
+    return n == 0 || ((descriptors[0].pid >= 0x9D || descriptors[0].numberOfBytes == responseBytes[descriptors[0].pid]) &&
+                      matchesResponseBytes(descriptors + 1, n - 1));
+}
+
+static_assert(isSorted(PidDescriptor::TABLE, sizeof(PidDescriptor::TABLE) / sizeof(PidDescriptor::TABLE[0])),
+              "PID descriptor table must be sorted by pid");
+static_assert(matchesResponseBytes(PidDescriptor::TABLE, sizeof(PidDescriptor::TABLE) / sizeof(PidDescriptor::TABLE[0])),
+              "PID descriptor lengths must match responseBytes");
+
+const PidDescriptor *PidDescriptor::find(uint8_t pid) {
+    uint8_t first = 0, last = N_DESCRIPTORS;
+    while (first < last) {
+        uint8_t mid = (first + last) / 2;
+        if (TABLE[mid].pid < pid) {
+            first = mid + 1;
+        } else {
+            last = mid;
+        }
+    }
+    return (first < N_DESCRIPTORS && TABLE[first].pid == pid) ? &TABLE[first] : nullptr;
+}
+
+uint32_t PidDescriptor::getMaxRaw() const {
+    return pidMaxRaw(numberOfBytes);
+}
+
+uint32_t PidDescriptor::encode(float value) const {
+    if (!(value > min)) { // NaN too
+        return 0;
+    }
+    if (value >= max) {
+        return getMaxRaw();
+    }
+    return encodeFixed((int64_t)(value * 65536.0f));
+}
+
+uint32_t PidDescriptor::encodeFixed(int64_t valueQ16) const {
+    int64_t shifted = valueQ16 + offsetQ16;
+    if (shifted <= 0) {
+        return 0;
+    }
+    if ((uint64_t)shifted >= rangeQ16) {
+        return getMaxRaw();
+    }
+    // shifted * scaleQ16 < maxRaw << 32, rounded to the nearest raw value
+    return (uint32_t)(((uint64_t)shifted * scaleQ16 + 0x80000000UL) >> 32);
+}
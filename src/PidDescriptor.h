@@ -0,0 +1,72 @@
+#ifndef ELMulator_PidDescriptor_h
+#define ELMulator_PidDescriptor_h
+
+#include <stdint.h>
+#include "definitions.h"
+
+/**
+ * SAE J1979 definition of a mode 01 pid with a linear formula:
+ * raw = (value + offset) * scale, value in engineering units (ex: rpm),
+ * raw the A/B/C/D bytes of the response.
+ *
+ * The scale is kept as 16.16 fixed point and all limits are computed at
+ * compile time, so encoding a value is one float to fixed conversion and
+ * integer math.
+ */
+struct PidDescriptor
+{
+    uint8_t pid;
+    uint8_t numberOfBytes;
+    int32_t offsetQ16;  // offset << 16
+    uint32_t scaleQ16;  // raw units per engineering unit, 16.16 fixed point
+    uint64_t rangeQ16;  // (max - min) << 16, values over it encode as the max raw value
+    float min;          // engineering units
+    float max;
+    const char *unit;
+
+    // Table of all descriptors, sorted by pid
+    static const PidDescriptor TABLE[];
+    static const uint8_t N_DESCRIPTORS;
+
+    // nullptr if the pid has no linear formula (ex: bit encoded)
+    static const PidDescriptor *find(uint8_t pid);
+
+    // Raw response value for value, clamped to [min, max]
+    uint32_t encode(float value) const;
+
+    // Same as encode for a 16.16 fixed point value
+    uint32_t encodeFixed(int64_t valueQ16) const;
+
+    uint32_t getMaxRaw() const;
+};
+
+constexpr uint32_t pidMaxRaw(uint8_t numberOfBytes)
+{
+    return numberOfBytes >= 4 ? 0xFFFFFFFFUL : (1UL << (8 * numberOfBytes)) - 1;
+}
+
+constexpr uint32_t pidScaleQ16(uint32_t num, uint32_t den)
+{
+    return (uint32_t)((((uint64_t)num << 16) + den / 2) / den);
+}
+
+constexpr uint64_t pidRangeQ16(uint8_t numberOfBytes, uint32_t scaleQ16)
+{
+    return ((uint64_t)pidMaxRaw(numberOfBytes) << 32) / scaleQ16;
+}
+
+/**
+ * Descriptor of pid where value = raw * den / num - offset
+ * (ex: rpm = (256A + B) / 4 -> pidDescriptor(ENGINE_RPM, 2, 0, 4, 1, "rpm"))
+ */
+constexpr PidDescriptor pidDescriptor(uint8_t pid, uint8_t numberOfBytes, int16_t offset,
+                                      uint32_t num, uint32_t den, const char *unit)
+{
+    return PidDescriptor{pid, numberOfBytes, (int32_t)offset * 65536, pidScaleQ16(num, den),
+                         pidRangeQ16(numberOfBytes, pidScaleQ16(num, den)),
+                         (float)-offset,
+                         (float)pidRangeQ16(numberOfBytes, pidScaleQ16(num, den)) / 65536.0f - offset,
+                         unit};
+}
+
+#endif
@@ -1,47 +1,161 @@
 #include "PidProcessor.h"
 
-#if USE_WIFI
-PidProcessor::PidProcessor(OBDWiFiComm *connection) {
+PidProcessor::PidProcessor(OBDComm *connection) {
     _connection = connection;
-    resetPidMode01Array();
-};
-#else
-PidProcessor::PidProcessor(OBDSerialComm *connection) {
-    _connection = connection;
-    resetPidMode01Array();
+    for (uint8_t i = 0; i < N_SUPPORTED_PID_SERVICES; i++) {
+        supportedPids[i].clear();
+    }
+    resetResponseCache();
+    for (uint16_t i = 0; i <= maxPid; i++) {
+        mode01Handlers[i].value = nullptr;
+        mode01Descriptors[i] = NO_DESCRIPTOR;
+    }
+    nModePidHandlers = 0;
+    _sampler = nullptr;
+    _dtcStore = nullptr;
+    _vehicleInfo = nullptr;
+    _freezeFrames = nullptr;
+    _ecuTable = nullptr;
+    _valueSource = nullptr;
+    _valueSourceContext = nullptr;
+    _connection->setFormatResetListener(onFormatReset, this);
 };
-#endif
 
 
-bool PidProcessor::process(String& command) {
+bool PidProcessor::process(ELMRequest& request) {
     bool processed = false;
-    
-    if (command.length() > 4)
-    {
-        command = command.substring(0, 4); // remove num_responses value if present; lib only handles single responses
+
+    if (routeRequest(request)) {
+        return true;
+    }
+
+    // mode 09 and 22 pids registered with a handler
+    ModePidHandler *modeHandler = findModePidHandler(request.mode, request.pid);
+    if (modeHandler != nullptr && request.pidBytes > 0) {
+        ELM_STATS_MARK(DISPATCH);
+        writePidResponse(request, modeHandler->numberOfBytes, modeHandler->handler(request.pid));
+        return true;
+    }
+
+    if (_vehicleInfo != nullptr && processVehicleInfoRequest(request)) {
+        return true;
     }
 
-    if (!isMode01(command) & !isMode22(command))
+    if (_freezeFrames != nullptr && processFreezeFrameRequest(request)) {
+        return true;
+    }
+
+    SupportedPids *supported = getSupportedPidTable(request.mode);
+    if (supported != nullptr && request.pidCount > 0) {
+
+        // only registered pids are answered (ex: 010C0D -> 010C if 0D is not registered)
+        uint8_t nPids = 0;
+        for (uint8_t i = 0; i < request.pidCount; i++) {
+            uint8_t pid = request.pids[i];
+            if (SupportedPids::isQuery(pid) || supported->isSupported(pid)) {
+                request.pids[nPids++] = pid;
+            }
+        }
+        if (nPids == 0) {
+            _connection->writeEndNoData();
+            return true;
+        }
+        if (nPids < request.pidCount) {
+            request.setPids(request.pids, nPids);
+        }
+
+        // support queries (ex: 0100, 0100204060, 0900) and mode 01 pids with a value,
+        // anything else in the request is left to the user
+        ELM_STATS_MARK(DISPATCH);
+        uint32_t values[MAX_PIDS_PER_REQUEST];
+        for (uint8_t i = 0; i < request.pidCount; i++) {
+            uint8_t pid = request.pids[i];
+            if (SupportedPids::isQuery(pid)) {
+                values[i] = supported->getBitmap(pid);
+            } else if (!request.isMode(SERVICE_01) || !getPidValue(pid, values[i])) {
+                break;
+            }
+            if (i == request.pidCount - 1) {
+                writePidResponse(request, values);
+                return true;
+            }
+        }
+    }
+
+    if (_dtcStore != nullptr && processDtcRequest(request)) {
+        return true;
+    }
+
+    // modes 01, 03 and 22 are answered by the user, reject anything else here
+    if (!request.isMode(SERVICE_01) && !request.isMode(SERVICE_03) && !request.isMode(SERVICE_22))
     {
         _connection->writeEndNoData();
-        return false;
+        return true;
     }
+    return processed;
+}
 
-    uint16_t hexCommand = strtoul(command.c_str(), NULL, HEX);
-    uint8_t pid = getPidCodeFromHex(hexCommand);
-    if (isSupportedPidRequest(pid)) {   //reqeust to return a list of valid PIDs we can respond to 
-        processed = true;
-        uint32_t supportedPids = getSupportedPids(pid);
-        writePidResponse(command, 4, supportedPids);
+/**
+ * Responses are cached already rendered (spaces, line feeds, prompt), so polling
+ * a PID whose value did not change is a single write. An entry is only reused
+ * if the value and the connection format version (ATS, ATL, ATH, ...) still match.
+ */
+void PidProcessor::writePidResponse(const ELMRequest& request, uint8_t numberOfBytes, uint32_t value) {
+    ELM_STATS_MARK(HANDLER);
+    uint16_t formatVersion = _connection->getFormatVersion();
+    CachedResponse& entry = responseCache[(request.mode ^ request.pid) % RESPONSE_CACHE_SIZE];
+    if (entry.length && entry.mode == request.mode && entry.pid == request.pid &&
+        entry.numberOfBytes == numberOfBytes && entry.value == value && entry.formatVersion == formatVersion) {
+        _connection->writeEndFormatted(entry.formatted);
+        return;
     }
-    return processed;
+
+    uint8_t nHexChars = (1 + request.pidBytes + numberOfBytes) * N_CHARS_IN_BYTE;
+    char responseArray[nHexChars + 1]; // one more for termination char
+    getFormattedResponse(responseArray, request, numberOfBytes, value);
+
+    entry.length = _connection->formatPidResponse(responseArray, entry.formatted, RESPONSE_CACHE_ENTRY_SIZE);
+    if (entry.length) {
+        entry.mode = request.mode;
+        entry.pid = request.pid;
+        entry.numberOfBytes = numberOfBytes;
+        entry.value = value;
+        entry.formatVersion = formatVersion;
+        _connection->writeEndFormatted(entry.formatted);
+    } else {
+        _connection->writeEndPidTo(responseArray); // multi frame or too long to cache
+    }
+}
+
+void PidProcessor::writePidResponse(const ELMRequest& request, const uint32_t values[]) {
+    ELM_STATS_MARK(HANDLER);
+    if (request.pidCount == 1) {
+        writePidResponse(request, getNumberOfBytes(request.pids[0]), values[0]);
+        return;
+    }
+
+    // 41 + (pid + value bytes) for each pid
+    uint16_t nBytes = 1;
+    for (uint8_t i = 0; i < request.pidCount; i++) {
+        nBytes += 1 + getNumberOfBytes(request.pids[i]);
+    }
+
+    char responseArray[nBytes * N_CHARS_IN_BYTE + 1];
+    uint16_t pos = writeHexBytes(responseArray, 0, request.mode + 0x40, 1);
+    for (uint8_t i = 0; i < request.pidCount; i++) {
+        pos = writeHexBytes(responseArray, pos, request.pids[i], 1);
+        pos = writeHexBytes(responseArray, pos, values[i], getNumberOfBytes(request.pids[i]));
+    }
+    responseArray[pos] = '\0';
+    ELM_LOG_TRACE("Response %s", (const char *)responseArray); // variable length array
+
+    _connection->writeEndPidTo(responseArray); // multi frame if longer than SINGLE_FRAME_MAX_BYTES
 }
 
 void PidProcessor::writePidResponse(const String& requestPid, uint8_t numberOfBytes, uint32_t value) {
-    uint8_t  nHexChars = PID_N_BYTES * N_CHARS_IN_BYTE +  numberOfBytes * N_CHARS_IN_BYTE ;
-    char responseArray[nHexChars + 1]; // one more for termination char
-    getFormattedResponse(responseArray, nHexChars, requestPid, value);
-    _connection->writeEndPidTo(responseArray);
+    ELMRequest request;
+    request.parse(requestPid.c_str(), requestPid.length());
+    writePidResponse(request, numberOfBytes, value);
 }
 
 /**
@@ -52,16 +166,386 @@ bool PidProcessor::registerMode01Pid(uint32_t pid) {
     if (pid > 0x00 && pid < 0x0200) {
         // remove PidMode, only use pid code
         pid = getPidCodeFromHex(pid);
-        setPidBit(pid);
+        registerPid(SERVICE_01, pid);
+
+        ELM_LOG_INFO("Registered PID: %02X", pid);
+        return true;
+    }
+    return false;
+}
+
+bool PidProcessor::registerPid(uint8_t mode, uint8_t pid) {
+    SupportedPids *supported = getSupportedPidTable(mode);
+    if (supported == nullptr || pid == 0) {
+        return false;
+    }
+    supported->add(pid);
+    return true;
+}
+
+bool PidProcessor::registerPids(uint8_t mode, const SupportedPids &pids) {
+    SupportedPids *supported = getSupportedPidTable(mode);
+    if (supported == nullptr) {
+        return false;
+    }
+    supported->add(pids);
+    return true;
+}
+
+bool PidProcessor::isRegisteredPid(uint8_t mode, uint8_t pid) {
+    SupportedPids *supported = getSupportedPidTable(mode);
+    return supported != nullptr && supported->isSupported(pid);
+}
+
+SupportedPids *PidProcessor::getSupportedPidTable(uint8_t mode) {
+    switch (mode) {
+    case SERVICE_01:
+        return &supportedPids[0];
+    case SERVICE_02:
+        return &supportedPids[1];
+    case SERVICE_05:
+        return &supportedPids[2];
+    case SERVICE_06:
+        return &supportedPids[3];
+    case SERVICE_09:
+        return &supportedPids[4];
+    default:
+        return nullptr;
+    }
+}
+
+bool PidProcessor::registerMode01Pid(uint32_t pid, PidHandler handler) {
+    if (!registerMode01Pid(pid)) {
+        return false;
+    }
+    uint8_t pidCode = getPidCodeFromHex(pid);
+    mode01Handlers[pidCode].value = handler;
+    mode01Descriptors[pidCode] = NO_DESCRIPTOR;
+    return true;
+}
+
+bool PidProcessor::registerMode01Pid(uint32_t pid, SensorHandler handler) {
+    const PidDescriptor *descriptor = PidDescriptor::find(getPidCodeFromHex(pid));
+    if (descriptor == nullptr || handler == nullptr || !registerMode01Pid(pid)) {
+        return false;
+    }
+    uint8_t pidCode = getPidCodeFromHex(pid);
+    mode01Handlers[pidCode].sensor = handler;
+    mode01Descriptors[pidCode] = descriptor - PidDescriptor::TABLE;
+    return true;
+}
+
+/**
+ * Registering the same mode and pid again replaces its handler
+ */
+bool PidProcessor::registerModePid(uint8_t mode, uint16_t pid, uint8_t numberOfBytes, PidHandler handler) {
+    if ((mode != SERVICE_09 && mode != SERVICE_22) || handler == nullptr) {
+        return false;
+    }
+
+    ModePidHandler *entry = findModePidHandler(mode, pid);
+    if (entry == nullptr) {
+        if (nModePidHandlers == MAX_MODE_PID_HANDLERS) {
+            return false;
+        }
+        entry = &modePidHandlers[nModePidHandlers++];
+    }
+    entry->mode = mode;
+    entry->pid = pid;
+    entry->numberOfBytes = numberOfBytes;
+    entry->handler = handler;
+    if (pid <= maxPid) {
+        registerPid(mode, pid); // listed in the 0900 answer
+    }
+    return true;
+}
+
+PidProcessor::ModePidHandler *PidProcessor::findModePidHandler(uint8_t mode, uint16_t pid) {
+    for (uint8_t i = 0; i < nModePidHandlers; i++) {
+        if (modePidHandlers[i].mode == mode && modePidHandlers[i].pid == pid) {
+            return &modePidHandlers[i];
+        }
+    }
+    return nullptr;
+}
+
+bool PidProcessor::getPidValue(uint8_t pid, uint32_t &value) {
+    if (isSupportedPidRequest(pid)) {
+        value = getSupportedPids(pid);
+        return true;
+    }
+    if (_sampler != nullptr && _sampler->getValue(pid, value)) {
+        return true;
+    }
+    if (mode01Descriptors[pid] != NO_DESCRIPTOR) {
+        value = PidDescriptor::TABLE[mode01Descriptors[pid]].encode(mode01Handlers[pid].sensor(pid));
+        return true;
+    }
+    if (mode01Handlers[pid].value != nullptr) {
+        value = mode01Handlers[pid].value(pid);
+        return true;
+    }
+    if (pid == MONITOR_STATUS_SINCE_DTC_CLEARED && _dtcStore != nullptr) {
+        value = _dtcStore->getMonitorStatus();
+        return true;
+    }
+    return false;
+}
+
+void PidProcessor::setSampler(SensorSampler *sampler) {
+    _sampler = sampler;
+}
+
+void PidProcessor::setValueSource(ValueSource source, void *context) {
+    _valueSource = source;
+    _valueSourceContext = context;
+}
+
+DtcStore &PidProcessor::getDtcStore() {
+    if (_dtcStore == nullptr) {
+        _dtcStore = new DtcStore();
+        registerPid(SERVICE_01, MONITOR_STATUS_SINCE_DTC_CLEARED);
+        if (_freezeFrames != nullptr) {
+            _dtcStore->setStoredListener(onDtcStored, this);
+        }
+    }
+    return *_dtcStore;
+}
+
+FreezeFrames &PidProcessor::getFreezeFrames() {
+    if (_freezeFrames == nullptr) {
+        _freezeFrames = new FreezeFrames();
+        getDtcStore().setStoredListener(onDtcStored, this);
+    }
+    return *_freezeFrames;
+}
 
-        char buffer[4];
-        sprintf(buffer, "%02X", pid);
-        DEBUG("Registered PID: " + String(buffer ));
+EcuTable &PidProcessor::getEcuTable() {
+    if (_ecuTable == nullptr) {
+        _ecuTable = new EcuTable();
+    }
+    return *_ecuTable;
+}
+
+/**
+ * Other ECUs answer before this one, a functional request ends with the
+ * response of this ECU (or only the prompt if it has none, see writeEndNoData)
+ */
+bool PidProcessor::routeRequest(const ELMRequest& request) {
+    uint16_t requestId = _connection->getRequestHeader();
+    bool functional = requestId == FUNCTIONAL_REQUEST_ID;
+    if (_ecuTable == nullptr) {
+        if (_connection->isReceived(_connection->getResponseHeader())) {
+            return false;
+        }
+        _connection->writeEndNoData();
+        return true;
+    }
+    if (!functional && requestId == ENGINE_REQUEST_ID) {
+        return false;
+    }
+
+    uint8_t payload[ECU_RESPONSE_SIZE];
+    int8_t target = functional ? -1 : _ecuTable->find(requestId);
+    for (uint8_t ecu = 0; ecu < _ecuTable->getCount(); ecu++) {
+        if (!functional && ecu != target) {
+            continue;
+        }
+        uint16_t responseId = _ecuTable->getResponseId(ecu);
+        uint8_t length = _connection->isReceived(responseId) ? _ecuTable->getResponse(ecu, request, payload) : 0;
+        if (length > 0) {
+            ELM_STATS_MARK(HANDLER);
+            _connection->beginEcuResponse(responseId);
+            _connection->writeEndPayload(payload, length);
+        }
+    }
+    if (functional && _connection->isReceived(ENGINE_REQUEST_ID + RESPONSE_ID_OFFSET)) {
+        return false;
+    }
+    _connection->writeEndNoData(); // only the prompt if an ECU answered
+    return true;
+}
+
+void PidProcessor::onDtcStored(uint16_t dtc, void *context) {
+    static_cast<PidProcessor *>(context)->captureFreezeFrame(dtc);
+}
+
+void PidProcessor::onFormatReset(void *context) {
+    PidProcessor *processor = static_cast<PidProcessor *>(context);
+    processor->resetResponseCache();
+    if (processor->_vehicleInfo != nullptr) {
+        processor->_vehicleInfo->resetFormatted();
+    }
+}
+
+/**
+ * The layout is built from the supported pid table by the first capture after
+ * a clear, later captures only read the values and copy their bytes
+ */
+bool PidProcessor::captureFreezeFrame(uint16_t dtc) {
+    FreezeFrames &frames = getFreezeFrames();
+    if (frames.getCount() == 0 && frames.getPidCount() == 0) {
+        for (uint16_t pid = FREEZE_DTC + 1; pid <= maxPid; pid++) {
+            if (!SupportedPids::isQuery(pid) && supportedPids[0].isSupported(pid)) {
+                frames.addPid(pid, getNumberOfBytes(pid));
+            }
+        }
+    }
+    uint8_t *values = frames.startFrame(dtc);
+    if (values == nullptr) {
+        return false;
+    }
+    for (uint8_t i = 0; i < frames.getPidCount(); i++) {
+        uint8_t pid = frames.getPid(i);
+        uint8_t numberOfBytes = frames.getNumberOfBytes(pid);
+        uint32_t value = 0;
+        bool found = _valueSource != nullptr ? _valueSource(pid, value, _valueSourceContext) : getPidValue(pid, value);
+        if (!found) {
+            value = 0;
+        }
+        for (uint8_t byte = 0; byte < numberOfBytes; byte++) {
+            *values++ = value >> (8 * (numberOfBytes - 1 - byte));
+        }
+    }
+    frames.endFrame();
+    return true;
+}
+
+/**
+ * Mode 02 requests have a pid and a frame number (ex: 020C00)
+ */
+bool PidProcessor::processFreezeFrameRequest(const ELMRequest& request) {
+    if (!request.isMode(SERVICE_02) || request.pidBytes != 1) {
+        return false;
+    }
+    ELM_STATS_MARK(DISPATCH);
+    uint8_t payload[7];
+    uint8_t length = _freezeFrames->getResponse(request.pids[0], request.frame, payload);
+    if (length > 0) {
+        _connection->writeEndPayload(payload, length);
+    } else {
+        _connection->writeEndNoData();
+    }
+    return true;
+}
+
+VehicleInfo &PidProcessor::getVehicleInfo() {
+    if (_vehicleInfo == nullptr) {
+        _vehicleInfo = new VehicleInfo(getSupportedPidTable(SERVICE_09));
+    }
+    return *_vehicleInfo;
+}
+
+/**
+ * Vehicle info responses are long (a VIN is 5 frames) and never change, so they
+ * are rendered once per format version and then written as is
+ */
+bool PidProcessor::processVehicleInfoRequest(const ELMRequest& request) {
+    if (!request.isMode(SERVICE_09) || request.pidCount != 1) {
+        return false;
+    }
+    VehicleInfo::Entry *entry = _vehicleInfo->find(request.pids[0]);
+    if (entry == nullptr) {
+        return false;
+    }
+    ELM_STATS_MARK(DISPATCH);
+    uint16_t formatVersion = _connection->getFormatVersion();
+    if (entry->formatVersion != formatVersion) {
+        entry->formattedLength = _connection->formatPayload(entry->payload, entry->length, entry->formatted, sizeof(entry->formatted));
+        entry->formatVersion = formatVersion;
+    }
+    if (entry->formattedLength > 0) {
+        _connection->writeEndFormatted(entry->formatted);
+    } else {
+        _connection->writeEndPayload(entry->payload, entry->length);
+    }
+    return true;
+}
+
+/**
+ * The payloads are kept ready in the store, a request only copies one
+ */
+bool PidProcessor::processDtcRequest(const ELMRequest& request) {
+    if (request.pidBytes > 0) {
+        return false;
+    }
+    DtcStore::LIST list;
+    if (DtcStore::getList(request.mode, list)) {
+        uint8_t payload[DTC_RESPONSE_SIZE];
+        uint8_t length = _dtcStore->getResponse(list, payload);
+        _connection->writeEndPayload(payload, length);
+        return true;
+    }
+    if (request.isMode(SERVICE_04)) {
+        _dtcStore->clear();
+        if (_freezeFrames != nullptr) {
+            _freezeFrames->clear();
+        }
+        const uint8_t payload[] = {SERVICE_04 + 0x40};
+        _connection->writeEndPayload(payload, sizeof(payload));
         return true;
     }
     return false;
 }
 
+/**
+ * Reads the hex bytes of one line of text (spaces are skipped) into bytes,
+ * text is moved to the start of the next line
+ */
+static uint8_t readHexLine(const char *&text, uint8_t *bytes, uint8_t size) {
+    uint8_t nBytes = 0;
+    uint8_t nDigits = 0;
+    uint8_t byte = 0;
+    for (; *text != '\0' && *text != '\r' && *text != '\n'; text++) {
+        uint8_t digit = HexCodec::decodeDigit(*text);
+        if (digit == HexCodec::INVALID) {
+            continue;
+        }
+        byte = (byte << 4) | digit;
+        if (++nDigits % 2 == 0 && nBytes < size) {
+            bytes[nBytes++] = byte;
+        }
+    }
+    while (*text == '\r' || *text == '\n') {
+        text++;
+    }
+    return nBytes;
+}
+
+bool PidProcessor::registerMode01MILResponse(const String& response) {
+    const char *text = response.c_str();
+    uint8_t bytes[6] = {0};
+    if (readHexLine(text, bytes, sizeof(bytes)) < 3 || bytes[0] != SERVICE_01 + 0x40 ||
+        bytes[1] != MONITOR_STATUS_SINCE_DTC_CLEARED) {
+        return false;
+    }
+    DtcStore &store = getDtcStore();
+    store.setMil(bytes[2] & 0x80);
+    store.setMonitorStatus(((uint32_t)bytes[3] << 16) | (bytes[4] << 8) | bytes[5]);
+    return true;
+}
+
+bool PidProcessor::registerMode03Response(const String& response) {
+    DtcStore &store = getDtcStore();
+    const char *text = response.c_str();
+    bool added = false;
+    while (*text != '\0') {
+        uint8_t bytes[DTC_RESPONSE_SIZE];
+        uint8_t nBytes = readHexLine(text, bytes, sizeof(bytes));
+        if (nBytes == 0 || bytes[0] != SERVICE_03 + 0x40) {
+            continue;
+        }
+        uint8_t nCodes = nBytes > 1 ? bytes[1] : 0;
+        for (uint8_t i = 2; i + 1 < nBytes && nCodes > 0; i += 2, nCodes--) {
+            uint16_t dtc = (bytes[i] << 8) | bytes[i + 1];
+            if (dtc != 0) {
+                added = store.add(dtc) || added;
+            }
+        }
+    }
+    return added;
+}
+
 bool PidProcessor::isMode01(const String& command) 
 {
     return command.startsWith("01") ? true : false;
@@ -85,28 +569,14 @@ bool PidProcessor::isMode22(const String& command)
 
 /**
  *  return true if:
- *  - 1000
- *  - 1020
- *  - 1040
- *  - 1060
+ *  - 0100
+ *  - 0120
+ *  - 0140
+ *  - 0160
  *  ....
  */
 bool PidProcessor::isSupportedPidRequest(uint8_t pid) {
-    return pid == getPidIntervalId(pid);
-}
-
-/**
- * returns the interval RANGEID for the given pid (ex: 00, 20, 40, ...)
- */
-uint8_t PidProcessor::getPidIntervalId(uint8_t pidcode) {
-    return getPidIntervalIndex(pidcode) * PID_INTERVAL_OFFSET;
-}
-
-/**
- * returns the interval INDEX for the given pid (0,1,2,3,4,...)
- */
-uint8_t PidProcessor::getPidIntervalIndex(uint8_t pidcode) {
-    return pidcode / PID_INTERVAL_OFFSET;
+    return SupportedPids::isQuery(pid);
 }
 
 /**
@@ -126,70 +596,56 @@ uint8_t PidProcessor::getPidCodeFromHex(uint16_t hexCommand) {
  * returns only the pid ex 0C
  */
 uint8_t PidProcessor::getPidCodeFromRequest(const String& request) {
-    uint16_t hexCommand = strtoul(request.c_str(), NULL, HEX);
-    return getPidCodeFromHex(hexCommand);
+    ELMRequest parsed;
+    parsed.parse(request.c_str(), request.length());
+    return (uint8_t) parsed.pid;
 }
 
-
-void PidProcessor::setPidBit(uint8_t pid) {
-    uint8_t arrayIndex = getPidIntervalIndex(pid);
-    if(isSupportedPidRequest(pid)) {
-        arrayIndex -= 1;
-    }
-
-    uint8_t bitPosition = getPidBitPosition(pid);
-    bitWrite(pidMode01Supported[arrayIndex], bitPosition, 1);
-
-    // mark available intervals
-    for (int i = 0; i < arrayIndex; i++) {
-        bitWrite(pidMode01Supported[i], 0, 1);
-    }
+uint32_t PidProcessor::getSupportedPids(uint8_t pid) {
+    return supportedPids[0].getBitmap(pid);
 }
 
-uint8_t PidProcessor::getPidBitPosition(uint8_t pid) {
-    uint8_t intervalId = getPidIntervalId(pid) ;
-    if(isSupportedPidRequest(pid)) {
-        intervalId -= PID_INTERVAL_OFFSET;
+uint8_t PidProcessor::getNumberOfBytes(uint8_t pid) {
+    if (isSupportedPidRequest(pid)) {
+        return 4;
     }
-
-    uint16_t pos = pid - intervalId;
-    pos = PID_INTERVAL_OFFSET - pos;
-    return pos;
-}
-
-
-uint32_t PidProcessor:: getSupportedPids(uint8_t pid) {
-    uint8_t index = getPidIntervalIndex(pid);
-    return pidMode01Supported[index];
+    if (pid < sizeof(responseBytes) && responseBytes[pid] != 0) {
+        return responseBytes[pid];
+    }
+    // responseBytes stops at 0x9C (ex: odometer)
+    const PidDescriptor *descriptor = PidDescriptor::find(pid);
+    return descriptor != nullptr ? descriptor->numberOfBytes : 4;
 }
 
-void PidProcessor::getFormattedResponse(char *response, uint8_t totalNumberOfChars, const String& pid, uint32_t value) {
-    uint8_t nValueChars = totalNumberOfChars - PID_N_BYTES * N_CHARS_IN_BYTE;
-    char cValue[3] = {0};
-    itoa(nValueChars, cValue, DEC);
-    String mask = "%s%0";
-    mask.concat(cValue);
-    mask.concat("lX\0");
-    String pidResponse = convertToPidResponse(pid);
-    sprintf(response, mask.c_str(), pidResponse.c_str(), value);
-
-    DEBUG("RX PID: " + pid + " - TX: " + String(response));
+/**
+ * Writes the response hex chars (ex: 410C1AF8) for the request into response,
+ * which must hold (1 + pidBytes + numberOfBytes) * 2 + 1 chars
+ */
+void PidProcessor::getFormattedResponse(char *response, const ELMRequest& request, uint8_t numberOfBytes, uint32_t value) {
+    uint16_t pos = 0;
+    pos = writeHexBytes(response, pos, request.mode + 0x40, 1);
+    pos = writeHexBytes(response, pos, request.pid, request.pidBytes);
+    pos = writeHexBytes(response, pos, value, numberOfBytes);
+    response[pos] = '\0';
+
+    ELM_LOG_TRACE("Response %s", response);
 }
 
-String PidProcessor::convertToPidResponse(String pid) {
-    String x = "4";
-    x.concat(pid.substring(1, pid.length()));
-    return x;
+/**
+ * Writes the nBytes lower bytes of value as hex chars at response[pos],
+ * bytes over the 4 of value are written as 00
+ * returns the position after the last written char
+ */
+uint16_t PidProcessor::writeHexBytes(char *response, uint16_t pos, uint32_t value, uint8_t nBytes) {
+    for (int16_t shift = (nBytes - 1) * 8; shift >= 0; shift -= 8) {
+        HexCodec::encodeByte((shift < 32) ? (uint8_t)(value >> shift) : 0, response + pos);
+        pos += 2;
+    }
+    return pos;
 }
 
-void PidProcessor::resetPidMode01Array() {
-    for(uint8_t i = 0; i < N_MODE01_INTERVALS; i++ ) {
-        pidMode01Supported[i] = 0x0;
+void PidProcessor::resetResponseCache() {
+    for (uint8_t i = 0; i < RESPONSE_CACHE_SIZE; i++) {
+        responseCache[i].length = 0;
     }
 }
-
-
-
-
-
-
@@ -5,23 +5,145 @@
 #include <Arduino.h>
 #include <WString.h>
 #include <Print.h>
-#include "OBDWiFiComm.h"
-#include "OBDSerialComm.h"
+#include "OBDComm.h"
+#include "ELMRequest.h"
+#include "SensorSampler.h"
+#include "SupportedPids.h"
+#include "PidDescriptor.h"
+#include "DtcStore.h"
+#include "VehicleInfo.h"
+#include "FreezeFrames.h"
+#include "EcuTable.h"
+#include "ELMLog.h"
+#include "ELMStats.h"
 
 class PidProcessor
 {
 
 public:
-    PidProcessor(OBDWiFiComm *connection);
-    PidProcessor(OBDSerialComm *connection);
-    bool process(String &string);
+    PidProcessor(OBDComm *connection);
+    /**
+     * Answers the requests that do not need the user: support queries, pids
+     * with a handler or a sample, unsupported modes and pids (NO DATA).
+     * Pids that are not registered are dropped from request, like an ECU would.
+     *
+     * @return true if the request was answered
+     */
+    bool process(ELMRequest &request);
+
+    // Returns the current value of a PID, called each time the PID is requested
+    typedef uint32_t (*PidHandler)(uint16_t pid);
+
+    // Same as PidHandler, in engineering units (ex: rpm), see PidDescriptor
+    typedef float (*SensorHandler)(uint16_t pid);
 
     bool registerMode01Pid(uint32_t pid);
 
+    // Adds pid to the supported pids of a service with a table (01, 02, 05, 06, 09)
+    bool registerPid(uint8_t mode, uint8_t pid);
+
+    // Adds all pids of a (constexpr) table to the supported pids of a service
+    bool registerPids(uint8_t mode, const SupportedPids &pids);
+
+    // true if pid is registered for mode, mode 22 pids are never in a table
+    bool isRegisteredPid(uint8_t mode, uint8_t pid);
+
+    /**
+     * Registers a mode 01 pid answered by handler, the number of bytes
+     * of the response comes from responseBytes
+     */
+    bool registerMode01Pid(uint32_t pid, PidHandler handler);
+
+    /**
+     * Registers a mode 01 pid answered by handler in engineering units,
+     * encoded with the pid descriptor
+     *
+     * @return false if the pid has no descriptor (see PidDescriptor::TABLE)
+     */
+    bool registerMode01Pid(uint32_t pid, SensorHandler handler);
+
+    // Registers a mode 09 or 22 pid answered by handler with numberOfBytes value bytes
+    bool registerModePid(uint8_t mode, uint16_t pid, uint8_t numberOfBytes, PidHandler handler);
+
+    /**
+     * Value for a mode 01 pid that is answered without the user sketch:
+     * supported pids bitmap (00, 20, ...), latest sample or a registered handler
+     *
+     * @return false if the pid has no handler
+     */
+    bool getPidValue(uint8_t pid, uint32_t &value);
+
+    // Answer the pids sampled by sampler from their latest sample
+    void setSampler(SensorSampler *sampler);
+
+    // Value of a mode 01 pid looked up outside PidProcessor, false if there is none
+    typedef bool (*ValueSource)(uint8_t pid, uint32_t &value, void *context);
+
+    /**
+     * Only one source, ELMulator uses it so a freeze frame holds the values
+     * a live request gets (handler, trace replay or simulator). Without it
+     * frames only have the values of getPidValue.
+     */
+    void setValueSource(ValueSource source, void *context);
+
+    /**
+     * Trouble codes answering modes 03, 07, 0A, 04 (clear) and pid 0101
+     * (unless it has a handler), created and registered on first use
+     */
+    DtcStore &getDtcStore();
+
+    /**
+     * Vehicle information answering mode 09 pids 02, 04, 06 and 0A (unless
+     * they have a handler), created on first use
+     */
+    VehicleInfo &getVehicleInfo();
+
+    /**
+     * Freeze frames answering mode 02, created on first use. Once created, a
+     * frame is captured each time a new code is stored in the DtcStore, and
+     * mode 04 clears them.
+     */
+    FreezeFrames &getFreezeFrames();
+
+    /**
+     * Captures the current values of the registered mode 01 pids as a new
+     * freeze frame, caused by dtc (0 if none, ex: on demand)
+     *
+     * @return false if the frames are full
+     */
+    bool captureFreezeFrame(uint16_t dtc = 0);
+
+    /**
+     * ECUs answering next to this one (the engine ECU), created on first use.
+     * Without it this ECU answers physical requests to any id (ATSH), with
+     * it only those to ENGINE_REQUEST_ID.
+     */
+    EcuTable &getEcuTable();
+
+    /**
+     * Sets the MIL and monitor bytes of pid 0101 from a response, missing
+     * bytes are 0 (ex: "4101830000" -> MIL on), the code count comes from the DtcStore
+     *
+     * @return false if response is not a 0101 response
+     */
     bool registerMode01MILResponse(const String &response);
 
+    /**
+     * Adds the codes of a hex encoded mode 03 response to the DtcStore,
+     * each line is 43, the number of codes and 2 bytes per code
+     * (ex: "43010341\r\n43010123" has P0341 and P0123), 0000 is padding
+     *
+     * @return false if response has no code
+     */
     bool registerMode03Response(const String &response);
 
+    void writePidResponse(const ELMRequest &request, uint8_t numberOfBytes, uint32_t value);
+
+    /**
+     * Respond to a (multi) pid mode 01 request in a single response,
+     * values[i] is the value for request.pids[i]
+     */
+    void writePidResponse(const ELMRequest &request, const uint32_t values[]);
     void writePidResponse(const String &requestPid, uint8_t numberOfBytes, uint32_t value);
 
     uint8_t getPidCodeFromHex(uint16_t hexCommand);
@@ -32,31 +154,102 @@ public:
     bool isMode03(const String &command);
     bool isMode22(const String &command);
 
-private:
-#if USE_WIFI
-    OBDWiFiComm *_connection;
-#else
-    OBDSerialComm *_connection;
-#endif
-    uint32_t pidMode01Supported[N_MODE01_INTERVALS];
-
+    // Mode 01 pids 00, 20, 40, ... return the supported pids bitmap
     bool isSupportedPidRequest(uint8_t pid);
 
+    // Mode 01 answer to the support query pidcode (00, 20, ... E0)
     uint32_t getSupportedPids(uint8_t pidcode);
 
-    uint8_t getPidIntervalId(uint8_t pidcode);
+    // number of value bytes in the response for a mode 01 pid
+    uint8_t getNumberOfBytes(uint8_t pid);
+
+private:
+    OBDComm *_connection;
+    // Supported pids of services 01, 02, 05, 06, 09 (see getSupportedPidTable)
+    SupportedPids supportedPids[N_SUPPORTED_PID_SERVICES];
+
+    SupportedPids *getSupportedPidTable(uint8_t mode);
+
+    // Mode 01 handlers, indexed by pid: sensor handlers have a descriptor
+    // in mode01Descriptors, value handlers NO_DESCRIPTOR
+    union Mode01Handler
+    {
+        PidHandler value;
+        SensorHandler sensor;
+    };
+
+    static const uint8_t NO_DESCRIPTOR = 0xFF;
+
+    Mode01Handler mode01Handlers[maxPid + 1];
+    uint8_t mode01Descriptors[maxPid + 1]; // index in PidDescriptor::TABLE
+
+    // Handlers for the other modes (09, 22), few and 16 bit pids so a plain list
+    struct ModePidHandler
+    {
+        uint8_t mode;
+        uint16_t pid;
+        uint8_t numberOfBytes;
+        PidHandler handler;
+    };
+
+    ModePidHandler modePidHandlers[MAX_MODE_PID_HANDLERS];
+    uint8_t nModePidHandlers;
+
+    SensorSampler *_sampler;
+
+    DtcStore *_dtcStore;
+
+    // Answers modes 03, 07, 0A and 04 from the DtcStore, false for other modes
+    bool processDtcRequest(const ELMRequest &request);
+
+    VehicleInfo *_vehicleInfo;
+
+    // Answers the mode 09 pids set in the VehicleInfo, false for anything else
+    bool processVehicleInfoRequest(const ELMRequest &request);
+
+    FreezeFrames *_freezeFrames;
+
+    // Answers mode 02 from the FreezeFrames, false for other modes
+    bool processFreezeFrameRequest(const ELMRequest &request);
+
+    ValueSource _valueSource;
+    void *_valueSourceContext;
+
+    static void onDtcStored(uint16_t dtc, void *context);
+
+    // the format versions were renumbered, drops every rendered response
+    static void onFormatReset(void *context);
+
+    EcuTable *_ecuTable;
+
+    /**
+     * Writes the responses of the other ECUs to request (see EcuTable)
+     *
+     * @return true if request was answered, false if this ECU answers it
+     */
+    bool routeRequest(const ELMRequest &request);
 
-    uint8_t getPidIntervalIndex(uint8_t pidcode);
+    ModePidHandler *findModePidHandler(uint8_t mode, uint16_t pid);
 
-    void setPidBit(uint8_t pid);
+    // Fully rendered response for a (mode, pid, value) at a given format version
+    struct CachedResponse
+    {
+        uint8_t mode;
+        uint16_t pid;
+        uint8_t numberOfBytes;
+        uint16_t formatVersion;
+        uint32_t value;
+        uint8_t length; // 0 == empty entry
+        char formatted[RESPONSE_CACHE_ENTRY_SIZE];
+    };
 
-    uint8_t getPidBitPosition(uint8_t pidcode);
+    CachedResponse responseCache[RESPONSE_CACHE_SIZE];
 
-    String convertToPidResponse(String pid);
+    void resetResponseCache();
 
-    void getFormattedResponse(char *response, uint8_t totalNumberOfChars, const String &pid, uint32_t value);
+    void getFormattedResponse(char *response, const ELMRequest &request, uint8_t numberOfBytes, uint32_t value);
 
-    void resetPidMode01Array();
+    uint16_t writeHexBytes(char *response, uint16_t pos, uint32_t value, uint8_t nBytes);
 };
 
 #endif // ELMulator_PIDPROCESSOR_H
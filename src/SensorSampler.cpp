@@ -0,0 +1,138 @@
+#include "SensorSampler.h"
+
+SensorSampler::SensorSampler() {
+    nEntries = 0;
+    running = false;
+    for (uint16_t i = 0; i <= maxPid; i++) {
+        slots[i] = NO_SLOT;
+    }
+}
+
+bool SensorSampler::addPid(uint8_t pid, Reader reader, uint32_t periodMs) {
+    if (reader == nullptr) {
+        return false;
+    }
+
+    uint8_t slot = slots[pid];
+    if (slot != NO_SLOT) {
+        entries[slot].reader = reader;
+        entries[slot].periodMs = periodMs;
+        return true;
+    }
+    if (nEntries == MAX_SAMPLED_PIDS) {
+        return false;
+    }
+
+    Entry &entry = entries[nEntries];
+    entry.pid = pid;
+    entry.reader = reader;
+    entry.periodMs = periodMs;
+    entry.lastRun = 0;
+    entry.sequence = 0;
+
+    // the entry must be complete before the sampler task can see it
+    __sync_synchronize();
+    slots[pid] = nEntries;
+    nEntries = nEntries + 1;
+    return true;
+}
+
+void SensorSampler::begin() {
+#if HAS_FREERTOS
+    if (!running) {
+        running = xTaskCreatePinnedToCore(taskLoop, "ELMSampler", SAMPLER_TASK_STACK_SIZE, this,
+                                          SAMPLER_TASK_PRIORITY, nullptr, SAMPLER_TASK_CORE) == pdPASS;
+    }
+#endif
+}
+
+void SensorSampler::update() {
+    if (!running) {
+        sample();
+    }
+}
+
+#if HAS_FREERTOS
+void SensorSampler::taskLoop(void *sampler) {
+    while (true) {
+        ((SensorSampler *)sampler)->sample();
+        vTaskDelay(1);
+    }
+}
+#endif
+
+void SensorSampler::sample() {
+    uint8_t n = nEntries;
+    for (uint8_t i = 0; i < n; i++) {
+        Entry &entry = entries[i];
+        uint32_t now = millis();
+        if (entry.sequence != 0 && now - entry.lastRun < entry.periodMs) {
+            continue;
+        }
+        entry.lastRun = now;
+        publish(entry, entry.reader(entry.pid));
+    }
+}
+
+/**
+ * Writes the sample that is not published, then publishes it
+ */
+void SensorSampler::publish(Entry &entry, uint32_t value) {
+    uint32_t next = entry.sequence + 1;
+    if (next == 0) {
+        next = 2; // 0 means never sampled, keep the same buffer parity
+    }
+
+    Sample &sample = entry.samples[next & 1];
+    sample.value = value;
+    sample.sampledAt = millis();
+
+    __sync_synchronize();
+    entry.sequence = next;
+}
+
+bool SensorSampler::readSample(uint8_t pid, Sample &sample) {
+    uint8_t slot = slots[pid];
+    if (slot == NO_SLOT) {
+        return false;
+    }
+
+    const Entry &entry = entries[slot];
+    uint32_t sequence;
+    do {
+        sequence = entry.sequence;
+        if (sequence == 0) {
+            return false;
+        }
+        __sync_synchronize();
+        sample = entry.samples[sequence & 1];
+        __sync_synchronize();
+    } while (sequence != entry.sequence);
+    return true;
+}
+
+bool SensorSampler::getValue(uint8_t pid, uint32_t &value) {
+    Sample sample;
+    if (!readSample(pid, sample)) {
+        return false;
+    }
+    value = sample.value;
+    return true;
+}
+
+uint32_t SensorSampler::getAge(uint8_t pid) {
+    Sample sample;
+    if (!readSample(pid, sample)) {
+        return UINT32_MAX;
+    }
+    return millis() - sample.sampledAt;
+}
+
+bool SensorSampler::isStale(uint8_t pid) {
+    uint8_t slot = slots[pid];
+    if (slot == NO_SLOT) {
+        return true;
+    }
+    uint32_t age = getAge(pid);
+    return age == UINT32_MAX || age > 2 * entries[slot].periodMs;
+}
@@ -0,0 +1,91 @@
+#ifndef ELMulator_SensorSampler_h
+#define ELMulator_SensorSampler_h
+
+#include <Arduino.h>
+#include "definitions.h"
+
+/**
+ * Samples slow sensors (ADC, I2C, GPS, ...) out of the request path.
+ *
+ * Each pid has a reader and a refresh period; readers are called from a
+ * background FreeRTOS task (ESP32) or from update() on other boards, and
+ * requests are answered with the latest sample in constant time.
+ *
+ * Every pid keeps two samples: the sampler writes the one not being
+ * published and then bumps the pid sequence, readers retry if the
+ * sequence changed while they were copying, so no lock is ever taken.
+ */
+class SensorSampler
+{
+public:
+    // Returns the current sensor value for a pid, same signature as ELMulator::PidHandler
+    typedef uint32_t (*Reader)(uint16_t pid);
+
+    SensorSampler();
+
+    /**
+     * Sample pid with reader every periodMs, registering the same pid again
+     * replaces its reader and period
+     *
+     * @return false if pid is out of range or MAX_SAMPLED_PIDS are already sampled
+     */
+    bool addPid(uint8_t pid, Reader reader, uint32_t periodMs);
+
+    // Starts the background task if the board has FreeRTOS, otherwise call update() often
+    void begin();
+
+    // Samples the pids that are due, does nothing while the background task runs
+    void update();
+
+    /**
+     * Latest sample of pid
+     *
+     * @return false if the pid is not sampled or has no sample yet
+     */
+    bool getValue(uint8_t pid, uint32_t &value);
+
+    // ms since the last sample of pid, UINT32_MAX if it was never sampled
+    uint32_t getAge(uint8_t pid);
+
+    // true if the last sample is older than twice the pid refresh period
+    bool isStale(uint8_t pid);
+
+private:
+    static const uint8_t NO_SLOT = 0xFF;
+
+    struct Sample
+    {
+        uint32_t value;
+        uint32_t sampledAt; // millis()
+    };
+
+    struct Entry
+    {
+        uint8_t pid;
+        Reader reader;
+        uint32_t periodMs;
+        uint32_t lastRun;            // only used by the sampler
+        Sample samples[2];           // published sample is samples[sequence & 1]
+        volatile uint32_t sequence;  // 0 == never sampled
+    };
+
+    Entry entries[MAX_SAMPLED_PIDS];
+    volatile uint8_t nEntries;
+
+    // entries index for each pid, NO_SLOT if not sampled
+    uint8_t slots[maxPid + 1];
+
+    bool running;
+
+    void sample();
+
+    void publish(Entry &entry, uint32_t value);
+
+    bool readSample(uint8_t pid, Sample &sample);
+
+#if HAS_FREERTOS
+    static void taskLoop(void *sampler);
+#endif
+};
+
+#endif
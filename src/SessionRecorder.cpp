@@ -0,0 +1,124 @@
+#include "SessionRecorder.h"
+
+SessionRecorder::SessionRecorder() {
+    head = 0;
+    tail = 0;
+    nextSequence = 1;
+    dropped = 0;
+#if HAS_FS
+    file = nullptr;
+    maxRecords = 0;
+    fileSlot = 0;
+    running = false;
+#endif
+}
+
+void SessionRecorder::record(DIRECTION direction, uint8_t session, const char *data, uint16_t length, uint32_t latencyUs) {
+    uint32_t sequence = nextSequence++;
+    if (head - tail >= RECORDER_RING_SIZE) {
+        dropped = dropped + 1;
+        return;
+    }
+
+    Record &record = ring[head & (RECORDER_RING_SIZE - 1)];
+    record.sequence = sequence;
+    record.timeUs = micros();
+    record.latencyUs = latencyUs;
+    record.length = length;
+    record.direction = direction;
+    record.session = session;
+    uint16_t kept = length < RECORDER_DATA_SIZE ? length : RECORDER_DATA_SIZE;
+    memcpy(record.data, data, kept);
+    memset(record.data + kept, 0, RECORDER_DATA_SIZE - kept);
+
+    // the record must be complete before the drain can see it
+    __sync_synchronize();
+    head = head + 1;
+}
+
+bool SessionRecorder::pop(Record &record) {
+    if (tail == head) {
+        return false;
+    }
+    __sync_synchronize();
+    record = ring[tail & (RECORDER_RING_SIZE - 1)];
+
+    // copied before record() may reuse the slot
+    __sync_synchronize();
+    tail = tail + 1;
+    return true;
+}
+
+uint32_t SessionRecorder::getDropped() {
+    return dropped;
+}
+
+#if HAS_FS
+static void writeU16(fs::File &file, uint16_t value) {
+    file.write((uint8_t)value);
+    file.write((uint8_t)(value >> 8));
+}
+
+static void writeU32(fs::File &file, uint32_t value) {
+    writeU16(file, value);
+    writeU16(file, value >> 16);
+}
+
+void SessionRecorder::begin(fs::File &file, uint32_t maxRecords) {
+    if (running || maxRecords == 0) {
+        return;
+    }
+    this->file = &file;
+    this->maxRecords = maxRecords;
+    fileSlot = 0;
+
+    file.seek(0);
+    file.write((const uint8_t *)"ELMR", 4);
+    writeU16(file, VERSION);
+    writeU16(file, RECORDER_RECORD_SIZE);
+    writeU32(file, maxRecords);
+    writeU32(file, 0);
+    file.flush();
+
+#if HAS_FREERTOS
+    running = xTaskCreatePinnedToCore(taskLoop, "ELMRecorder", RECORDER_TASK_STACK_SIZE, this,
+                                      RECORDER_TASK_PRIORITY, nullptr, RECORDER_TASK_CORE) == pdPASS;
+#endif
+}
+
+void SessionRecorder::update() {
+    if (!running) {
+        drain();
+    }
+}
+
+#if HAS_FREERTOS
+void SessionRecorder::taskLoop(void *recorder) {
+    while (true) {
+        ((SessionRecorder *)recorder)->drain();
+        vTaskDelay(pdMS_TO_TICKS(RECORDER_DRAIN_PERIOD_MS));
+    }
+}
+#endif
+
+void SessionRecorder::drain() {
+    if (file == nullptr) {
+        return;
+    }
+
+    Record record;
+    bool written = false;
+    while (pop(record)) {
+        if (fileSlot == maxRecords) {
+            fileSlot = 0; // overwrite the oldest records
+            file->seek(HEADER_SIZE);
+        }
+        file->write((const uint8_t *)&record, sizeof(record));
+        fileSlot++;
+        written = true;
+    }
+    if (written) {
+        file->flush();
+    }
+}
+#endif
@@ -0,0 +1,100 @@
+#ifndef ELMulator_SessionRecorder_h
+#define ELMulator_SessionRecorder_h
+
+#include <Arduino.h>
+#include "definitions.h"
+
+#if HAS_FS
+#include <FS.h>
+#endif
+
+/**
+ * Records every request and response with its timestamp, for field debugging
+ * under full load.
+ *
+ * The request path only copies a fixed size record into a RAM ring buffer,
+ * nothing is formatted or allocated; records are drained to a file by a
+ * background FreeRTOS task (ESP32), or by update() on other boards, or can
+ * be taken with pop() and sent anywhere. When the ring is full new records
+ * are dropped and counted, the request path never waits.
+ *
+ * The file holds a 16 byte header ("ELMR", u16 version, u16 record size,
+ * u32 max records, u32 reserved) followed by up to maxRecords records,
+ * overwritten from the first one when full; extras/session_decode.py puts
+ * them back in order.
+ */
+class SessionRecorder
+{
+public:
+    enum DIRECTION
+    {
+        RX = 0, // request from the client
+        TX = 1  // response to the client, echo included
+    };
+
+    // Written as is to the file, all fields little endian (ESP32 byte order)
+    struct Record
+    {
+        uint32_t sequence;  // gaps are dropped records
+        uint32_t timeUs;    // micros()
+        uint32_t latencyUs; // TX: since the request was received
+        uint16_t length;    // bytes sent/received, data keeps the first RECORDER_DATA_SIZE
+        uint8_t direction;
+        uint8_t session;    // client, see OBDTransport::getMaxSessions
+        uint8_t data[RECORDER_DATA_SIZE];
+    };
+
+    SessionRecorder();
+
+    /**
+     * Append a record, from the request path (one task only)
+     *
+     * @param latencyUs - for TX, time since the request was received
+     */
+    void record(DIRECTION direction, uint8_t session, const char *data, uint16_t length, uint32_t latencyUs = 0);
+
+    // Oldest record not drained yet, false if there is none
+    bool pop(Record &record);
+
+    // Records lost because the ring buffer was full
+    uint32_t getDropped();
+
+#if HAS_FS
+    /**
+     * Drain the records to file, opened for writing (ex: LittleFS.open("/session.elmr", FILE_WRITE)),
+     * keeping the last maxRecords. Starts the background task if the board has FreeRTOS.
+     */
+    void begin(fs::File &file, uint32_t maxRecords);
+
+    // Drains the records to the file, does nothing while the background task runs
+    void update();
+#endif
+
+private:
+    static const uint16_t VERSION = 1;
+    static const uint8_t HEADER_SIZE = 16;
+
+    Record ring[RECORDER_RING_SIZE];
+    volatile uint32_t head; // next record written, only changed by record()
+    volatile uint32_t tail; // next record drained, only changed by pop()
+    uint32_t nextSequence;
+    volatile uint32_t dropped;
+
+#if HAS_FS
+    fs::File *file;
+    uint32_t maxRecords;
+    uint32_t fileSlot; // next record position in the file
+    bool running;
+
+    void drain();
+
+#if HAS_FREERTOS
+    static void taskLoop(void *recorder);
+#endif
+#endif
+};
+
+static_assert(sizeof(SessionRecorder::Record) == RECORDER_RECORD_SIZE, "Record must not be padded");
+static_assert((RECORDER_RING_SIZE & (RECORDER_RING_SIZE - 1)) == 0, "RECORDER_RING_SIZE must be a power of 2");
+
+#endif
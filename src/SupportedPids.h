@@ -0,0 +1,113 @@
+#ifndef ELMulator_SupportedPids_h
+#define ELMulator_SupportedPids_h
+
+#include <stdint.h>
+#include "definitions.h"
+
+/**
+ * Supported pids of one service, stored as the answers to the support
+ * queries 00, 20, 40, ... E0: bitmaps[i] answers query i * 0x20, its bit 31
+ * is pid i * 0x20 + 1 and its bit 0 is pid (i + 1) * 0x20, which also means
+ * "the next query is supported".
+ *
+ * Tables known at compile time can be built with makeSupportedPids (ex:
+ * constexpr SupportedPids MY_PIDS = makeSupportedPids(ENGINE_RPM, VEHICLE_SPEED);)
+ * so they cost nothing at startup and live in flash.
+ */
+struct SupportedPids
+{
+    uint32_t bitmaps[N_SUPPORT_QUERIES];
+
+    // pid 00, 20, 40, ... asks for the supported pids
+    static constexpr bool isQuery(uint8_t pid)
+    {
+        return (pid & 0x1F) == 0;
+    }
+
+    // answer to the support query pid (00, 20, 40, ... E0)
+    constexpr uint32_t getBitmap(uint8_t queryPid) const
+    {
+        return bitmaps[queryPid >> 5];
+    }
+
+    constexpr bool isSupported(uint8_t pid) const
+    {
+        return pid != 0 && ((bitmaps[(pid - 1) >> 5] >> (31 - ((pid - 1) & 0x1F))) & 1);
+    }
+
+    void add(uint8_t pid)
+    {
+        if (pid == 0) {
+            return;
+        }
+        uint8_t index = (pid - 1) >> 5;
+        bitmaps[index] |= 1UL << (31 - ((pid - 1) & 0x1F));
+
+        // earlier queries announce this one
+        for (uint8_t i = 0; i < index; i++) {
+            bitmaps[i] |= 1UL;
+        }
+    }
+
+    void add(const SupportedPids &pids)
+    {
+        for (uint8_t i = 0; i < N_SUPPORT_QUERIES; i++) {
+            bitmaps[i] |= pids.bitmaps[i];
+        }
+    }
+
+    void clear()
+    {
+        for (uint8_t i = 0; i < N_SUPPORT_QUERIES; i++) {
+            bitmaps[i] = 0;
+        }
+    }
+};
+
+static_assert(N_SUPPORT_QUERIES == 8, "makeSupportedPids lists every bitmap");
+
+// bit(s) pid sets in bitmaps[index]
+constexpr uint32_t supportedPidBits(uint8_t index, uint8_t pid)
+{
+    return pid == 0 ? 0
+         : ((pid - 1) >> 5) == index ? (1UL << (31 - ((pid - 1) & 0x1F)))
+         : ((pid - 1) >> 5) > index ? 1UL
+         : 0;
+}
+
+constexpr uint32_t supportedPidsBitmap(uint8_t index)
+{
+    return 0;
+}
+
+template <typename... Pids>
+constexpr uint32_t supportedPidsBitmap(uint8_t index, uint8_t pid, Pids... pids)
+{
+    return supportedPidBits(index, pid) | supportedPidsBitmap(index, pids...);
+}
+
+constexpr uint32_t supportedPidRangeBitmap(uint8_t index, uint16_t first, uint16_t last)
+{
+    return first > last ? 0 : supportedPidBits(index, first) | supportedPidRangeBitmap(index, first + 1, last);
+}
+
+// Supported pids table for the listed pids
+template <typename... Pids>
+constexpr SupportedPids makeSupportedPids(Pids... pids)
+{
+    return SupportedPids{{supportedPidsBitmap(0, pids...), supportedPidsBitmap(1, pids...),
+                          supportedPidsBitmap(2, pids...), supportedPidsBitmap(3, pids...),
+                          supportedPidsBitmap(4, pids...), supportedPidsBitmap(5, pids...),
+                          supportedPidsBitmap(6, pids...), supportedPidsBitmap(7, pids...)}};
+}
+
+// Supported pids table for all pids from first to last
+constexpr SupportedPids makeSupportedPidRange(uint8_t first, uint8_t last)
+{
+    return SupportedPids{{supportedPidRangeBitmap(0, first, last), supportedPidRangeBitmap(1, first, last),
+                          supportedPidRangeBitmap(2, first, last), supportedPidRangeBitmap(3, first, last),
+                          supportedPidRangeBitmap(4, first, last), supportedPidRangeBitmap(5, first, last),
+                          supportedPidRangeBitmap(6, first, last), supportedPidRangeBitmap(7, first, last)}};
+}
+
+#endif
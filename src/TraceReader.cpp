@@ -0,0 +1,29 @@
+#include "TraceReader.h"
+
+MemoryTraceReader::MemoryTraceReader(const uint8_t *data, uint32_t size) : data(data), size(size) {}
+
+bool MemoryTraceReader::read(uint32_t offset, uint8_t *buffer, uint16_t length)
+{
+    if (offset > size || length > size - offset)
+    {
+        return false;
+    }
+    memcpy(buffer, data + offset, length);
+    return true;
+}
+
+#if HAS_FS
+FileTraceReader::FileTraceReader(fs::File &file) : file(file), position(UINT32_MAX) {}
+
+bool FileTraceReader::read(uint32_t offset, uint8_t *buffer, uint16_t length)
+{
+    if (offset != position && !file.seek(offset))
+    {
+        position = UINT32_MAX;
+        return false;
+    }
+    size_t n = file.read(buffer, length);
+    position = offset + n;
+    return n == length;
+}
+#endif
@@ -0,0 +1,63 @@
+#ifndef ELMulator_TraceReader_h
+#define ELMulator_TraceReader_h
+
+#include <Arduino.h>
+#include "definitions.h"
+
+#if HAS_FS
+#include <FS.h>
+#endif
+
+/**
+ * Random access to a binary trace (see TraceReplay), wherever it is stored.
+ * TraceReplay only reads the few bytes each lookup needs, so a trace of
+ * hours never has to fit in RAM.
+ */
+class TraceReader
+{
+public:
+    virtual ~TraceReader() {}
+
+    // Copy length bytes at offset into buffer, false if they are not all there
+    virtual bool read(uint32_t offset, uint8_t *buffer, uint16_t length) = 0;
+};
+
+/**
+ * Trace already mapped in the address space, ex: a const array (which the
+ * ESP32 keeps in memory mapped flash) or a buffer filled by the sketch
+ */
+class MemoryTraceReader : public TraceReader
+{
+public:
+    MemoryTraceReader(const uint8_t *data, uint32_t size);
+
+    bool read(uint32_t offset, uint8_t *buffer, uint16_t length) override;
+
+private:
+    const uint8_t *data;
+    uint32_t size;
+};
+
+#if HAS_FS
+/**
+ * Trace in a file of any Arduino FS (SPIFFS, LittleFS, SD), streamed from it:
+ *
+ * File file = LittleFS.open("/drive.elmt");
+ * FileTraceReader reader(file);
+ *
+ * The file must stay open as long as the reader is used.
+ */
+class FileTraceReader : public TraceReader
+{
+public:
+    FileTraceReader(fs::File &file);
+
+    bool read(uint32_t offset, uint8_t *buffer, uint16_t length) override;
+
+private:
+    fs::File &file;
+    uint32_t position; // saves the seek of sequential reads
+};
+#endif
+
+#endif
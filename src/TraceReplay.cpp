@@ -0,0 +1,208 @@
+#include "TraceReplay.h"
+
+static const uint16_t TRACE_VERSION = 1;
+
+static inline uint16_t readU16(const uint8_t *bytes)
+{
+    return bytes[0] | (bytes[1] << 8);
+}
+
+static inline uint32_t readU32(const uint8_t *bytes)
+{
+    return bytes[0] | (bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+TraceReplay::TraceReplay()
+{
+    reader = nullptr;
+    nPids = 0;
+    memset(slots, NO_SLOT, sizeof(slots));
+    supportedPids.clear();
+    durationMs = 0;
+    indexIntervalMs = 1;
+    startMs = 0;
+    speedQ8 = 256;
+    loop = true;
+}
+
+bool TraceReplay::begin(TraceReader *reader)
+{
+    this->reader = reader;
+    nPids = 0;
+    memset(slots, NO_SLOT, sizeof(slots));
+    supportedPids.clear();
+
+    uint8_t header[HEADER_SIZE];
+    if (!reader->read(0, header, sizeof(header)) || memcmp(header, "ELMT", 4) != 0 ||
+        readU16(header + 4) != TRACE_VERSION || readU32(header + 12) == 0)
+    {
+        ELM_LOG_ERROR("Not an ELMulator trace");
+        return false;
+    }
+    uint16_t nEntries = readU16(header + 6);
+    durationMs = readU32(header + 8);
+    indexIntervalMs = readU32(header + 12);
+
+    for (uint16_t i = 0; i < nEntries; i++)
+    {
+        uint8_t entry[DIRECTORY_ENTRY_SIZE];
+        if (!reader->read(HEADER_SIZE + i * DIRECTORY_ENTRY_SIZE, entry, sizeof(entry)))
+        {
+            return false;
+        }
+        uint8_t mode = entry[0];
+        uint8_t pid = entry[1];
+        if (mode != SERVICE_01 || slots[pid] != NO_SLOT)
+        {
+            continue;
+        }
+        if (nPids == MAX_TRACE_PIDS)
+        {
+            ELM_LOG_WARN("Trace has more than %u pids, ignoring the others", MAX_TRACE_PIDS);
+            break;
+        }
+
+        TracePid &tracePid = pids[nPids];
+        tracePid.nRecords = readU32(entry + 4);
+        tracePid.recordsOffset = readU32(entry + 8);
+        tracePid.indexOffset = readU32(entry + 12);
+        tracePid.cursor = NO_RECORD;
+        tracePid.time = UINT32_MAX; // nothing loaded, the first lookup seeks
+        tracePid.nextTime = 0;
+        slots[pid] = nPids++;
+        supportedPids.add(pid);
+    }
+    return true;
+}
+
+void TraceReplay::start(uint32_t nowMs)
+{
+    startMs = nowMs;
+}
+
+void TraceReplay::setSpeed(float speed)
+{
+    speedQ8 = speed > 0 ? (uint32_t)(speed * 256 + 0.5f) : 0;
+}
+
+void TraceReplay::setLoop(bool loop)
+{
+    this->loop = loop;
+}
+
+uint32_t TraceReplay::getTraceTime(uint32_t nowMs)
+{
+    uint64_t time = ((uint64_t)(nowMs - startMs) * speedQ8) >> 8;
+    if (durationMs == 0)
+    {
+        return 0;
+    }
+    if (loop)
+    {
+        return time % durationMs;
+    }
+    return time < durationMs ? time : durationMs;
+}
+
+uint32_t TraceReplay::getDuration()
+{
+    return durationMs;
+}
+
+const SupportedPids &TraceReplay::getSupportedPids()
+{
+    return supportedPids;
+}
+
+bool TraceReplay::getValue(uint8_t pid, uint32_t nowMs, uint32_t &value)
+{
+    if (slots[pid] == NO_SLOT)
+    {
+        return false;
+    }
+    TracePid &tracePid = pids[slots[pid]];
+    uint32_t time = getTraceTime(nowMs);
+
+    if (time < tracePid.time || time >= tracePid.nextTime)
+    {
+        if (!seek(tracePid, time))
+        {
+            tracePid.time = UINT32_MAX; // read error, retry next time
+            tracePid.nextTime = 0;
+            return false;
+        }
+    }
+    if (tracePid.cursor == NO_RECORD)
+    {
+        return false;
+    }
+    value = tracePid.value;
+    return true;
+}
+
+/**
+ * Make the record holding at time current: step forward when time is less
+ * than an index interval ahead, otherwise start from the index.
+ */
+bool TraceReplay::seek(TracePid &tracePid, uint32_t time)
+{
+    if (time < tracePid.time || time - tracePid.nextTime >= indexIntervalMs)
+    {
+        uint32_t slot = time / indexIntervalMs;
+        uint8_t entry[4];
+        if (!reader->read(tracePid.indexOffset + slot * 4, entry, sizeof(entry)))
+        {
+            return false;
+        }
+        uint32_t count = readU32(entry);
+        if (count > 0)
+        {
+            if (!loadRecord(tracePid, count - 1))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            // before the first record, until its time
+            uint8_t first[4];
+            if (tracePid.nRecords > 0 && !reader->read(tracePid.recordsOffset, first, sizeof(first)))
+            {
+                return false;
+            }
+            tracePid.cursor = NO_RECORD;
+            tracePid.time = 0;
+            tracePid.nextTime = tracePid.nRecords > 0 ? readU32(first) : UINT32_MAX;
+        }
+    }
+
+    // at most the records of one index interval
+    while (tracePid.nextTime <= time)
+    {
+        if (!loadRecord(tracePid, tracePid.cursor == NO_RECORD ? 0 : tracePid.cursor + 1))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Reads record and the time of the next one with a single read
+bool TraceReplay::loadRecord(TracePid &tracePid, uint32_t record)
+{
+    if (record >= tracePid.nRecords)
+    {
+        return false;
+    }
+    bool hasNext = record + 1 < tracePid.nRecords;
+    uint8_t bytes[RECORD_SIZE + 4];
+    if (!reader->read(tracePid.recordsOffset + record * RECORD_SIZE, bytes, hasNext ? sizeof(bytes) : RECORD_SIZE))
+    {
+        return false;
+    }
+    tracePid.cursor = record;
+    tracePid.time = readU32(bytes);
+    tracePid.value = readU32(bytes + 4);
+    tracePid.nextTime = hasNext ? readU32(bytes + RECORD_SIZE) : UINT32_MAX;
+    return true;
+}
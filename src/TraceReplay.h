@@ -0,0 +1,102 @@
+#ifndef ELMulator_TraceReplay_h
+#define ELMulator_TraceReplay_h
+
+#include <Arduino.h>
+#include "definitions.h"
+#include "SupportedPids.h"
+#include "TraceReader.h"
+#include "ELMLog.h"
+
+/**
+ * Answers mode 01 pids with the values of a recorded drive, at the original
+ * or an accelerated pace.
+ *
+ * Traces are converted from capture logs by extras/trace_convert.py to this
+ * binary format (all fields little endian):
+ *
+ *   header     "ELMT", u16 version, u16 nPids, u32 durationMs, u32 indexIntervalMs
+ *   directory  nPids x {u8 mode, u8 pid, u8 nBytes, u8 reserved,
+ *                       u32 nRecords, u32 recordsOffset, u32 indexOffset}
+ *   per pid    index: durationMs / indexIntervalMs + 1 x u32, entry i is the
+ *                     number of records at or before i * indexIntervalMs
+ *              records: nRecords x {u32 timeMs, u32 value}, by time
+ *
+ * Only the directory is loaded. Each pid keeps its current record and the
+ * time of the next one, so most requests are answered from RAM; when the
+ * trace time leaves that record, the next record is read, or after a jump
+ * (looping, high speed) one index entry and the records of one interval.
+ */
+class TraceReplay
+{
+public:
+    TraceReplay();
+
+    /**
+     * Load the trace header and directory, the reader must outlive the replay
+     *
+     * @return false if the trace is not valid
+     */
+    bool begin(TraceReader *reader);
+
+    // Restart the trace at nowMs (ex: millis())
+    void start(uint32_t nowMs);
+
+    // Trace ms played per real ms (ex: 10 plays 10 s of the drive each second)
+    void setSpeed(float speed);
+
+    // Start over at the end of the trace (default), or keep its last values
+    void setLoop(bool loop);
+
+    /**
+     * Recorded value of pid at nowMs, the last one at or before the trace time
+     *
+     * @return false if the pid is not in the trace or not recorded yet
+     */
+    bool getValue(uint8_t pid, uint32_t nowMs, uint32_t &value);
+
+    // Trace position at nowMs, in ms
+    uint32_t getTraceTime(uint32_t nowMs);
+
+    uint32_t getDuration();
+
+    // Mode 01 pids in the trace, ex: for ELMulator::registerPids
+    const SupportedPids &getSupportedPids();
+
+private:
+    static const uint8_t NO_SLOT = 0xFF;
+    static const uint32_t NO_RECORD = UINT32_MAX;
+    static const uint8_t HEADER_SIZE = 16;
+    static const uint8_t DIRECTORY_ENTRY_SIZE = 16;
+    static const uint8_t RECORD_SIZE = 8;
+
+    struct TracePid
+    {
+        uint32_t nRecords;
+        uint32_t recordsOffset;
+        uint32_t indexOffset;
+        uint32_t cursor;    // current record, NO_RECORD before the first one
+        uint32_t time;      // current record holds from time ...
+        uint32_t nextTime;  // ... until nextTime (excluded)
+        uint32_t value;
+    };
+
+    TraceReader *reader;
+    TracePid pids[MAX_TRACE_PIDS];
+    uint8_t nPids;
+
+    // pids index for each mode 01 pid, NO_SLOT if not in the trace
+    uint8_t slots[maxPid + 1];
+
+    SupportedPids supportedPids;
+    uint32_t durationMs;
+    uint32_t indexIntervalMs;
+    uint32_t startMs;
+    uint32_t speedQ8; // 24.8 fixed point
+    bool loop;
+
+    bool seek(TracePid &tracePid, uint32_t time);
+
+    bool loadRecord(TracePid &tracePid, uint32_t record);
+};
+
+#endif
@@ -0,0 +1,110 @@
+#include "VehicleInfo.h"
+
+static const uint8_t ENTRY_PIDS[] = {VEHICLE_IDENTIFICATION_NUMBER, CALIBRATION_ID,
+                                     CALIBRATION_VERIFICATION_NUMBER, ECU_NAME};
+
+VehicleInfo::VehicleInfo(SupportedPids *supportedPids)
+{
+    this->supportedPids = supportedPids;
+    for (uint8_t i = 0; i < N_ENTRIES; i++)
+    {
+        entries[i].pid = ENTRY_PIDS[i];
+        entries[i].length = 0;
+        entries[i].formatVersion = 0;
+        entries[i].formattedLength = 0;
+    }
+}
+
+bool VehicleInfo::setVin(const char *vin)
+{
+    return strlen(vin) == VIN_LENGTH && setText(VEHICLE_IDENTIFICATION_NUMBER, vin, VIN_LENGTH);
+}
+
+bool VehicleInfo::addCalibrationId(const char *calibrationId)
+{
+    uint8_t item[CALIBRATION_ID_LENGTH] = {0};
+    uint8_t length = strlen(calibrationId);
+    if (length > CALIBRATION_ID_LENGTH)
+    {
+        return false;
+    }
+    memcpy(item, calibrationId, length);
+    return addItem(CALIBRATION_ID, item, sizeof(item));
+}
+
+bool VehicleInfo::addCalibrationVerificationNumber(uint32_t cvn)
+{
+    uint8_t item[4] = {(uint8_t)(cvn >> 24), (uint8_t)(cvn >> 16), (uint8_t)(cvn >> 8), (uint8_t)cvn};
+    return addItem(CALIBRATION_VERIFICATION_NUMBER, item, sizeof(item));
+}
+
+bool VehicleInfo::setEcuName(const char *name)
+{
+    return strlen(name) <= ECU_NAME_LENGTH && setText(ECU_NAME, name, ECU_NAME_LENGTH);
+}
+
+VehicleInfo::Entry *VehicleInfo::find(uint8_t pid)
+{
+    for (uint8_t i = 0; i < N_ENTRIES; i++)
+    {
+        if (entries[i].pid == pid)
+        {
+            return entries[i].length > 0 ? &entries[i] : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+void VehicleInfo::resetFormatted()
+{
+    for (uint8_t i = 0; i < N_ENTRIES; i++)
+    {
+        entries[i].formatVersion = 0;
+    }
+}
+
+VehicleInfo::Entry &VehicleInfo::getEntry(uint8_t pid)
+{
+    uint8_t i = 0;
+    while (i < N_ENTRIES - 1 && entries[i].pid != pid)
+    {
+        i++;
+    }
+    return entries[i];
+}
+
+// text is padded with 0 up to size
+bool VehicleInfo::setText(uint8_t pid, const char *text, uint8_t size)
+{
+    Entry &entry = getEntry(pid);
+    entry.length = 0;
+    uint8_t item[ECU_NAME_LENGTH] = {0};
+    memcpy(item, text, strlen(text));
+    return addItem(pid, item, size);
+}
+
+/**
+ * Payload: 49, pid, number of data items (NODI), items. Any rendered
+ * response is dropped.
+ */
+bool VehicleInfo::addItem(uint8_t pid, const uint8_t *item, uint8_t size)
+{
+    Entry &entry = getEntry(pid);
+    if (entry.length == 0)
+    {
+        entry.payload[0] = SERVICE_09 + 0x40;
+        entry.payload[1] = pid;
+        entry.payload[2] = 0;
+        entry.length = 3;
+    }
+    if (entry.payload[2] == MAX_CALIBRATION_IDS || entry.length + size > VEHICLE_INFO_PAYLOAD_SIZE)
+    {
+        return false;
+    }
+    memcpy(entry.payload + entry.length, item, size);
+    entry.length += size;
+    entry.payload[2]++;
+    entry.formatVersion = 0;
+    supportedPids->add(pid);
+    return true;
+}
@@ -0,0 +1,75 @@
+#ifndef ELMulator_VehicleInfo_h
+#define ELMulator_VehicleInfo_h
+
+#include <Arduino.h>
+#include "definitions.h"
+#include "SupportedPids.h"
+
+/**
+ * Mode 09 vehicle information: VIN (0902), calibration IDs (0904), their
+ * verification numbers (0906) and ECU name (090A).
+ *
+ * Each item is kept as its complete response payload (ex: 49 02 01 + 17
+ * VIN chars), built when it is set. PidProcessor renders it once for the
+ * client's format settings (ATH, ATS, ATCAF, ATL) into formatted, then
+ * answers the following requests with that text.
+ *
+ * Set the items during setup, before requests are answered.
+ */
+class VehicleInfo
+{
+public:
+    struct Entry
+    {
+        uint8_t pid;
+        uint8_t length; // payload bytes, 0 == not set
+        uint8_t payload[VEHICLE_INFO_PAYLOAD_SIZE];
+        uint16_t formatVersion; // of formatted, 0 == not rendered yet
+        uint16_t formattedLength; // 0 == too long, written frame by frame
+        char formatted[VEHICLE_INFO_FORMATTED_SIZE];
+    };
+
+    /**
+     * @param supportedPids - mode 09 supported pids table the items are added
+     *                        to, so the 0900 query lists them
+     */
+    VehicleInfo(SupportedPids *supportedPids);
+
+    // @return false if vin is not VIN_LENGTH chars
+    bool setVin(const char *vin);
+
+    /**
+     * Adds a calibration ID (up to CALIBRATION_ID_LENGTH chars, padded with 0)
+     *
+     * @return false if it is too long or there are MAX_CALIBRATION_IDS already
+     */
+    bool addCalibrationId(const char *calibrationId);
+
+    // @return false if there are MAX_CALIBRATION_IDS already
+    bool addCalibrationVerificationNumber(uint32_t cvn);
+
+    // @return false if name is longer than ECU_NAME_LENGTH chars (ex: "ECM-EngineControl")
+    bool setEcuName(const char *name);
+
+    // Entry of a mode 09 pid, nullptr if it is not set
+    Entry *find(uint8_t pid);
+
+    // Marks every item as not rendered yet, ex: after the format versions were renumbered
+    void resetFormatted();
+
+private:
+    static const uint8_t N_ENTRIES = 4;
+
+    Entry entries[N_ENTRIES];
+    SupportedPids *supportedPids;
+
+    Entry &getEntry(uint8_t pid);
+
+    // Replaces the data of a pid with a single item
+    bool setText(uint8_t pid, const char *text, uint8_t size);
+
+    // Appends an item (NODI += 1) to the data of a pid
+    bool addItem(uint8_t pid, const uint8_t *item, uint8_t size);
+};
+
+#endif
@@ -0,0 +1,316 @@
+#include "VehicleSimulator.h"
+
+// speed (km/h) to shift up from gear i to i + 1, down 5 km/h lower
+static const float SHIFT_UP_SPEED[] = {0, 20, 35, 55, 75, 95};
+static const uint8_t TOP_GEAR = 6;
+
+// engine rpm for each km/h in gear i
+static const float RPM_PER_KMH[] = {0, 120, 70, 48, 36, 29, 24};
+
+// share of the engine torque reaching the wheels in gear i
+static const float GEAR_TRACTION[] = {0, 1.0f, 0.85f, 0.7f, 0.55f, 0.45f, 0.38f};
+
+static const float IDLE_RPM = 800;
+static const float THERMOSTAT_TEMP = 90;
+static const float DISPLACEMENT = 2.0f;    // L
+static const float AIR_DENSITY = 1.184f;   // g/L at 25 °C
+static const float FUEL_DENSITY = 740;     // g/L
+static const float STOICHIOMETRIC_AFR = 14.7f;
+static const float TANK_SIZE = 50;         // L
+
+static inline float clamp(float value, float min, float max) {
+    return value < min ? min : (value > max ? max : value);
+}
+
+// first order lag of value towards target with time constant tau (s)
+static inline float approach(float value, float target, float dt, float tau) {
+    float k = dt / tau;
+    return value + (target - value) * (k > 1 ? 1 : k);
+}
+
+VehicleSimulator::VehicleSimulator(uint32_t seed) {
+    reset(seed);
+}
+
+void VehicleSimulator::reset(uint32_t seed) {
+    random = seed != 0 ? seed : 1; // xorshift never leaves 0
+    steps = 0;
+    lastUpdateMs = 0;
+    started = false;
+
+    ambientTemp = randomBetween(5, 25);
+    coolantTemp = ambientTemp;
+    oilTemp = ambientTemp;
+    intakeTemp = ambientTemp;
+    fuelLevel = randomBetween(30, 90);
+    distance = randomBetween(20000, 150000);
+    longTermTrim = randomBetween(-4, 4);
+    shortTermTrim = 0;
+    runTime = 0;
+
+    speed = 0;
+    throttle = 0;
+    gear = 0;
+    rpm = IDLE_RPM;
+    load = 20;
+    manifoldPressure = 35;
+    airFlow = 0;
+
+    phase = IDLE;
+    phaseTimeLeft = randomBetween(5, 15);
+    targetSpeed = 0;
+}
+
+uint32_t VehicleSimulator::nextRandom() {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    return random;
+}
+
+float VehicleSimulator::randomBetween(float min, float max) {
+    return min + (max - min) * (nextRandom() >> 8) * (1.0f / 16777216.0f);
+}
+
+void VehicleSimulator::update(uint32_t nowMs) {
+    if (!started) {
+        started = true;
+        lastUpdateMs = nowMs;
+        return;
+    }
+
+    uint32_t n = (nowMs - lastUpdateMs) / SIMULATION_STEP_MS;
+    if (n > SIMULATION_MAX_CATCH_UP_STEPS) {
+        n = SIMULATION_MAX_CATCH_UP_STEPS; // long pause, do not try to catch up
+        lastUpdateMs = nowMs;
+    } else {
+        lastUpdateMs += n * SIMULATION_STEP_MS;
+    }
+    while (n--) {
+        step();
+    }
+}
+
+void VehicleSimulator::step() {
+    const float dt = SIMULATION_STEP_MS / 1000.0f;
+
+    phaseTimeLeft -= dt;
+    bool phaseDone = phaseTimeLeft <= 0;
+    if (phase == ACCELERATE) {
+        phaseDone = phaseDone || speed >= targetSpeed - 1;
+    } else if (phase == BRAKE) {
+        phaseDone = speed <= 0;
+    }
+    if (phaseDone) {
+        nextPhase();
+    }
+
+    updateDriveline(dt);
+    updateEngine(dt);
+    runTime += dt;
+    steps++;
+}
+
+/**
+ * idle -> accelerate -> cruise -> (accelerate to a new speed | brake to a stop -> idle)
+ */
+void VehicleSimulator::nextPhase() {
+    switch (phase) {
+    case IDLE:
+        phase = ACCELERATE;
+        targetSpeed = randomBetween(30, 120);
+        phaseTimeLeft = 60;
+        break;
+    case ACCELERATE:
+        phase = CRUISE;
+        phaseTimeLeft = randomBetween(20, 90);
+        break;
+    case CRUISE:
+        if (nextRandom() & 1) {
+            phase = BRAKE;
+            targetSpeed = 0;
+            phaseTimeLeft = 60;
+        } else {
+            phase = ACCELERATE;
+            targetSpeed = randomBetween(30, 120);
+            phaseTimeLeft = 60;
+        }
+        break;
+    case BRAKE:
+        phase = IDLE;
+        phaseTimeLeft = randomBetween(5, 30);
+        break;
+    }
+}
+
+void VehicleSimulator::updateDriveline(float dt) {
+    float pedal = 0;
+    float braking = 0; // m/s2
+    switch (phase) {
+    case IDLE:
+        braking = 1.5f;
+        break;
+    case ACCELERATE:
+        pedal = clamp(30 + (targetSpeed - speed) * 2, 20, 85);
+        break;
+    case CRUISE:
+        pedal = clamp(10 + speed * 0.15f + (targetSpeed - speed) * 3, 5, 60);
+        break;
+    case BRAKE:
+        braking = 2.5f;
+        break;
+    }
+    throttle = approach(throttle, pedal, dt, 0.2f);
+
+    // m/s
+    float v = speed / 3.6f;
+    float drive = throttle * 0.03f * GEAR_TRACTION[gear];
+    float resistance = 0.1f + 0.0004f * v * v;
+    v += (drive - resistance - braking) * dt;
+    speed = v > 0 ? v * 3.6f : 0;
+    distance += speed * dt / 3600;
+
+    if (speed < 1) {
+        gear = (phase == ACCELERATE) ? 1 : 0;
+    } else {
+        if (gear == 0) {
+            gear = 1;
+        }
+        while (gear < TOP_GEAR && speed > SHIFT_UP_SPEED[gear]) {
+            gear++;
+        }
+        while (gear > 1 && speed < SHIFT_UP_SPEED[gear - 1] - 5) {
+            gear--;
+        }
+    }
+}
+
+void VehicleSimulator::updateEngine(float dt) {
+    // clutch slips below idle in first gear
+    float targetRpm = (gear == 0) ? IDLE_RPM + throttle * 20 : speed * RPM_PER_KMH[gear];
+    if (targetRpm < IDLE_RPM) {
+        targetRpm = (gear == 1 && throttle > 5) ? IDLE_RPM + throttle * 15 : IDLE_RPM;
+    }
+    rpm = approach(rpm, targetRpm, dt, 0.15f) + randomBetween(-3, 3);
+
+    load = clamp(15 + throttle * 0.8f + (rpm > 3000 ? (rpm - 3000) / 100 : 0), 0, 100);
+    manifoldPressure = clamp(25 + load * 0.75f, 20, 101);
+
+    // speed density: air drawn in by the cylinders at this pressure and temperature
+    float volumetricEfficiency = 0.85f;
+    airFlow = rpm / 120 * DISPLACEMENT * AIR_DENSITY * volumetricEfficiency *
+              (manifoldPressure / 101.3f) * (298 / (273 + intakeTemp));
+
+    // warms up faster under load, then the thermostat holds it
+    float warmUpTau = 300 - load * 1.5f;
+    coolantTemp = approach(coolantTemp, THERMOSTAT_TEMP + randomBetween(-2, 2), dt, warmUpTau);
+    oilTemp = approach(oilTemp, coolantTemp + load * 0.1f, dt, 400);
+    float heatSoak = speed < 10 ? (coolantTemp - ambientTemp) * 0.15f : 2;
+    intakeTemp = approach(intakeTemp, ambientTemp + 3 + heatSoak, dt, 30);
+
+    // short term trim wanders around 0, long term slowly learns it
+    shortTermTrim = clamp(shortTermTrim - shortTermTrim * dt * 0.5f + randomBetween(-1, 1) * dt * 10, -10, 10);
+    longTermTrim = clamp(longTermTrim + shortTermTrim * dt * 0.01f, -10, 10);
+
+    float fuelFlow = airFlow / STOICHIOMETRIC_AFR / FUEL_DENSITY; // L/s
+    fuelLevel -= fuelFlow / TANK_SIZE * 100 * dt;
+    if (fuelLevel < 5) {
+        fuelLevel = 90; // refuelled
+    }
+}
+
+bool VehicleSimulator::getValue(uint8_t pid, float &value) {
+    switch (pid) {
+    case ENGINE_LOAD:
+        value = load;
+        break;
+    case ABS_LOAD_VALUE:
+        value = load * manifoldPressure / 101.3f;
+        break;
+    case ENGINE_COOLANT_TEMP:
+        value = coolantTemp;
+        break;
+    case SHORT_TERM_FUEL_TRIM_BANK_1:
+    case SHORT_TERM_FUEL_TRIM_BANK_2:
+        value = shortTermTrim;
+        break;
+    case LONG_TERM_FUEL_TRIM_BANK_1:
+    case LONG_TERM_FUEL_TRIM_BANK_2:
+        value = longTermTrim;
+        break;
+    case INTAKE_MANIFOLD_ABS_PRESSURE:
+        value = manifoldPressure;
+        break;
+    case ENGINE_RPM:
+        value = rpm;
+        break;
+    case VEHICLE_SPEED:
+        value = speed;
+        break;
+    case TIMING_ADVANCE:
+        value = clamp(10 + rpm / 400 - load / 10, -5, 45);
+        break;
+    case INTAKE_AIR_TEMP:
+        value = intakeTemp;
+        break;
+    case MAF_FLOW_RATE:
+        value = airFlow;
+        break;
+    case THROTTLE_POSITION:
+        value = 12 + throttle * 0.85f; // the plate never fully closes
+        break;
+    case RELATIVE_THROTTLE_POSITION:
+    case RELATIVE_ACCELERATOR_PEDAL_POS:
+    case COMMANDED_THROTTLE_ACTUATOR:
+        value = throttle;
+        break;
+    case RUN_TIME_SINCE_ENGINE_START:
+        value = runTime;
+        break;
+    case FUEL_TANK_LEVEL_INPUT:
+        value = fuelLevel;
+        break;
+    case ABS_BAROMETRIC_PRESSURE:
+        value = 101;
+        break;
+    case CONTROL_MODULE_VOLTAGE:
+        value = 14.1f - load * 0.005f;
+        break;
+    case AMBIENT_AIR_TEMP:
+        value = ambientTemp;
+        break;
+    case ENGINE_OIL_TEMP:
+        value = oilTemp;
+        break;
+    case ENGINE_FUEL_RATE:
+        value = airFlow / STOICHIOMETRIC_AFR / FUEL_DENSITY * 3600;
+        break;
+    case FUEL_AIR_COMMANDED_EQUIV_RATIO:
+        value = 1;
+        break;
+    case ODOMETER:
+        value = distance;
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+bool VehicleSimulator::getRawValue(uint8_t pid, uint32_t &raw) {
+    float value;
+    const PidDescriptor *descriptor = PidDescriptor::find(pid);
+    if (descriptor == nullptr || !getValue(pid, value)) {
+        return false;
+    }
+    raw = descriptor->encode(value);
+    return true;
+}
+
+uint8_t VehicleSimulator::getGear() {
+    return gear;
+}
+
+uint32_t VehicleSimulator::getSteps() {
+    return steps;
+}
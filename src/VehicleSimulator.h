@@ -0,0 +1,98 @@
+#ifndef ELMulator_VehicleSimulator_h
+#define ELMulator_VehicleSimulator_h
+
+#include <Arduino.h>
+#include "definitions.h"
+#include "PidDescriptor.h"
+
+/**
+ * Deterministic drive cycle simulation used as mock data: a repeating cycle
+ * of idle, acceleration, cruise and braking drives the vehicle speed, and
+ * gear, rpm, load, MAP, MAF, temperatures, fuel trims etc. are derived from
+ * it so all PIDs stay physically consistent with each other.
+ *
+ * The state advances in fixed SIMULATION_STEP_MS steps (a few dozen float
+ * operations each, fine at 100 Hz on an ESP32), and all randomness comes
+ * from a seeded generator, so the same seed and number of steps always
+ * give the same values.
+ */
+class VehicleSimulator
+{
+public:
+    VehicleSimulator(uint32_t seed = SIMULATION_DEFAULT_SEED);
+
+    // Restart the simulation from a cold engine, with a new seed
+    void reset(uint32_t seed);
+
+    // Advance one fixed step
+    void step();
+
+    /**
+     * Advance the steps elapsed up to nowMs (ex: millis()), at most
+     * SIMULATION_MAX_CATCH_UP_STEPS per call
+     */
+    void update(uint32_t nowMs);
+
+    /**
+     * Current value of a simulated mode 01 pid, in engineering units (ex: rpm)
+     *
+     * @return false if the pid is not simulated
+     */
+    bool getValue(uint8_t pid, float &value);
+
+    // Same as getValue, encoded for the response (see PidDescriptor)
+    bool getRawValue(uint8_t pid, uint32_t &raw);
+
+    uint8_t getGear();
+
+    uint32_t getSteps();
+
+private:
+    // Drive cycle phases
+    enum PHASE
+    {
+        IDLE = 0,
+        ACCELERATE = 1,
+        CRUISE = 2,
+        BRAKE = 3
+    };
+
+    uint32_t random;       // xorshift32 state
+    uint32_t steps;
+    uint32_t lastUpdateMs;
+    bool started;
+
+    PHASE phase;
+    float phaseTimeLeft;   // s
+    float targetSpeed;     // km/h
+
+    float speed;           // km/h
+    float throttle;        // %
+    uint8_t gear;          // 0 == neutral
+    float rpm;
+    float load;            // %
+    float manifoldPressure; // kPa
+    float airFlow;         // g/s
+    float coolantTemp;     // °C
+    float oilTemp;         // °C
+    float intakeTemp;      // °C
+    float ambientTemp;     // °C
+    float shortTermTrim;   // %
+    float longTermTrim;    // %
+    float fuelLevel;       // %
+    float distance;        // km
+    float runTime;         // s
+
+    uint32_t nextRandom();
+
+    // uniform in [min, max)
+    float randomBetween(float min, float max);
+
+    void nextPhase();
+
+    void updateDriveline(float dt);
+
+    void updateEngine(float dt);
+};
+
+#endif
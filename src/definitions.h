@@ -9,8 +9,55 @@
 
 #define USE_WIFI false
 
-#define DO_DEBUG true
-#define DEBUG(x) do {if (DO_DEBUG) { Serial.println(x); } } while (0)
+// Bluetooth and WiFi transports need the ESP32 core,
+// elsewhere (or off device) use OBDStreamComm over any Stream
+#if defined(ARDUINO_ARCH_ESP32)
+#define HAS_ESP32_TRANSPORTS true
+#else
+#define HAS_ESP32_TRANSPORTS false
+#endif
+
+// SensorSampler samples in a FreeRTOS task on the ESP32 core,
+// elsewhere it is run cooperatively from ELMulator::poll()
+#if defined(ARDUINO_ARCH_ESP32)
+#define HAS_FREERTOS true
+#else
+#define HAS_FREERTOS false
+#endif
+
+// TraceReplay reads traces from SPIFFS/LittleFS/SD files with the ESP32 core,
+// elsewhere only from memory (ex: a const array in flash)
+#if defined(ARDUINO_ARCH_ESP32)
+#define HAS_FS true
+#else
+#define HAS_FS false
+#endif
+
+// Log levels, see ELMLog.h
+#define ELM_LOG_LEVEL_NONE 0
+#define ELM_LOG_LEVEL_ERROR 1
+#define ELM_LOG_LEVEL_WARN 2
+#define ELM_LOG_LEVEL_INFO 3
+#define ELM_LOG_LEVEL_DEBUG 4 // every request
+#define ELM_LOG_LEVEL_TRACE 5 // every response
+
+// Messages above this level are compiled out, can also be set with a build flag
+#ifndef ELM_LOG_LEVEL
+#define ELM_LOG_LEVEL ELM_LOG_LEVEL_WARN
+#endif
+
+// Deprecated, prints right away: use ELM_LOG_DEBUG (ELMLog.h)
+#if ELM_LOG_LEVEL >= ELM_LOG_LEVEL_DEBUG
+#define DEBUG(x) Serial.println(x)
+#else
+#define DEBUG(x) do {} while (0)
+#endif
+
+// Request latency/count statistics (ELMStats.h, AT@STATS), a few cycle counter
+// reads per request; compiled out unless enabled here or with -DELM_STATS=1
+#ifndef ELM_STATS
+#define ELM_STATS 0
+#endif
 
 #define xtoc(x) ((x < 10) ? ('0' + x) : ('A' - 10 + x))
 #define getNumOfHexChars(nBytes) (nBytes * 2)
@@ -21,7 +68,12 @@
 // Device ID
 #define ID  "ELM327 / ELMulator V1.3.0"
 #define DESC  "ELMulator OBD2 Arduino library, based on ELM327 protocol"
-#define PROTOCOL "6" // canbus 500k 11 bit protocol id for elm.
+
+// CAN protocols (ATSP, ATDPN), others are answered as PROTOCOL_CAN_11_500
+const uint8_t PROTOCOL_CAN_11_500 = 6; // ISO 15765-4, 11 bit ids, 500 kbps
+const uint8_t PROTOCOL_CAN_29_500 = 7;
+const uint8_t PROTOCOL_CAN_11_250 = 8;
+const uint8_t PROTOCOL_CAN_29_250 = 9;
 
 // Char representing end of serial string
 #define SERIAL_END_CHAR  0x0D
@@ -29,10 +81,96 @@
 
 #define WIFI_END_CHAR 0x0A
 
+// Clients served at once by OBDWiFiComm, each with its own AT settings
+#define MAX_WIFI_CLIENTS 8
+
 const uint8_t maxPid = 0xFF;
-const uint8_t N_MODE01_INTERVALS = 7;
-const uint8_t PID_INTERVAL_OFFSET = 0x20;
+const uint8_t N_SUPPORT_QUERIES = 8;        // support queries 00, 20, ... E0 of a service, see SupportedPids
+const uint8_t N_SUPPORTED_PID_SERVICES = 5; // services with a supported pids table: 01, 02, 05, 06, 09
 const uint8_t MAX_REQUEST_SIZE = 40;
+const uint8_t MAX_PIDS_PER_REQUEST = 6; // mode 01 requests can ask for up to 6 pids (ex: 010C0D11050F04)
+const uint8_t SINGLE_FRAME_MAX_BYTES = 7; // longer responses are sent as ISO-TP multi frame
+
+// CAN ISO 15765-2 (ISO-TP) segmentation, see IsoTpFrames
+const uint8_t CAN_FRAME_SIZE = 8;
+const uint8_t FIRST_FRAME_MAX_BYTES = 6;      // payload bytes after the 2 byte first frame PCI
+const uint8_t CONSECUTIVE_FRAME_MAX_BYTES = 7;
+const uint16_t ISOTP_MAX_PAYLOAD = 4095;      // 12 bit first frame length
+const uint8_t ISOTP_PADDING = 0x00;           // unused bytes of the last frame
+const uint8_t FRAME_LINE_SIZE = 11 + 2 + CAN_FRAME_SIZE * 3 + 1; // spaced 29 bit header, DLC, spaced bytes
+const uint8_t MAX_MODE_PID_HANDLERS = 32; // mode 09 and 22 pids registered with a handler
+
+// CAN identifiers (11 bit) and the other ECUs answering next to the engine one, see EcuTable
+const uint16_t FUNCTIONAL_REQUEST_ID = 0x7DF; // all ECUs answer (default ATSH)
+const uint16_t ENGINE_REQUEST_ID = 0x7E0;     // physical request to the engine ECU
+const uint8_t RESPONSE_ID_OFFSET = 8;         // an ECU answers at its request id + 8 (ex: 7E0 -> 7E8)
+const uint32_t FUNCTIONAL_EXTENDED_ID = 0x18DB33F1; // 29 bit ids, see FrameFormatter::getExtendedId
+const uint8_t TESTER_ADDRESS = 0xF1;
+const uint8_t ECU_ADDRESS = 0x10;             // engine ECU, 29 bit physical address
+const uint8_t MAX_ECUS = 4;                   // besides the engine ECU
+const uint8_t MAX_ECU_PID_HANDLERS = 16;      // of each ECU in the table
+const uint8_t ECU_RESPONSE_SIZE = 2 + MAX_PIDS_PER_REQUEST * 5; // 41 + (pid + 4 bytes) per pid
+
+// Diagnostic trouble codes, see DtcStore
+const uint8_t MAX_DTCS = 16; // codes of each list (stored, pending, permanent)
+const uint8_t DTC_RESPONSE_SIZE = 2 + 2 * MAX_DTCS; // 43 + count + 2 bytes per code
+
+// Mode 02 freeze frames, see FreezeFrames
+const uint8_t MAX_FREEZE_FRAMES = 4;
+const uint16_t FREEZE_FRAME_ARENA_SIZE = 1024; // records of all frames: 2 bytes of code + the pid values
+
+// Mode 09 vehicle information, see VehicleInfo
+const uint8_t VIN_LENGTH = 17;
+const uint8_t CALIBRATION_ID_LENGTH = 16;
+const uint8_t ECU_NAME_LENGTH = 20;
+const uint8_t MAX_CALIBRATION_IDS = 4; // also the max number of CVNs
+const uint8_t VEHICLE_INFO_PAYLOAD_SIZE = 3 + CALIBRATION_ID_LENGTH * MAX_CALIBRATION_IDS;
+const uint8_t VEHICLE_INFO_FORMATTED_SIZE = 160; // rendered response kept per pid, longer ones are written frame by frame
+
+// Background sampling of mode 01 pids, see SensorSampler
+const uint8_t MAX_SAMPLED_PIDS = 32;
+const uint16_t SAMPLER_TASK_STACK_SIZE = 4096;
+const uint8_t SAMPLER_TASK_PRIORITY = 1;
+const uint8_t SAMPLER_TASK_CORE = 0; // loop() runs on core 1, and core 0 exists on single core boards too
+
+// Mock data, see VehicleSimulator
+const uint8_t SIMULATION_STEP_MS = 10;               // fixed step, 100 Hz
+const uint8_t SIMULATION_MAX_CATCH_UP_STEPS = 100;   // steps run at most by one update()
+const uint32_t SIMULATION_DEFAULT_SEED = 0x454C4D32;
+
+// Recorded drive replay, see TraceReplay
+const uint8_t MAX_TRACE_PIDS = 32; // pids of a trace kept in the directory
+
+// Request/response recording, see SessionRecorder
+const uint8_t RECORDER_RECORD_SIZE = 64;
+const uint8_t RECORDER_DATA_SIZE = RECORDER_RECORD_SIZE - 16; // bytes kept of each request/response
+const uint8_t RECORDER_RING_SIZE = 64;  // records buffered in RAM, power of 2
+const uint8_t RECORDER_DRAIN_PERIOD_MS = 50;
+const uint16_t RECORDER_TASK_STACK_SIZE = 4096;
+const uint8_t RECORDER_TASK_PRIORITY = 1;
+const uint8_t RECORDER_TASK_CORE = 0;
+
+// Deferred logging, see ELMLog
+const uint8_t LOG_RING_SIZE = 32;        // messages waiting to be printed, power of 2
+const uint8_t LOG_MAX_ARGS = 4;          // arguments kept per message
+const uint8_t LOG_TEXT_SIZE = 32;        // chars kept of the string arguments of a message
+const uint8_t LOG_LINE_SIZE = 128;       // max chars of a printed message
+const uint8_t LOG_DRAIN_PERIOD_MS = 20;
+const uint16_t LOG_TASK_STACK_SIZE = 3072;
+const uint8_t LOG_TASK_PRIORITY = 1;
+const uint8_t LOG_TASK_CORE = 0;
+
+// Request statistics, see ELMStats
+const uint8_t STATS_HISTOGRAM_BUCKETS = 24; // log2 buckets of cycles, the last one holds anything longer
+const uint8_t STATS_LINE_SIZE = 96;         // fits the summary line with every count at 10 digits
+
+// A response is assembled in this buffer and sent with a single transport write,
+// longer responses (ex: big multi frame) are sent in several writes
+const uint16_t TX_BUFFER_SIZE = 256;
+
+// Rendered PID responses kept by PidProcessor, see PidProcessor::writePidResponse
+const uint8_t RESPONSE_CACHE_SIZE = 16;       // number of entries, direct mapped by pid
+const uint8_t RESPONSE_CACHE_ENTRY_SIZE = 40; // max chars of a cached response
 
 
 //-------------------------------------------------------------------------------------//
@@ -169,6 +307,19 @@ const uint8_t ODOMETER                         = 166; // 0xA6 - km * 10
 const uint8_t SERVICE_01                       = 1;
 const uint8_t SERVICE_02                       = 2;
 const uint8_t SERVICE_03                       = 3;
+const uint8_t SERVICE_04                       = 4;
+const uint8_t SERVICE_05                       = 5;
+const uint8_t SERVICE_06                       = 6;
+const uint8_t SERVICE_07                       = 7;
+const uint8_t SERVICE_09                       = 9;
+const uint8_t SERVICE_0A                       = 0x0A;
+const uint8_t SERVICE_22                       = 0x22;
+
+// Mode 09 pids answered by VehicleInfo
+const uint8_t VEHICLE_IDENTIFICATION_NUMBER    = 0x02;
+const uint8_t CALIBRATION_ID                   = 0x04;
+const uint8_t CALIBRATION_VERIFICATION_NUMBER  = 0x06;
+const uint8_t ECU_NAME                         = 0x0A;
 
 
 //-------------------------------------------------------------------------------------//
@@ -282,10 +433,10 @@ const char * const WARM_START                 = "AT WS";       // General
 const char * const RESET_ALL                  = "AT Z";        // General
 
 
-const uint8_t responseBytes[0xA9] =
+constexpr uint8_t responseBytes[0xA9] =
 {
     4, 4, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 2, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 2,
-    4, 2, 2, 2, 4, 4, 4, 4, 4, 4, 4, 4, 4, 1, 1, 1, 1, 1, 2, 2, 4, 4, 4, 4, 4, 4, 4, 4, 2, 2, 2, 2,
+    4, 2, 2, 2, 4, 4, 4, 4, 4, 4, 4, 4, 1, 1, 1, 1, 1, 2, 2, 1, 4, 4, 4, 4, 4, 4, 4, 4, 2, 2, 2, 2,
     4, 4, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 4, 4, 1, 1, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 2, 2, 1,
     4, 1, 1, 2, 5, 2, 5, 3, 3, 7, 5, 5, 5, 11, 9, 3, 10, 6, 5, 5, 5, 7, 7, 5, 9, 9, 7, 7, 9, 1, 1, 13,  
     4, 41, 41, 9, 1, 10, 5, 5, 13, 41, 41, 7, 17, 1, 1, 7, 3, 5, 2, 3, 12, 9, 9, 6, 4, 17, 4, 2, 9